@@ -9,13 +9,29 @@
 #include "adm.h"
 
 // Private structure
+typedef struct _adm_cache {
+    char      path[1024];
+    uint32_t  hash;           // FNV-1a of the file content
+    uint32_t  nb;
+    uint32_t  na;
+    ADMData   data;
+    int       owner;          // Data was read for this entry, otherwise it is borrowed from an earlier entry of the same content
+    int       ref;            // Number of tables using the data
+} ADMCache;
+
 typedef struct _adm_mem {
     char data_path[1024];
     ADMTable table[256];
     int count;
+    ADMCache cache[ADM_MAX_CACHE];
+    int cache_count;
 } ADMMem;
 
 // Private functions
+uint32_t ADM_hash(uint32_t hash, const void *data, const size_t size);
+ADMCache *ADM_cache_get(ADMMem *h, const char *fullpath);
+int ADM_data_equal(const ADMData *a, const ADMData *b, const size_t nn);
+void ADM_free_data(ADMData *data);
 void ADM_show_blk(const char *prefix, const char *posfix);
 void ADM_show_row(const char *prefix, const char *posfix, const float *f, const int n);
 void ADM_show_slice(const float *values, const int nb, const int na);
@@ -85,7 +101,13 @@ ADMHandle ADM_init_with_path(const char *path) {
     int file_ret;
     int found_dir = 0;
     
-    for (int i = 0; i < sizeof(search_paths) / sizeof(search_paths[0]); i++) {
+    // The shared table bundle replaces the search
+    if (TBL_file_size(TBL_BUNDLE_ROOT "/adm/" ADMConfigSquarePlate ".adm") > 0) {
+        dat_path = TBL_BUNDLE_ROOT;
+        found_dir = 1;
+    }
+    
+    for (int i = 0; i < sizeof(search_paths) / sizeof(search_paths[0]) && !found_dir; i++) {
         dat_path = search_paths[i];
         snprintf(dat_file_path, 1024, "%s/adm/%s.adm", dat_path, ADMConfigSquarePlate);
         dir_ret = stat(dat_path, &path_stat);
@@ -121,6 +143,7 @@ ADMHandle ADM_init_with_path(const char *path) {
     
     // No table has been loaded yet
     h->count = 0;
+    h->cache_count = 0;
     
     return (ADMHandle *)h;
 }
@@ -133,33 +156,76 @@ ADMHandle ADM_init(void) {
 
 void ADM_free(ADMHandle i) {
     ADMMem *h = (ADMMem *)i;
-    for (int i = 0; i < h->count; i++) {
-        // Free each table that has been allocated previously
-        ADMTable *table = &h->table[i];
-        free(table->data.a);
-        free(table->data.b);
-        free(table->data.cdx);
-        free(table->data.cdy);
-        free(table->data.cdz);
-        free(table->data.cmx);
-        free(table->data.cmy);
-        free(table->data.cmz);
+    for (int i = 0; i < h->cache_count; i++) {
+        // Free each physical table that has been read previously
+        if (h->cache[i].owner) {
+            ADM_free_data(&h->cache[i].data);
+        }
     }
     free(h);
 }
 
 
-ADMTable *ADM_get_table(const ADMHandle in, const ADMConfig config) {
-    ADMMem *h = (ADMMem *)in;
+void ADM_free_data(ADMData *data) {
+    free(data->a);
+    free(data->b);
+    free(data->cdx);
+    free(data->cdy);
+    free(data->cdz);
+    free(data->cmx);
+    free(data->cmy);
+    free(data->cmz);
+    memset(data, 0, sizeof(ADMData));
+}
+
+
+uint32_t ADM_hash(uint32_t hash, const void *data, const size_t size) {
+    const uint8_t *c = (const uint8_t *)data;
+    for (size_t k = 0; k < size; k++) {
+        hash = (hash ^ c[k]) * 16777619u;
+    }
+    return hash;
+}
+
+
+// The hash only shortlists, the content decides
+int ADM_data_equal(const ADMData *a, const ADMData *b, const size_t nn) {
+    const size_t size = nn * sizeof(float);
+    return !memcmp(a->cdx, b->cdx, size) && !memcmp(a->cdy, b->cdy, size) && !memcmp(a->cdz, b->cdz, size) &&
+           !memcmp(a->cmx, b->cmx, size) && !memcmp(a->cmy, b->cmy, size) && !memcmp(a->cmz, b->cmz, size);
+}
+
+
+// Physical table of a file, read only once per path and shared by every file of the same content
+ADMCache *ADM_cache_get(ADMMem *h, const char *fullpath) {
     
     int i;
     
-    // Full path of the data
-    char fullpath[1024];
-    snprintf(fullpath, sizeof(fullpath), "%s/adm/%s.adm", h->data_path, config);
+    for (i = 0; i < h->cache_count; i++) {
+        if (h->cache[i].data.cdx != NULL && !strcmp(h->cache[i].path, fullpath)) {
+            return &h->cache[i];
+        }
+    }
+    
+    // Reuse an entry that has been released
+    ADMCache *cache = NULL;
+    for (i = 0; i < h->cache_count; i++) {
+        if (h->cache[i].data.cdx == NULL) {
+            cache = &h->cache[i];
+            break;
+        }
+    }
+    if (cache == NULL) {
+        if (h->cache_count >= ADM_MAX_CACHE) {
+            fprintf(stderr, "Too many ADM tables.\n");
+            return NULL;
+        }
+        cache = &h->cache[h->cache_count++];
+        memset(cache, 0, sizeof(ADMCache));
+    }
 
     // Now, we open the file
-    FILE *fid = fopen(fullpath, "r");
+    FILE *fid = TBL_fopen(fullpath);
     if (fid == NULL) {
         fprintf(stderr, "Error opening file %s.\n", fullpath);
         return NULL;
@@ -169,49 +235,105 @@ ADMTable *ADM_get_table(const ADMHandle in, const ADMConfig config) {
     uint16_t nbna[2];
     fread(nbna, sizeof(uint16_t), 2, fid);
     
-    // Get the table pointer from the handler
-    ADMTable *table = &h->table[h->count];
-    
     // Populate the dimension details
-    table->nb = nbna[0];  // x-axis = beta
-    table->na = nbna[1];  // y-axis = alpha
-    table->nn = table->na * table->nb;
-    if (table->nn == 0) {
+    const uint32_t nb = nbna[0];  // x-axis = beta
+    const uint32_t na = nbna[1];  // y-axis = alpha
+    const uint32_t nn = na * nb;
+    if (nn == 0) {
         fprintf(stderr, "None of the grid elements can be zero.\n");
         fclose(fid);
         return NULL;
     }
     
     // Allocate the space needed
-    table->data.b = (float *)malloc(table->nb * sizeof(float));
-    table->data.a = (float *)malloc(table->na * sizeof(float));
-    table->data.cdx = (float *)malloc(table->nn * sizeof(float));
-    table->data.cdy = (float *)malloc(table->nn * sizeof(float));
-    table->data.cdz = (float *)malloc(table->nn * sizeof(float));
-    table->data.cmx = (float *)malloc(table->nn * sizeof(float));
-    table->data.cmy = (float *)malloc(table->nn * sizeof(float));
-    table->data.cmz = (float *)malloc(table->nn * sizeof(float));
+    ADMData data;
+    data.b = (float *)malloc(nb * sizeof(float));
+    data.a = (float *)malloc(na * sizeof(float));
+    data.cdx = (float *)malloc(nn * sizeof(float));
+    data.cdy = (float *)malloc(nn * sizeof(float));
+    data.cdz = (float *)malloc(nn * sizeof(float));
+    data.cmx = (float *)malloc(nn * sizeof(float));
+    data.cmy = (float *)malloc(nn * sizeof(float));
+    data.cmz = (float *)malloc(nn * sizeof(float));
 
     // Fill in with values
-    snprintf(table->name, 1024, "%s", config);
-    snprintf(table->path, 1024, "%s", fullpath);
-    for (i = 0; i < table->nb; i++) {
-        table->data.b[i] = (float)i / (float)(table->nb - 1) * 360.0f - 180.0f;
+    for (i = 0; i < nb; i++) {
+        data.b[i] = (float)i / (float)(nb - 1) * 360.0f - 180.0f;
     }
-    for (i = 0; i < table->na; i++) {
-        table->data.a[i] = (float)i / (float)(table->na - 1) * 180.0f;
+    for (i = 0; i < na; i++) {
+        data.a[i] = (float)i / (float)(na - 1) * 180.0f;
     }
-    fread(table->data.cdx, sizeof(float), table->nn, fid);
-    fread(table->data.cdy, sizeof(float), table->nn, fid);
-    fread(table->data.cdz, sizeof(float), table->nn, fid);
-    fread(table->data.cmx, sizeof(float), table->nn, fid);
-    fread(table->data.cmy, sizeof(float), table->nn, fid);
-    fread(table->data.cmz, sizeof(float), table->nn, fid);
-    
-    h->count++;
+    fread(data.cdx, sizeof(float), nn, fid);
+    fread(data.cdy, sizeof(float), nn, fid);
+    fread(data.cdz, sizeof(float), nn, fid);
+    fread(data.cmx, sizeof(float), nn, fid);
+    fread(data.cmy, sizeof(float), nn, fid);
+    fread(data.cmz, sizeof(float), nn, fid);
     
     fclose(fid);
     
+    uint32_t hash = ADM_hash(2166136261u, nbna, sizeof(nbna));
+    hash = ADM_hash(hash, data.cdx, nn * sizeof(float));
+    hash = ADM_hash(hash, data.cdy, nn * sizeof(float));
+    hash = ADM_hash(hash, data.cdz, nn * sizeof(float));
+    hash = ADM_hash(hash, data.cmx, nn * sizeof(float));
+    hash = ADM_hash(hash, data.cmy, nn * sizeof(float));
+    hash = ADM_hash(hash, data.cmz, nn * sizeof(float));
+    
+    snprintf(cache->path, sizeof(cache->path), "%s", fullpath);
+    cache->hash = hash;
+    cache->nb = nb;
+    cache->na = na;
+    cache->ref = 0;
+    
+    // Same content under a different path, borrow the data of the earlier entry
+    for (i = 0; i < h->cache_count; i++) {
+        ADMCache *c = &h->cache[i];
+        if (c != cache && c->owner && c->hash == hash && c->nb == nb && c->na == na && ADM_data_equal(&c->data, &data, nn)) {
+            ADM_free_data(&data);
+            cache->data = c->data;
+            cache->owner = 0;
+            return cache;
+        }
+    }
+    cache->data = data;
+    cache->owner = 1;
+    
+    return cache;
+}
+
+
+ADMTable *ADM_get_table(const ADMHandle in, const ADMConfig config) {
+    ADMMem *h = (ADMMem *)in;
+    
+    if (h->count >= sizeof(h->table) / sizeof(ADMTable)) {
+        fprintf(stderr, "Too many ADM tables.\n");
+        return NULL;
+    }
+    
+    // Full path of the data
+    char fullpath[1024];
+    snprintf(fullpath, sizeof(fullpath), "%s/adm/%s.adm", h->data_path, config);
+
+    ADMCache *cache = ADM_cache_get(h, fullpath);
+    if (cache == NULL) {
+        return NULL;
+    }
+    
+    // Get the table pointer from the handler, the physical table is shared, only the description is per table
+    ADMTable *table = &h->table[h->count];
+    
+    table->nb = cache->nb;
+    table->na = cache->na;
+    table->nn = table->na * table->nb;
+    table->hash = cache->hash;
+    table->data = cache->data;
+    snprintf(table->name, 1024, "%s", config);
+    snprintf(table->path, 1024, "%s", fullpath);
+
+    cache->ref++;
+    h->count++;
+    
     // Physical description (dimension in m, density in kg/m^3)
     table->phys.x = 0.002f;
     table->phys.y = 0.040f;
@@ -225,6 +347,43 @@ ADMTable *ADM_get_table(const ADMHandle in, const ADMConfig config) {
 }
 
 
+// Tables are only released once, the physical table goes away when no other table uses it
+void ADM_release_table(const ADMHandle in, ADMTable *T) {
+    ADMMem *h = (ADMMem *)in;
+    
+    int i, ref = 0;
+    ADMCache *owner = NULL;
+    
+    if (T == NULL || T->data.cdx == NULL) {
+        return;
+    }
+    for (i = 0; i < h->cache_count; i++) {
+        ADMCache *c = &h->cache[i];
+        if (c->data.cdx != T->data.cdx) {
+            continue;
+        }
+        if (c->ref > 0 && !strcmp(c->path, T->path)) {
+            c->ref--;
+        }
+        if (c->owner) {
+            owner = c;
+        }
+        ref += c->ref;
+    }
+    if (ref == 0 && owner != NULL) {
+        const float *cdx = owner->data.cdx;
+        ADM_free_data(&owner->data);
+        for (i = 0; i < h->cache_count; i++) {
+            if (h->cache[i].data.cdx == cdx) {
+                memset(&h->cache[i].data, 0, sizeof(ADMData));
+            }
+        }
+        owner->owner = 0;
+    }
+    memset(&T->data, 0, sizeof(ADMData));
+}
+
+
 char *ADM_data_path(const ADMHandle i) {
     ADMMem *h = (ADMMem * )i;
     return h->data_path;
@@ -18,11 +18,14 @@
 #include <sys/types.h>
 
 #include "log.h"
+#include "tbl.h"
 
 #define ADMConfigModelPlate        "plate"
 #define ADMConfigSquarePlate       "square_plate"
 #define ADMConfigRoofTile          "roof_tile"
 
+#define ADM_MAX_CACHE              64
+
 typedef void * ADMHandle;
 typedef char * ADMConfig;
 
@@ -62,7 +65,8 @@ typedef struct _adm_table {
     uint32_t  na;              // Number of cells in alpha direction
     uint32_t  nn;              // Number of cells in all directions combined
     ADMBase   phys;            // Physical description of the debris
-    ADMData   data;
+    ADMData   data;            // Shared by all the tables of the same content, see ADM_release_table()
+    uint32_t  hash;            // Content hash of the physical table
     char      name[1024];
     char      path[1024];
 } ADMTable;
@@ -72,6 +76,7 @@ ADMHandle ADM_init(void);
 void ADM_free(ADMHandle);
 
 ADMTable *ADM_get_table(const ADMHandle, const ADMConfig config);
+void ADM_release_table(const ADMHandle, ADMTable *);
 char *ADM_data_path(const ADMHandle);
 
 void ADM_show_table_summary(const ADMTable *);
@@ -0,0 +1,602 @@
+//
+//  iq.c
+//  Radar Simulation Framework
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#include "iq.h"
+
+#define IQ_INDEX_GROW      4096
+#define IQ_LZ_HASH_BITS    14
+#define IQ_LZ_MIN_MATCH    4
+#define IQ_LZ_MAX_OFFSET   65535
+
+// Private structure
+
+typedef struct _iq_mem {
+    FILE          *fid;
+    bool          writing;
+    IQFileHeader  header;
+    size_t        pulse_size;         // Pulse header + range_count gates of (hi, hq, vi, vq)
+    size_t        chunk_size;         // Raw size of a full chunk
+    uint32_t      pulse_capacity;
+    IQPulseIndex  *pulse_index;
+    uint32_t      chunk_capacity;
+    IQChunkIndex  *chunk_index;
+    char          *chunk_buffer;      // Chunk being filled (writer) or the last decoded chunk (reader)
+    char          *work_buffer;       // Chunk being written by the background thread
+    uint8_t       *shuffle_buffer;
+    uint8_t       *packed_buffer;
+    uint32_t      chunk_fill;         // Number of pulses in chunk_buffer
+    int           chunk_id;           // Chunk in chunk_buffer of the reader
+    off_t         offset;             // Current write position
+    pthread_t     tid;
+    bool          busy;               // Background thread is writing work_buffer
+    int           error;
+} IQMem;
+
+// Private functions
+int IQ_flush_chunk(IQMem *h);
+void *IQ_write_chunk(void *in);
+void IQ_shuffle(uint8_t *dst, const uint8_t *src, const size_t n);
+void IQ_unshuffle(uint8_t *dst, const uint8_t *src, const size_t n);
+size_t IQ_lz_encode(uint8_t *dst, const uint8_t *src, const size_t n);
+int IQ_lz_decode(uint8_t *dst, const size_t m, const uint8_t *src, const size_t n);
+
+#pragma mark -
+#pragma mark Codec
+
+// Group byte b of every 4-byte word together, exponents and signs of nearby samples become runs
+void IQ_shuffle(uint8_t *dst, const uint8_t *src, const size_t n) {
+    const size_t w = n / 4;
+    for (size_t i = 0; i < w; i++) {
+        dst[i]         = src[4 * i];
+        dst[w + i]     = src[4 * i + 1];
+        dst[2 * w + i] = src[4 * i + 2];
+        dst[3 * w + i] = src[4 * i + 3];
+    }
+}
+
+void IQ_unshuffle(uint8_t *dst, const uint8_t *src, const size_t n) {
+    const size_t w = n / 4;
+    for (size_t i = 0; i < w; i++) {
+        dst[4 * i]     = src[i];
+        dst[4 * i + 1] = src[w + i];
+        dst[4 * i + 2] = src[2 * w + i];
+        dst[4 * i + 3] = src[3 * w + i];
+    }
+}
+
+static size_t IQ_lz_put_length(uint8_t *dst, size_t o, size_t len) {
+    while (len >= 255) {
+        dst[o++] = 255;
+        len -= 255;
+    }
+    dst[o++] = (uint8_t)len;
+    return o;
+}
+
+// Sequence: token (literal count << 4 | match length - 4), extra literal count, literals,
+// 16-bit offset, extra match length. The last sequence only has literals.
+// The output needs n + n / 255 + 16 bytes in the worst case.
+size_t IQ_lz_encode(uint8_t *dst, const uint8_t *src, const size_t n) {
+    uint32_t *table = (uint32_t *)calloc(1 << IQ_LZ_HASH_BITS, sizeof(uint32_t));
+    size_t i = 0, anchor = 0, o = 0, ref, len, lit;
+    uint32_t seq, hash;
+    while (table && i + IQ_LZ_MIN_MATCH <= n) {
+        memcpy(&seq, src + i, sizeof(seq));
+        hash = (seq * 2654435761u) >> (32 - IQ_LZ_HASH_BITS);
+        ref = table[hash];
+        table[hash] = (uint32_t)i + 1;
+        if (ref == 0 || i - (ref - 1) > IQ_LZ_MAX_OFFSET || memcmp(src + ref - 1, src + i, IQ_LZ_MIN_MATCH)) {
+            i++;
+            continue;
+        }
+        ref--;
+        len = IQ_LZ_MIN_MATCH;
+        while (i + len < n && src[ref + len] == src[i + len]) {
+            len++;
+        }
+        lit = i - anchor;
+        dst[o++] = (uint8_t)((lit < 15 ? lit : 15) << 4 | (len - IQ_LZ_MIN_MATCH < 15 ? len - IQ_LZ_MIN_MATCH : 15));
+        if (lit >= 15) {
+            o = IQ_lz_put_length(dst, o, lit - 15);
+        }
+        memcpy(dst + o, src + anchor, lit);
+        o += lit;
+        dst[o++] = (uint8_t)((i - ref) & 0xff);
+        dst[o++] = (uint8_t)((i - ref) >> 8);
+        if (len - IQ_LZ_MIN_MATCH >= 15) {
+            o = IQ_lz_put_length(dst, o, len - IQ_LZ_MIN_MATCH - 15);
+        }
+        i += len;
+        anchor = i;
+    }
+    free(table);
+    lit = n - anchor;
+    dst[o++] = (uint8_t)((lit < 15 ? lit : 15) << 4);
+    if (lit >= 15) {
+        o = IQ_lz_put_length(dst, o, lit - 15);
+    }
+    memcpy(dst + o, src + anchor, lit);
+    o += lit;
+    return o;
+}
+
+// Returns 0 only if exactly m bytes were decoded
+int IQ_lz_decode(uint8_t *dst, const size_t m, const uint8_t *src, const size_t n) {
+    size_t i = 0, o = 0, len, off, k;
+    uint8_t token, b;
+    while (i < n) {
+        token = src[i++];
+        len = token >> 4;
+        if (len == 15) {
+            do {
+                if (i >= n) {
+                    return -1;
+                }
+                b = src[i++];
+                len += b;
+            } while (b == 255);
+        }
+        if (i + len > n || o + len > m) {
+            return -1;
+        }
+        memcpy(dst + o, src + i, len);
+        i += len;
+        o += len;
+        if (i == n) {
+            break;
+        }
+        if (i + 2 > n) {
+            return -1;
+        }
+        off = (size_t)src[i] | (size_t)src[i + 1] << 8;
+        i += 2;
+        if (off == 0 || off > o) {
+            return -1;
+        }
+        len = token & 0x0f;
+        if (len == 15) {
+            do {
+                if (i >= n) {
+                    return -1;
+                }
+                b = src[i++];
+                len += b;
+            } while (b == 255);
+        }
+        len += IQ_LZ_MIN_MATCH;
+        if (o + len > m) {
+            return -1;
+        }
+        // Byte by byte since the match may overlap with itself
+        for (k = 0; k < len; k++) {
+            dst[o + k] = dst[o - off + k];
+        }
+        o += len;
+    }
+    return o == m ? 0 : -1;
+}
+
+#pragma mark -
+#pragma mark Writer
+
+IQHandle IQ_create(const char *filename, const IQFileHeader *header, const uint32_t chunk_pulses) {
+    IQMem *h = (IQMem *)malloc(sizeof(IQMem));
+    if (h == NULL) {
+        fprintf(stderr, "Unable to allocate resources for IQ file.\n");
+        return NULL;
+    }
+    memset(h, 0, sizeof(IQMem));
+
+    h->header = *header;
+    memcpy(h->header.magic, IQ_FILE_MAGIC, sizeof(h->header.magic));
+    h->header.version = IQ_FILE_VERSION;
+    if (h->header.range_count == 0) {
+        h->header.range_count = h->header.params.range_count;
+    }
+    h->header.pulse_count = 0;
+    h->header.index_offset = 0;
+    h->header.chunk_pulses = chunk_pulses;
+    h->header.chunk_count = 0;
+    // Compression works on chunks
+    if (h->header.compression != IQCompressionNone && chunk_pulses == 0) {
+        h->header.chunk_pulses = IQ_DEFAULT_CHUNK_PULSES;
+    }
+    h->pulse_size = sizeof(IQPulseHeader) + h->header.range_count * 4 * sizeof(float);
+    h->chunk_size = h->header.chunk_pulses * h->pulse_size;
+
+    if (h->header.chunk_pulses > 0) {
+        h->chunk_buffer = (char *)malloc(h->chunk_size);
+        h->work_buffer = (char *)malloc(h->chunk_size);
+        if (h->header.compression != IQCompressionNone) {
+            h->shuffle_buffer = (uint8_t *)malloc(h->chunk_size);
+            h->packed_buffer = (uint8_t *)malloc(h->chunk_size + h->chunk_size / 255 + 16);
+        }
+        if (h->chunk_buffer == NULL || h->work_buffer == NULL ||
+            (h->header.compression != IQCompressionNone && (h->shuffle_buffer == NULL || h->packed_buffer == NULL))) {
+            fprintf(stderr, "Unable to allocate a chunk of %u pulses.\n", h->header.chunk_pulses);
+            IQ_close(h);
+            return NULL;
+        }
+    }
+
+    h->fid = fopen(filename, "wb");
+    if (h->fid == NULL) {
+        fprintf(stderr, "Error creating file %s.\n", filename);
+        IQ_close(h);
+        return NULL;
+    }
+    h->writing = true;
+
+    // Placeholder header, rewritten with the final counts and index offset in IQ_close()
+    fwrite(&h->header, sizeof(IQFileHeader), 1, h->fid);
+    h->offset = sizeof(IQFileHeader);
+
+    return (IQHandle)h;
+}
+
+// Compress (if needed) and write the chunk in work_buffer, its index entry is already allocated
+void *IQ_write_chunk(void *in) {
+    IQMem *h = (IQMem *)in;
+    IQChunkIndex *c = &h->chunk_index[h->header.chunk_count];
+    const size_t raw_size = c->pulse_count * h->pulse_size;
+    const uint8_t *data = (uint8_t *)h->work_buffer;
+    c->size = raw_size;
+    if (h->header.compression == IQCompressionShuffleLZ) {
+        IQ_shuffle(h->shuffle_buffer, data, raw_size);
+        size_t size = IQ_lz_encode(h->packed_buffer, h->shuffle_buffer, raw_size);
+        // Keep the raw chunk if compression does not help
+        if (size < raw_size) {
+            data = h->packed_buffer;
+            c->size = size;
+        }
+    }
+    c->offset = h->offset;
+    if (fwrite(data, c->size, 1, h->fid) != 1) {
+        fprintf(stderr, "Error writing chunk %u.\n", h->header.chunk_count);
+        h->error = -1;
+    }
+    h->offset += c->size;
+    h->header.chunk_count++;
+    return NULL;
+}
+
+// Hand the filled chunk to the background thread, waiting for the previous one first
+int IQ_flush_chunk(IQMem *h) {
+    if (h->busy) {
+        pthread_join(h->tid, NULL);
+        h->busy = false;
+    }
+    if (h->chunk_fill == 0) {
+        return h->error;
+    }
+    if (h->header.chunk_count == h->chunk_capacity) {
+        h->chunk_capacity += IQ_INDEX_GROW;
+        IQChunkIndex *index = (IQChunkIndex *)realloc(h->chunk_index, h->chunk_capacity * sizeof(IQChunkIndex));
+        if (index == NULL) {
+            fprintf(stderr, "Unable to grow the chunk index.\n");
+            return -1;
+        }
+        h->chunk_index = index;
+    }
+    IQChunkIndex *c = &h->chunk_index[h->header.chunk_count];
+    c->first_pulse = h->header.pulse_count - h->chunk_fill;
+    c->pulse_count = h->chunk_fill;
+    char *tmp = h->work_buffer;
+    h->work_buffer = h->chunk_buffer;
+    h->chunk_buffer = tmp;
+    h->chunk_fill = 0;
+    if (pthread_create(&h->tid, NULL, IQ_write_chunk, h)) {
+        IQ_write_chunk(h);
+    } else {
+        h->busy = true;
+    }
+    return h->error;
+}
+
+int IQ_write_pulse(IQHandle i, const IQPulseHeader *pulse_header, const float *samples) {
+    IQMem *h = (IQMem *)i;
+    if (!h->writing) {
+        fprintf(stderr, "IQ file was not opened for writing.\n");
+        return -1;
+    }
+    if (h->header.pulse_count == h->pulse_capacity) {
+        h->pulse_capacity += IQ_INDEX_GROW;
+        IQPulseIndex *index = (IQPulseIndex *)realloc(h->pulse_index, h->pulse_capacity * sizeof(IQPulseIndex));
+        if (index == NULL) {
+            fprintf(stderr, "Unable to grow the pulse index.\n");
+            return -1;
+        }
+        h->pulse_index = index;
+    }
+    const size_t data_size = h->pulse_size - sizeof(IQPulseHeader);
+    IQPulseIndex *p = &h->pulse_index[h->header.pulse_count];
+    p->time = pulse_header->time;
+    p->el_deg = pulse_header->el_deg;
+    p->az_deg = pulse_header->az_deg;
+    p->chunk = h->header.chunk_pulses ? h->header.pulse_count / h->header.chunk_pulses : 0;
+    h->header.pulse_count++;
+    if (h->header.chunk_pulses == 0) {
+        // No chunking, straight to the file
+        p->offset = h->offset;
+        if (fwrite(pulse_header, sizeof(IQPulseHeader), 1, h->fid) != 1 ||
+            fwrite(samples, data_size, 1, h->fid) != 1) {
+            fprintf(stderr, "Error writing pulse %u.\n", h->header.pulse_count - 1);
+            return -1;
+        }
+        h->offset += h->pulse_size;
+        return 0;
+    }
+    // Offsets are known after the chunk is written, see IQ_close()
+    char *dst = h->chunk_buffer + h->chunk_fill * h->pulse_size;
+    memcpy(dst, pulse_header, sizeof(IQPulseHeader));
+    memcpy(dst + sizeof(IQPulseHeader), samples, data_size);
+    if (++h->chunk_fill == h->header.chunk_pulses) {
+        return IQ_flush_chunk(h);
+    }
+    return 0;
+}
+
+#pragma mark -
+#pragma mark Reader
+
+IQHandle IQ_open(const char *filename) {
+    IQMem *h = (IQMem *)malloc(sizeof(IQMem));
+    if (h == NULL) {
+        fprintf(stderr, "Unable to allocate resources for IQ file.\n");
+        return NULL;
+    }
+    memset(h, 0, sizeof(IQMem));
+    h->chunk_id = -1;
+
+    h->fid = fopen(filename, "rb");
+    if (h->fid == NULL) {
+        fprintf(stderr, "Error opening file %s.\n", filename);
+        free(h);
+        return NULL;
+    }
+    if (fread(&h->header, sizeof(IQFileHeader), 1, h->fid) != 1) {
+        fprintf(stderr, "Error reading file header of %s.\n", filename);
+        IQ_close(h);
+        return NULL;
+    }
+
+    uint32_t k;
+
+    if (memcmp(h->header.magic, IQ_FILE_MAGIC, sizeof(h->header.magic)) == 0) {
+        if (h->header.version > IQ_FILE_VERSION) {
+            fprintf(stderr, "Unsupported IQ file version %u.\n", h->header.version);
+            IQ_close(h);
+            return NULL;
+        }
+        if (h->header.compression > IQCompressionShuffleLZ) {
+            fprintf(stderr, "Unsupported IQ compression %u.\n", h->header.compression);
+            IQ_close(h);
+            return NULL;
+        }
+        h->pulse_size = sizeof(IQPulseHeader) + h->header.range_count * 4 * sizeof(float);
+        h->chunk_size = h->header.chunk_pulses * h->pulse_size;
+        h->pulse_index = (IQPulseIndex *)malloc(h->header.pulse_count * sizeof(IQPulseIndex) + 1);
+        h->chunk_index = (IQChunkIndex *)malloc(h->header.chunk_count * sizeof(IQChunkIndex) + 1);
+        if (h->pulse_index == NULL || h->chunk_index == NULL) {
+            fprintf(stderr, "Unable to allocate the pulse index.\n");
+            IQ_close(h);
+            return NULL;
+        }
+        if (fseeko(h->fid, (off_t)h->header.index_offset, SEEK_SET) ||
+            fread(h->pulse_index, sizeof(IQPulseIndex), h->header.pulse_count, h->fid) != h->header.pulse_count ||
+            fread(h->chunk_index, sizeof(IQChunkIndex), h->header.chunk_count, h->fid) != h->header.chunk_count) {
+            fprintf(stderr, "Error reading the pulse index of %s.\n", filename);
+            IQ_close(h);
+            return NULL;
+        }
+        if (h->header.compression != IQCompressionNone) {
+            h->chunk_buffer = (char *)malloc(h->chunk_size);
+            h->shuffle_buffer = (uint8_t *)malloc(h->chunk_size);
+            h->packed_buffer = (uint8_t *)malloc(h->chunk_size);
+            if (h->chunk_buffer == NULL || h->shuffle_buffer == NULL || h->packed_buffer == NULL) {
+                fprintf(stderr, "Unable to allocate a chunk of %u pulses.\n", h->header.chunk_pulses);
+                IQ_close(h);
+                return NULL;
+            }
+        }
+    } else {
+        // Version 0: no index, derive everything from range_count and the file size
+        memset(h->header.magic, 0, sizeof(h->header.magic));
+        h->header.version = 0;
+        h->header.range_count = h->header.params.range_count;
+        h->header.chunk_pulses = 0;
+        h->header.chunk_count = 0;
+        h->header.compression = IQCompressionNone;
+        h->pulse_size = sizeof(IQPulseHeader) + h->header.range_count * 4 * sizeof(float);
+        fseeko(h->fid, 0, SEEK_END);
+        const off_t size = ftello(h->fid);
+        h->header.pulse_count = (uint32_t)((size - sizeof(IQFileHeader)) / h->pulse_size);
+        h->header.index_offset = size;
+        h->pulse_index = (IQPulseIndex *)malloc(h->header.pulse_count * sizeof(IQPulseIndex) + 1);
+        if (h->pulse_index == NULL) {
+            fprintf(stderr, "Unable to allocate the pulse index.\n");
+            IQ_close(h);
+            return NULL;
+        }
+        IQPulseHeader pulse_header;
+        for (k = 0; k < h->header.pulse_count; k++) {
+            IQPulseIndex *p = &h->pulse_index[k];
+            p->offset = sizeof(IQFileHeader) + (uint64_t)k * h->pulse_size;
+            p->chunk = 0;
+            if (fseeko(h->fid, (off_t)p->offset, SEEK_SET) || fread(&pulse_header, sizeof(IQPulseHeader), 1, h->fid) != 1) {
+                fprintf(stderr, "Error reading pulse header %u of %s.\n", k, filename);
+                IQ_close(h);
+                return NULL;
+            }
+            p->time = pulse_header.time;
+            p->el_deg = pulse_header.el_deg;
+            p->az_deg = pulse_header.az_deg;
+        }
+    }
+
+    return (IQHandle)h;
+}
+
+const IQFileHeader *IQ_get_header(const IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    return &h->header;
+}
+
+uint32_t IQ_get_version(const IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    return h->header.version;
+}
+
+uint32_t IQ_get_range_count(const IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    return h->header.range_count;
+}
+
+uint32_t IQ_get_pulse_count(const IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    return h->header.pulse_count;
+}
+
+uint32_t IQ_get_chunk_count(const IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    return h->header.chunk_count;
+}
+
+const IQPulseIndex *IQ_get_pulse_index(const IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    return h->pulse_index;
+}
+
+const IQChunkIndex *IQ_get_chunk_index(const IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    return h->chunk_index;
+}
+
+// Read pulse k, either output can be NULL; samples must hold range_count x (hi, hq, vi, vq)
+int IQ_read_pulse(IQHandle i, const uint32_t k, IQPulseHeader *pulse_header, float *samples) {
+    IQMem *h = (IQMem *)i;
+    if (h->writing || k >= h->header.pulse_count) {
+        fprintf(stderr, "Pulse %u is not available.\n", k);
+        return -1;
+    }
+    const IQPulseIndex *p = &h->pulse_index[k];
+    const IQChunkIndex *c = h->header.chunk_count ? &h->chunk_index[p->chunk] : NULL;
+    if (h->header.compression == IQCompressionNone || c->size == c->pulse_count * h->pulse_size) {
+        // Raw pulse, read in place
+        IQPulseHeader tmp;
+        const off_t offset = c ? c->offset + (k - c->first_pulse) * h->pulse_size : p->offset;
+        if (fseeko(h->fid, offset, SEEK_SET) ||
+            fread(&tmp, sizeof(IQPulseHeader), 1, h->fid) != 1) {
+            fprintf(stderr, "Error reading pulse %u.\n", k);
+            return -1;
+        }
+        if (pulse_header) {
+            *pulse_header = tmp;
+        }
+        if (samples && fread(samples, h->pulse_size - sizeof(IQPulseHeader), 1, h->fid) != 1) {
+            fprintf(stderr, "Error reading pulse %u.\n", k);
+            return -1;
+        }
+        return 0;
+    }
+    // Compressed chunk, decode it unless it is the one from the previous call
+    if (h->chunk_id != (int)p->chunk) {
+        const size_t raw_size = c->pulse_count * h->pulse_size;
+        if (c->size > h->chunk_size ||
+            fseeko(h->fid, (off_t)c->offset, SEEK_SET) ||
+            fread(h->packed_buffer, c->size, 1, h->fid) != 1 ||
+            IQ_lz_decode(h->shuffle_buffer, raw_size, h->packed_buffer, c->size)) {
+            fprintf(stderr, "Error decoding chunk %u.\n", p->chunk);
+            h->chunk_id = -1;
+            return -1;
+        }
+        IQ_unshuffle((uint8_t *)h->chunk_buffer, h->shuffle_buffer, raw_size);
+        h->chunk_id = (int)p->chunk;
+    }
+    const char *src = h->chunk_buffer + (k - c->first_pulse) * h->pulse_size;
+    if (pulse_header) {
+        memcpy(pulse_header, src, sizeof(IQPulseHeader));
+    }
+    if (samples) {
+        memcpy(samples, src + sizeof(IQPulseHeader), h->pulse_size - sizeof(IQPulseHeader));
+    }
+    return 0;
+}
+
+// First pulse at or after the given time, -1 if the time is beyond the last pulse
+int IQ_find_pulse_by_time(const IQHandle i, const float time) {
+    IQMem *h = (IQMem *)i;
+    uint32_t a = 0, b = h->header.pulse_count, c;
+    while (a < b) {
+        c = (a + b) / 2;
+        if (h->pulse_index[c].time < time) {
+            a = c + 1;
+        } else {
+            b = c;
+        }
+    }
+    return a < h->header.pulse_count ? (int)a : -1;
+}
+
+// Pulse with the closest azimuth, wrapped around 360 deg, -1 if there are no pulses
+int IQ_find_pulse_by_azimuth(const IQHandle i, const float az_deg) {
+    IQMem *h = (IQMem *)i;
+    int m = -1;
+    float d, d_min = 360.0f;
+    for (uint32_t k = 0; k < h->header.pulse_count; k++) {
+        d = fabsf(fmodf(h->pulse_index[k].az_deg - az_deg, 360.0f));
+        if (d > 180.0f) {
+            d = 360.0f - d;
+        }
+        if (d < d_min) {
+            d_min = d;
+            m = (int)k;
+        }
+    }
+    return m;
+}
+
+#pragma mark -
+
+void IQ_close(IQHandle i) {
+    IQMem *h = (IQMem *)i;
+    if (h == NULL) {
+        return;
+    }
+    if (h->writing && h->fid) {
+        IQ_flush_chunk(h);
+        if (h->busy) {
+            pthread_join(h->tid, NULL);
+            h->busy = false;
+        }
+        // Pulse offsets of the chunks, a compressed chunk can only be addressed as a whole
+        for (uint32_t c = 0; c < h->header.chunk_count; c++) {
+            const IQChunkIndex *chunk = &h->chunk_index[c];
+            const bool raw = chunk->size == chunk->pulse_count * h->pulse_size;
+            for (uint32_t k = 0; k < chunk->pulse_count; k++) {
+                h->pulse_index[chunk->first_pulse + k].offset = chunk->offset + (raw ? k * h->pulse_size : 0);
+            }
+        }
+        // Trailing index, then the final header
+        h->header.index_offset = h->offset;
+        fwrite(h->pulse_index, sizeof(IQPulseIndex), h->header.pulse_count, h->fid);
+        fwrite(h->chunk_index, sizeof(IQChunkIndex), h->header.chunk_count, h->fid);
+        rewind(h->fid);
+        fwrite(&h->header, sizeof(IQFileHeader), 1, h->fid);
+    }
+    if (h->fid) {
+        fclose(h->fid);
+    }
+    free(h->pulse_index);
+    free(h->chunk_index);
+    free(h->chunk_buffer);
+    free(h->work_buffer);
+    free(h->shuffle_buffer);
+    free(h->packed_buffer);
+    free(h);
+}
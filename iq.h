@@ -8,9 +8,33 @@
 #ifndef iq_h
 #define iq_h
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#include "log.h"
 #include "rs_types.h"
 #include "rs_const.h"
 
+#define IQ_FILE_MAGIC             "SRIQ"
+#define IQ_MOMENT_FILE_MAGIC      "SRMO"
+#define IQ_SPECTRUM_FILE_MAGIC    "SRSP"
+#define IQ_FILE_VERSION           2
+#define IQ_DEFAULT_CHUNK_PULSES   100
+
+typedef uint32_t IQCompression;
+enum IQCompression {
+    IQCompressionNone        = 0,                      // Raw float32
+    IQCompressionShuffleLZ   = 1                       // Byte shuffle + LZ77, per chunk
+};
+
+typedef void * IQHandle;
+
 // Basic structure of a complex sample
 typedef struct iq_complex {
     float i;
@@ -18,6 +42,7 @@ typedef struct iq_complex {
 } IQComplex;
 
 // Header of a raw file
+// Version 0 files (no magic) stop at simulation_seed, the rest are zeros
 typedef union fileheader {
     char      raw[1024];
     struct {
@@ -28,6 +53,18 @@ typedef union fileheader {
         float     scan_end;
         float     scan_delta;
         uint32_t  simulation_seed;
+        char      magic[4];                            // IQ_FILE_MAGIC
+        uint32_t  version;                             // Container version
+        uint32_t  range_count;                         // Number of gates in every pulse
+        uint64_t  index_offset;                        // Byte offset of the trailing pulse index
+        uint32_t  pulse_count;                         // Number of pulses
+        uint32_t  chunk_pulses;                        // Number of pulses per chunk, 0 = no chunking
+        uint32_t  chunk_count;                         // Number of chunks
+        uint32_t  debris_types[RS_MAX_DEBRIS_TYPES];   // OBJConfig of each entry in counts[]
+        uint32_t  compression;                         // IQCompression of the chunks
+        uint32_t  moment_dwell;                        // Pulses per radial of a moment file
+        uint32_t  fft_count;                           // Doppler bins of a spectrum file
+        uint32_t  fft_segments;                        // FFTs averaged per radial of a spectrum file
     };
 } IQFileHeader;
 
@@ -41,4 +78,41 @@ typedef union pulseheader {
     };
 } IQPulseHeader;
 
+// Pulse index entry, an array of pulse_count of these follows the data
+typedef struct iq_pulse_index {
+    float     time;
+    float     el_deg;
+    float     az_deg;
+    uint32_t  chunk;          // Chunk that contains this pulse
+    uint64_t  offset;         // Byte offset of the pulse header, or its chunk if compressed, from the beginning of the file
+} IQPulseIndex;
+
+// Chunk index entry, an array of chunk_count of these follows the pulse index
+typedef struct iq_chunk_index {
+    uint64_t  offset;         // Byte offset of the chunk from the beginning of the file
+    uint64_t  size;           // Stored size of the chunk in bytes, the chunk is raw if this equals pulse_count x pulse size
+    uint32_t  first_pulse;    // Index of the first pulse in the chunk
+    uint32_t  pulse_count;    // Number of pulses in the chunk
+} IQChunkIndex;
+
+// Writer, set header->compression to compress the chunks in a background thread
+IQHandle IQ_create(const char *filename, const IQFileHeader *header, const uint32_t chunk_pulses);
+int IQ_write_pulse(IQHandle, const IQPulseHeader *pulse_header, const float *samples);
+
+// Reader
+IQHandle IQ_open(const char *filename);
+const IQFileHeader *IQ_get_header(const IQHandle);
+uint32_t IQ_get_version(const IQHandle);
+uint32_t IQ_get_range_count(const IQHandle);
+uint32_t IQ_get_pulse_count(const IQHandle);
+uint32_t IQ_get_chunk_count(const IQHandle);
+const IQPulseIndex *IQ_get_pulse_index(const IQHandle);
+const IQChunkIndex *IQ_get_chunk_index(const IQHandle);
+int IQ_read_pulse(IQHandle, const uint32_t k, IQPulseHeader *pulse_header, float *samples);
+int IQ_find_pulse_by_time(const IQHandle, const float time);
+int IQ_find_pulse_by_azimuth(const IQHandle, const float az_deg);
+
+// Both
+void IQ_close(IQHandle);
+
 #endif /* iq_h */
@@ -102,7 +102,14 @@ LESHandle LES_init_with_config_path(const LESConfig config, const char *path) {
     int file_ret;
     int found_dir = 0;
 
-    for (int i = 0; i < sizeof(search_paths) / sizeof(search_paths[0]); i++) {
+    // The shared table bundle replaces the search
+    snprintf(les_file_path, 1024, "%s/les/%s/fort.10_2", TBL_BUNDLE_ROOT, config);
+    if (TBL_file_size(les_file_path) > 0) {
+        les_path = TBL_BUNDLE_ROOT;
+        found_dir = 1;
+    }
+
+    for (int i = 0; i < sizeof(search_paths) / sizeof(search_paths[0]) && !found_dir; i++) {
         les_path = search_paths[i];
         snprintf(les_file_path, 1024, "%s/les/%s/fort.10_2", les_path, config);
         dir_ret = stat(les_path, &path_stat);
@@ -213,12 +220,12 @@ LESHandle LES_init_with_config_path(const LESConfig config, const char *path) {
     k = 0;
     while (true) {
         snprintf(h->files[k], sizeof(h->files[k]), "%s/LES_mean_1_6_fnum%d.dat", h->data_path, k + 1);
-        if (access(h->files[k], F_OK) != -1) {
+        long file_size = TBL_file_size(h->files[k]);
+        if (file_size >= 0) {
             if (h->nfiles == 0) {
                 // Use the first file to derive the number of volumes in a file
-                file_ret = stat(h->files[k], &file_stat);
-                if (file_ret == 0) {
-                    size_t s = file_stat.st_size;
+                if (file_size > 0) {
+                    size_t s = file_size;
                     // 5 variables: u, v, w, p, t
                     size_t nn = h->enclosing_grid->nx * h->enclosing_grid->ny * h->enclosing_grid->nz * 5;
                     h->nvol = s / (LES_FRAME_TIME_STAMP_BYTES + LES_FRAME_PADDING_BYTES + nn * sizeof(float) + LES_FRAME_PADDING_BYTES);
@@ -359,7 +366,7 @@ void *LES_background_read(LESHandle i) {
          );
 
         // Derive filename to ingest a set of LESTables
-        FILE *fid = fopen(h->files[file_id], "r");
+        FILE *fid = TBL_fopen(h->files[file_id]);
         if (fid == NULL) {
             fprintf(stderr, "Error opening LES table file %s %d\n", h->files[file_id], file_id);
             return NULL;
@@ -481,7 +488,7 @@ LESGrid *LES_enclosing_grid_create_from_file(const char *filename) {
 		fprintf(stderr, "Unable to allocate LES grid.\n");
 		return NULL;
 	}
-	FILE *fid = fopen(filename, "r");
+	FILE *fid = TBL_fopen(filename);
 	if (fid == NULL) {
         free(grid);
 		return NULL;
@@ -20,6 +20,7 @@
 #include <pthread.h>
 
 #include "log.h"
+#include "tbl.h"
 
 #define LESConfigNull                  ""
 #define LESConfigFlat                  "flat"
@@ -102,7 +102,13 @@ int main(int argc, char **argv) {
         }
         f = fopen(filename, "r+");
         fread(&file_header, sizeof(file_header), 1, f);
-        printf("%s   %6s B   %d  (+%u)\n", filelist[k], commaint(file_stat.st_size), file_header.simulation_seed, file_header.simulation_seed - prev_seed);
+        if (memcmp(file_header.magic, IQ_FILE_MAGIC, sizeof(file_header.magic))) {
+            file_header.version = 0;
+            file_header.pulse_count = (uint32_t)((file_stat.st_size - sizeof(IQFileHeader)) / (sizeof(IQPulseHeader) + file_header.params.range_count * sizeof(cl_float4)));
+        }
+        printf("%s   %6s B   v%u%s  %6s pulses   %d  (+%u)\n", filelist[k], commaint(file_stat.st_size), file_header.version,
+               file_header.version > 1 && file_header.compression ? "z" : " ", commaint(file_header.pulse_count),
+               file_header.simulation_seed, file_header.simulation_seed - prev_seed);
 //        file_header.simulation_seed = k + 1825;
 //        rewind(f);
 //        fwrite(&file_header, sizeof(file_header), 1, f);
@@ -28,6 +28,15 @@ scan_mode = fread(fid, 16, 'char=>char');
 scan_mode = deblank(scan_mode.');
 tmpf2 = fread(fid, 3, 'float');
 tmpi2 = fread(fid, 1, 'uint');
+magic = fread(fid, 4, 'char=>char');
+tmpi3 = fread(fid, 2, 'uint');
+index_offset = fread(fid, 1, 'uint64');
+pulse_count = fread(fid, 1, 'uint');
+tmpi4 = fread(fid, 2 + 8 + 1, 'uint');
+if strcmp(magic.', 'SRIQ') && tmpi3(1) >= 2 && tmpi4(end) ~= 0
+    fclose(fid);
+    error('Compressed IQ file, use the C reader IQ_read_pulse() to decode.')
+end
 
 hdr = struct(...
     'c', tmpf(1), ...
@@ -65,10 +74,12 @@ hdr = struct(...
 fseek(fid, 0, 'eof');
 fsize = ftell(fid);
 
-% The I/Q data portion
-payload_size = fsize - 1024;
+% The I/Q data portion, version 1 files have a trailing pulse index
 pulse_size = 32 + hdr.range_count * 16;
-pulse_count = payload_size / pulse_size;
+if ~strcmp(magic.', 'SRIQ') || tmpi3(1) < 1
+    payload_size = fsize - 1024;
+    pulse_count = payload_size / pulse_size;
+end
 fprintf('Data file contains %d pulses. D = %.2f\n', pulse_count, hdr.body_per_cell);
 
 % Return to the end of file header
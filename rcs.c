@@ -9,13 +9,29 @@
 #include "rcs.h"
 
 // Private structure
+typedef struct _rcs_cache {
+    char      path[1024];
+    uint32_t  hash;           // FNV-1a of the file content
+    uint32_t  na;
+    uint32_t  nb;
+    RCSData   data;
+    int       owner;          // Data was read for this entry, otherwise it is borrowed from an earlier entry of the same content
+    int       ref;            // Number of tables using the data
+} RCSCache;
+
 typedef struct _rcs_mem {
     char data_path[1024];
     RCSTable table[256];
     int count;
+    RCSCache cache[RCS_MAX_CACHE];
+    int cache_count;
 } RCSMem;
 
 // Private functions
+uint32_t RCS_hash(uint32_t hash, const void *data, const size_t size);
+RCSCache *RCS_cache_get(RCSMem *h, const char *fullpath);
+int RCS_data_equal(const RCSData *a, const RCSData *b, const size_t nn);
+void RCS_free_data(RCSData *data);
 void RCS_show_blk(const char *prefix, const char *posfix);
 void RCS_show_row(const char *prefix, const char *posfix, const float *f, const int n);
 void RCS_show_slice(const float *values, const int na, const int nb);
@@ -120,7 +136,13 @@ RCSHandle RCS_init_with_path(const char *path) {
     int file_ret;
     int found_dir = 0;
     
-    for (int i = 0; i < sizeof(search_paths) / sizeof(search_paths[0]); i++) {
+    // The shared table bundle replaces the search
+    if (TBL_file_size(TBL_BUNDLE_ROOT "/rcs/" RCSConfigLeaf ".rcs") > 0) {
+        dat_path = TBL_BUNDLE_ROOT;
+        found_dir = 1;
+    }
+    
+    for (int i = 0; i < sizeof(search_paths) / sizeof(search_paths[0]) && !found_dir; i++) {
         dat_path = search_paths[i];
         snprintf(dat_file_path, 1024, "%s/rcs/%s.rcs", dat_path, RCSConfigLeaf);
         dir_ret = stat(dat_path, &path_stat);
@@ -156,39 +178,83 @@ RCSHandle RCS_init_with_path(const char *path) {
     
     // No table has been loaded yet
     h->count = 0;
+    h->cache_count = 0;
 
     return (RCSHandle *)h;
 }
 
 void RCS_free(RCSHandle i) {
     RCSMem *h = (RCSMem *)i;
-    for (int i=0; i<h->count; i++) {
-        // Free each table that has been allocated previously
-        RCSTable *table = &h->table[i];
-        free(table->data.a);
-        free(table->data.b);
-        free(table->data.hh_real);
-        free(table->data.vv_real);
-        free(table->data.hv_real);
-        free(table->data.hh_imag);
-        free(table->data.vv_imag);
-        free(table->data.hv_imag);
+    for (int i=0; i<h->cache_count; i++) {
+        // Free each physical table that has been read previously
+        if (h->cache[i].owner) {
+            RCS_free_data(&h->cache[i].data);
+        }
     }
     free(h);
 }
 
 
-RCSTable *RCS_get_table(const RCSHandle in, const RCSConfig config) {
-    RCSMem *h = (RCSMem *)in;
+void RCS_free_data(RCSData *data) {
+    free(data->a);
+    free(data->b);
+    free(data->hh_real);
+    free(data->vv_real);
+    free(data->hv_real);
+    free(data->hh_imag);
+    free(data->vv_imag);
+    free(data->hv_imag);
+    memset(data, 0, sizeof(RCSData));
+}
+
+
+uint32_t RCS_hash(uint32_t hash, const void *data, const size_t size) {
+    const uint8_t *c = (const uint8_t *)data;
+    for (size_t k = 0; k < size; k++) {
+        hash = (hash ^ c[k]) * 16777619u;
+    }
+    return hash;
+}
+
+
+// The hash only shortlists, the content decides
+int RCS_data_equal(const RCSData *a, const RCSData *b, const size_t nn) {
+    const size_t size = nn * sizeof(float);
+    return !memcmp(a->hh_real, b->hh_real, size) && !memcmp(a->vv_real, b->vv_real, size) && !memcmp(a->hv_real, b->hv_real, size) &&
+           !memcmp(a->hh_imag, b->hh_imag, size) && !memcmp(a->vv_imag, b->vv_imag, size) && !memcmp(a->hv_imag, b->hv_imag, size);
+}
+
+
+// Physical table of a file, read only once per path and shared by every file of the same content
+RCSCache *RCS_cache_get(RCSMem *h, const char *fullpath) {
     
     int i;
-
-    // Full path of the data file
-    char fullpath[1024];
-    snprintf(fullpath, sizeof(fullpath), "%s/rcs/%s.rcs", h->data_path, config);
+    
+    for (i = 0; i < h->cache_count; i++) {
+        if (h->cache[i].data.hh_real != NULL && !strcmp(h->cache[i].path, fullpath)) {
+            return &h->cache[i];
+        }
+    }
+    
+    // Reuse an entry that has been released
+    RCSCache *cache = NULL;
+    for (i = 0; i < h->cache_count; i++) {
+        if (h->cache[i].data.hh_real == NULL) {
+            cache = &h->cache[i];
+            break;
+        }
+    }
+    if (cache == NULL) {
+        if (h->cache_count >= RCS_MAX_CACHE) {
+            fprintf(stderr, "Too many RCS tables.\n");
+            return NULL;
+        }
+        cache = &h->cache[h->cache_count++];
+        memset(cache, 0, sizeof(RCSCache));
+    }
     
     // Now, we open the file for reading
-    FILE *fid = fopen(fullpath, "r");
+    FILE *fid = TBL_fopen(fullpath);
     if (fid == NULL) {
         fprintf(stderr, "Error opening file %s.\n", fullpath);
         return NULL;
@@ -198,54 +264,147 @@ RCSTable *RCS_get_table(const RCSHandle in, const RCSConfig config) {
     uint16_t nbna[2];
     fread(nbna, sizeof(uint16_t), 2, fid);
     
-    // Get the table pointer from the handler
-    RCSTable *table = &h->table[h->count];
-    
     // Populate the dimension details
-    table->na = nbna[0];  // x-axis = alpha
-    table->nb = nbna[1];  // y-axis = beta
-    table->nn = table->na * table->nb;
-    if (h->table->nn == 0) {
+    const uint32_t na = nbna[0];  // x-axis = alpha
+    const uint32_t nb = nbna[1];  // y-axis = beta
+    const uint32_t nn = na * nb;
+    if (nn == 0) {
         fprintf(stderr, "Empty table (RCSTable)?\n");
         fclose(fid);
         return NULL;
     }
-    table->lambda = 0.1f;
 
     // Allocate the space needed
-    table->data.a = (float *)malloc(table->na * sizeof(float));
-    table->data.b = (float *)malloc(table->nb * sizeof(float));
-    table->data.hh_real = (float *)malloc(table->nn * sizeof(float));
-    table->data.vv_real = (float *)malloc(table->nn * sizeof(float));
-    table->data.hv_real = (float *)malloc(table->nn * sizeof(float));
-    table->data.hh_imag = (float *)malloc(table->nn * sizeof(float));
-    table->data.vv_imag = (float *)malloc(table->nn * sizeof(float));
-    table->data.hv_imag = (float *)malloc(table->nn * sizeof(float));
+    RCSData data;
+    data.a = (float *)malloc(na * sizeof(float));
+    data.b = (float *)malloc(nb * sizeof(float));
+    data.hh_real = (float *)malloc(nn * sizeof(float));
+    data.vv_real = (float *)malloc(nn * sizeof(float));
+    data.hv_real = (float *)malloc(nn * sizeof(float));
+    data.hh_imag = (float *)malloc(nn * sizeof(float));
+    data.vv_imag = (float *)malloc(nn * sizeof(float));
+    data.hv_imag = (float *)malloc(nn * sizeof(float));
     
     // Fill in the table
-    snprintf(table->name, 1024, "%s", config);
-    snprintf(table->path, 1024, "%s", fullpath);
-    for (i=0; i<table->na; i++) {
-        table->data.a[i] = (float)i / (float)(table->na - 1) * 360.0f - 180.0f;
+    for (i=0; i<na; i++) {
+        data.a[i] = (float)i / (float)(na - 1) * 360.0f - 180.0f;
     }
-    for (i=0; i<table->nb; i++) {
-        table->data.b[i] = (float)i / (float)(table->nb - 1) * 180.0f;
+    for (i=0; i<nb; i++) {
+        data.b[i] = (float)i / (float)(nb - 1) * 180.0f;
     }
-    fread(table->data.hh_real, sizeof(float), table->nn, fid);
-    fread(table->data.vv_real, sizeof(float), table->nn, fid);
-    fread(table->data.hv_real, sizeof(float), table->nn, fid);
-    fread(table->data.hh_imag, sizeof(float), table->nn, fid);
-    fread(table->data.vv_imag, sizeof(float), table->nn, fid);
-    fread(table->data.hv_imag, sizeof(float), table->nn, fid);
+    fread(data.hh_real, sizeof(float), nn, fid);
+    fread(data.vv_real, sizeof(float), nn, fid);
+    fread(data.hv_real, sizeof(float), nn, fid);
+    fread(data.hh_imag, sizeof(float), nn, fid);
+    fread(data.vv_imag, sizeof(float), nn, fid);
+    fread(data.hv_imag, sizeof(float), nn, fid);
     
-    h->count++;
-
     fclose(fid);
     
+    uint32_t hash = RCS_hash(2166136261u, nbna, sizeof(nbna));
+    hash = RCS_hash(hash, data.hh_real, nn * sizeof(float));
+    hash = RCS_hash(hash, data.vv_real, nn * sizeof(float));
+    hash = RCS_hash(hash, data.hv_real, nn * sizeof(float));
+    hash = RCS_hash(hash, data.hh_imag, nn * sizeof(float));
+    hash = RCS_hash(hash, data.vv_imag, nn * sizeof(float));
+    hash = RCS_hash(hash, data.hv_imag, nn * sizeof(float));
+    
+    snprintf(cache->path, sizeof(cache->path), "%s", fullpath);
+    cache->hash = hash;
+    cache->na = na;
+    cache->nb = nb;
+    cache->ref = 0;
+    
+    // Same content under a different path, borrow the data of the earlier entry
+    for (i = 0; i < h->cache_count; i++) {
+        RCSCache *c = &h->cache[i];
+        if (c != cache && c->owner && c->hash == hash && c->na == na && c->nb == nb && RCS_data_equal(&c->data, &data, nn)) {
+            RCS_free_data(&data);
+            cache->data = c->data;
+            cache->owner = 0;
+            return cache;
+        }
+    }
+    cache->data = data;
+    cache->owner = 1;
+    
+    return cache;
+}
+
+
+RCSTable *RCS_get_table(const RCSHandle in, const RCSConfig config) {
+    RCSMem *h = (RCSMem *)in;
+    
+    if (h->count >= sizeof(h->table) / sizeof(RCSTable)) {
+        fprintf(stderr, "Too many RCS tables.\n");
+        return NULL;
+    }
+
+    // Full path of the data file
+    char fullpath[1024];
+    snprintf(fullpath, sizeof(fullpath), "%s/rcs/%s.rcs", h->data_path, config);
+    
+    RCSCache *cache = RCS_cache_get(h, fullpath);
+    if (cache == NULL) {
+        return NULL;
+    }
+    
+    // Get the table pointer from the handler, the physical table is shared, only the description is per table
+    RCSTable *table = &h->table[h->count];
+    
+    table->na = cache->na;
+    table->nb = cache->nb;
+    table->nn = table->na * table->nb;
+    table->hash = cache->hash;
+    table->data = cache->data;
+    table->lambda = 0.1f;
+    snprintf(table->name, 1024, "%s", config);
+    snprintf(table->path, 1024, "%s", fullpath);
+    
+    cache->ref++;
+    h->count++;
+    
     return table;
 }
 
 
+// Tables are only released once, the physical table goes away when no other table uses it
+void RCS_release_table(const RCSHandle in, RCSTable *T) {
+    RCSMem *h = (RCSMem *)in;
+    
+    int i, ref = 0;
+    RCSCache *owner = NULL;
+    
+    if (T == NULL || T->data.hh_real == NULL) {
+        return;
+    }
+    for (i = 0; i < h->cache_count; i++) {
+        RCSCache *c = &h->cache[i];
+        if (c->data.hh_real != T->data.hh_real) {
+            continue;
+        }
+        if (c->ref > 0 && !strcmp(c->path, T->path)) {
+            c->ref--;
+        }
+        if (c->owner) {
+            owner = c;
+        }
+        ref += c->ref;
+    }
+    if (ref == 0 && owner != NULL) {
+        const float *hh_real = owner->data.hh_real;
+        RCS_free_data(&owner->data);
+        for (i = 0; i < h->cache_count; i++) {
+            if (h->cache[i].data.hh_real == hh_real) {
+                memset(&h->cache[i].data, 0, sizeof(RCSData));
+            }
+        }
+        owner->owner = 0;
+    }
+    memset(&T->data, 0, sizeof(RCSData));
+}
+
+
 char *RCS_data_path(const RCSHandle i) {
     RCSMem *h = (RCSMem *)i;
     return h->data_path;
@@ -18,6 +18,7 @@
 #include <sys/types.h>
 
 #include "log.h"
+#include "tbl.h"
 
 #define RCSConfigLeaf              "leaf"
 #define RCSConfigPlate             "plate"
@@ -25,6 +26,8 @@
 #define RCSConfigWoodBoard         "woodboard"
 #define RCSConfigWoodBoardDish     "woodboardish"
 
+#define RCS_MAX_CACHE              64
+
 typedef void * RCSHandle;
 typedef char * RCSConfig;
 
@@ -43,7 +46,8 @@ typedef struct _rcs_table {
     uint32_t  na;             // Number of cells in alpha direction
     uint32_t  nb;             // Number of cells in beta direction
     uint32_t  nn;             // Number of cells in all directions combined
-    RCSData   data;
+    RCSData   data;           // Shared by all the tables of the same content, see RCS_release_table()
+    uint32_t  hash;           // Content hash of the physical table
     char      name[1024];
     char      path[1024];
     float     lambda;
@@ -54,6 +58,7 @@ RCSHandle RCS_init(void);
 void RCS_free(RCSHandle);
 
 RCSTable *RCS_get_table(const RCSHandle, const RCSConfig config);
+void RCS_release_table(const RCSHandle, RCSTable *);
 char *RCS_data_path(const RCSHandle);
 
 void RCS_show_table_summary(const RCSTable *);
@@ -25,7 +25,7 @@
         rsprint("ERROR: Could not create OpenCL kernel.  ret = %d\n", ret);   \
         clReleaseProgram(C->prog);                                            \
         clReleaseContext(C->context);                                         \
-        return;                                                               \
+        return 1;                                                             \
 }
 
 #define CHECK_CL_CREATE_BUFFER                                       \
@@ -91,6 +91,18 @@ void pfn_notify(const char *errinfo, const void *private_info, size_t cb, void *
 }
 
 
+static cl_uint vendor_from_name(const char *name) {
+    if (strcasestr(name, "intel")) {
+        return RS_GPU_VENDOR_INTEL;
+    } else if (strcasestr(name, "nvidia")) {
+        return RS_GPU_VENDOR_NVIDIA;
+    } else if (strcasestr(name, "amd")) {
+        return RS_GPU_VENDOR_AMD;
+    }
+    return RS_GPU_VENDOR_UNKNOWN;
+}
+
+
 // CL_DEVICE_TYPE_GPU
 void get_device_info(cl_device_type device_type, cl_uint *num_devices, cl_device_id *devices, cl_uint *num_cus, cl_uint *vendors, cl_int detail_level) {
     
@@ -107,7 +119,7 @@ void get_device_info(cl_device_type device_type, cl_uint *num_devices, cl_device
     cl_ulong buf_ulong;
     
     int s = 0;
-    char str[RS_MAX_STR];
+    char str[RS_MAX_STR] = "";
 
     CL_CHECK(clGetPlatformIDs(RS_MAX_GPU_PLATFORM, platforms, &num_platforms));
     
@@ -166,15 +178,7 @@ void get_device_info(cl_device_type device_type, cl_uint *num_devices, cl_device
                 CL_CHECK(clGetDeviceInfo(devices[j], CL_DEVICE_NAME, RS_MAX_STR, buf_char, NULL));
                 s += snprintf(str + s, RS_MAX_STR, "        - " RS_FMT " = %s\n", "CL_DEVICE_NAME", buf_char);
                 CL_CHECK(clGetDeviceInfo(devices[j], CL_DEVICE_VENDOR, RS_MAX_STR, buf_char, NULL));
-                if (strcasestr(buf_char, "intel")) {
-                    vendors[j] = RS_GPU_VENDOR_INTEL;
-                } else if (strcasestr(buf_char, "nvidia")) {
-                    vendors[j] = RS_GPU_VENDOR_NVIDIA;
-                } else if (strcasestr(buf_char, "amd")) {
-                    vendors[j] = RS_GPU_VENDOR_AMD;
-                } else {
-                    vendors[j] = RS_GPU_VENDOR_UNKNOWN;
-                }
+                vendors[j] = vendor_from_name(buf_char);
                 s += snprintf(str + s, RS_MAX_STR, "        - " RS_FMT " = %s (%d)\n", "CL_DEVICE_VENDOR", buf_char, vendors[j]);
                 CL_CHECK(clGetDeviceInfo(devices[j], CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(buf_ulong), &buf_ulong, NULL));
                 s += snprintf(str + s, RS_MAX_STR, "        - " RS_FMT " = %s B\n", "CL_DEVICE_GLOBAL_MEM_SIZE", commaint(buf_ulong));
@@ -214,14 +218,38 @@ void get_device_info(cl_device_type device_type, cl_uint *num_devices, cl_device
                 }
             } // for (; j < platform_num_devices; j++)
         } else {
-            for (; j < platform_num_devices; j++)
+            for (; j < platform_num_devices; j++) {
+                CL_CHECK(clGetDeviceInfo(devices[j], CL_DEVICE_VENDOR, RS_MAX_STR, buf_char, NULL));
+                vendors[j] = vendor_from_name(buf_char);
                 CL_CHECK(clGetDeviceInfo(devices[j], CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(buf_uint), &num_cus[j], NULL));
+            }
         }
     } // for (; i < num_platforms; i++)
     printf("%s", str);
 }
 
 
+// Rough single precision throughput of a device: compute units x clock x SIMD lanes
+float get_device_throughput(cl_device_id device) {
+    
+    cl_device_type type = CL_DEVICE_TYPE_GPU;
+    cl_uint num_cus = 1;
+    cl_uint clock_mhz = 1000;
+    cl_uint lanes = 64;
+    
+    clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(type), &type, NULL);
+    clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(num_cus), &num_cus, NULL);
+    clGetDeviceInfo(device, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(clock_mhz), &clock_mhz, NULL);
+    
+    // GPU compute units are SIMD processors of (at least) 64 lanes; a CPU compute unit is a core with its vector unit
+    if (type & CL_DEVICE_TYPE_CPU) {
+        clGetDeviceInfo(device, CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT, sizeof(lanes), &lanes, NULL);
+    }
+    
+    return (float)num_cus * (float)MAX(1, clock_mhz) * (float)MAX(1, lanes);
+}
+
+
 cl_uint read_kernel_source_from_files(char *src_ptr[], ...) {
     
     static char char_buf[RS_MAX_KERNEL_SRC] = "";
@@ -380,6 +408,111 @@ float zdr(cl_float4 x) {
 #pragma mark -
 #pragma mark Private Functions
 
+#if !defined (_USE_GCL_)
+
+int RS_worker_create_kernels(RSWorker *C) {
+    
+    cl_int ret;
+    
+    C->kern_io = clCreateKernel(C->prog, "io", &ret);                                             CHECK_CL_CREATE_KERNEL
+    C->kern_dummy = clCreateKernel(C->prog, "dummy", &ret);                                       CHECK_CL_CREATE_KERNEL
+    C->kern_db_rcs = clCreateKernel(C->prog, "db_rcs", &ret);                                     CHECK_CL_CREATE_KERNEL
+    C->kern_bg_atts = clCreateKernel(C->prog, "bg_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
+    C->kern_fp_atts = clCreateKernel(C->prog, "fp_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
+    C->kern_el_atts = clCreateKernel(C->prog, "el_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
+    C->kern_el_rcs = clCreateKernel(C->prog, "el_rcs", &ret);                                     CHECK_CL_CREATE_KERNEL
+    C->kern_db_atts = clCreateKernel(C->prog, "db_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
+    C->kern_kin_atts = clCreateKernel(C->prog, "kin_atts", &ret);                                 CHECK_CL_CREATE_KERNEL
+    C->kern_scat_pop = clCreateKernel(C->prog, "scat_pop", &ret);                                 CHECK_CL_CREATE_KERNEL
+    C->kern_scat_gather = clCreateKernel(C->prog, "scat_gather", &ret);                           CHECK_CL_CREATE_KERNEL
+    C->kern_scat_clr = clCreateKernel(C->prog, "scat_clr", &ret);                                 CHECK_CL_CREATE_KERNEL
+    C->kern_scat_sig_aux = clCreateKernel(C->prog, "scat_sig_aux", &ret);                         CHECK_CL_CREATE_KERNEL
+    C->kern_make_pulse_pass_1 = clCreateKernel(C->prog, "make_pulse_pass_1", &ret);               CHECK_CL_CREATE_KERNEL
+    C->kern_make_pulse_pass_1_tiled = clCreateKernel(C->prog, "make_pulse_pass_1_tiled", &ret);   CHECK_CL_CREATE_KERNEL
+    C->kern_make_pulse_pass_2_group = clCreateKernel(C->prog, "make_pulse_pass_2_group", &ret);   CHECK_CL_CREATE_KERNEL
+    C->kern_make_pulse_pass_2_local = clCreateKernel(C->prog, "make_pulse_pass_2_range", &ret);   CHECK_CL_CREATE_KERNEL
+    C->kern_make_pulse_pass_2_range = clCreateKernel(C->prog, "make_pulse_pass_2_local", &ret);   CHECK_CL_CREATE_KERNEL
+    C->kern_moment_acc = clCreateKernel(C->prog, "moment_acc", &ret);                             CHECK_CL_CREATE_KERNEL
+    C->kern_bg_emu = clCreateKernel(C->prog, "bg_emu", &ret);                                     CHECK_CL_CREATE_KERNEL
+    C->kern_make_pulse_pass_2 = C->kern_make_pulse_pass_2_group;
+    
+    return 0;
+}
+
+
+void RS_worker_release_kernels(RSWorker *C) {
+    clReleaseKernel(C->kern_io);
+    clReleaseKernel(C->kern_dummy);
+    clReleaseKernel(C->kern_db_rcs);
+    clReleaseKernel(C->kern_bg_atts);
+    clReleaseKernel(C->kern_fp_atts);
+    clReleaseKernel(C->kern_el_atts);
+    clReleaseKernel(C->kern_el_rcs);
+    clReleaseKernel(C->kern_db_atts);
+    clReleaseKernel(C->kern_kin_atts);
+    clReleaseKernel(C->kern_scat_pop);
+    clReleaseKernel(C->kern_scat_gather);
+    clReleaseKernel(C->kern_scat_clr);
+    clReleaseKernel(C->kern_scat_sig_aux);
+    clReleaseKernel(C->kern_make_pulse_pass_1);
+    clReleaseKernel(C->kern_make_pulse_pass_1_tiled);
+    clReleaseKernel(C->kern_make_pulse_pass_2_group);
+    clReleaseKernel(C->kern_make_pulse_pass_2_local);
+    clReleaseKernel(C->kern_make_pulse_pass_2_range);
+    clReleaseKernel(C->kern_moment_acc);
+    clReleaseKernel(C->kern_bg_emu);
+}
+
+
+// A weight table wider than the 1-D images of a worker brings the worker back to buffers: the program is rebuilt
+// without RS_USE_WEIGHT_IMAGES and the table made earlier as an image is recreated as a buffer from the host copy
+int RS_worker_fit_weight_table(RSHandle *H, const int worker_id, const unsigned int table_size) {
+    
+    cl_int ret;
+    RSWorker *C = &H->workers[worker_id];
+    
+    if (!C->weight_images || table_size <= C->weight_image_max) {
+        return 0;
+    }
+    if (H->status & RSStatusDomainPopulated) {
+        rsprint("ERROR: Weight table of %u exceeds the 1-D image width %zu of worker[%d] after population.", table_size, C->weight_image_max, worker_id);
+        return 1;
+    }
+    rsprint("WARNING: Weight table of %u exceeds the 1-D image width %zu of worker[%d], rebuilding with buffers.", table_size, C->weight_image_max, worker_id);
+    
+    RS_worker_release_kernels(C);
+    ret = clBuildProgram(C->prog, 1, &C->dev, C->program_options, NULL, NULL);
+    if (ret != CL_SUCCESS) {
+        char char_buf[RS_MAX_STR] = "";
+        clGetProgramBuildInfo(C->prog, C->dev, CL_PROGRAM_BUILD_LOG, RS_MAX_STR, char_buf, NULL);
+        fprintf(stderr, "%s : RS : ERROR: CL Compilation failed:\n%s", now(), char_buf);
+        exit(EXIT_FAILURE);
+    }
+    C->weight_images = 0;
+    if (RS_worker_create_kernels(C)) {
+        exit(EXIT_FAILURE);
+    }
+    
+    const size_t shrink = sizeof(cl_float4) - sizeof(cl_float);
+    if (C->range_weight != NULL && H->range_weight.data != NULL) {
+        const unsigned int n = (unsigned int)(H->range_weight.xm + 1.0f);
+        clReleaseMemObject(C->range_weight);
+        C->range_weight = RS_create_weight_table(C, H->range_weight.data, n, &ret);
+        C->mem_usage -= (cl_uint)(n * shrink);
+    }
+    if (C->angular_weight != NULL && H->angular_weight.data != NULL) {
+        const unsigned int n = (unsigned int)(H->angular_weight.xm + 1.0f);
+        clReleaseMemObject(C->angular_weight);
+        C->angular_weight = RS_create_weight_table(C, H->angular_weight.data, n, &ret);
+        C->mem_usage -= (cl_uint)(n * shrink);
+    }
+    
+    return 0;
+}
+
+#endif
+
+
 void RS_worker_init(RSWorker *C, cl_device_id dev, cl_uint src_size, const char **src_ptr, cl_context_properties sharegroup, const char verb) {
     
     C->dev = dev;
@@ -470,13 +603,66 @@ void RS_worker_init(RSWorker *C, cl_device_id dev, cl_uint src_size, const char
         clReleaseContext(C->context);
         exit(EXIT_FAILURE);
     }
+    
+    // Subgroup reductions in the make_pulse kernels when the device has them, the barrier ladders otherwise
+    char options[64] = "";
+    size_t extensions_size = 0;
+    clGetDeviceInfo(C->dev, CL_DEVICE_EXTENSIONS, 0, NULL, &extensions_size);
+    char *extensions = (char *)malloc(extensions_size + 1);
+    if (extensions) {
+        extensions[0] = '\0';
+        clGetDeviceInfo(C->dev, CL_DEVICE_EXTENSIONS, extensions_size, extensions, NULL);
+        extensions[extensions_size] = '\0';
+        if (strstr(extensions, "cl_intel_subgroups")) {
+            snprintf(options, sizeof(options), "-DRS_USE_SUBGROUPS=2");
+        } else if (strstr(extensions, "cl_khr_subgroups")) {
+            snprintf(options, sizeof(options), "-DRS_USE_SUBGROUPS=1 -cl-std=CL2.0");
+        }
+        free(extensions);
+    }
+    
+    // Range and angular weights as 1-D images so that the sampler does the interpolation, see RS_create_weight_table().
+    // The headers only tell what the host knows, the device must be OpenCL 1.2 for CL_MEM_OBJECT_IMAGE1D. The width
+    // of a 1-D image is bound by CL_DEVICE_IMAGE2D_MAX_WIDTH, checked against each table in RS_worker_fit_weight_table()
+    char weight_option[32] = "";
+    C->weight_images = 0;
+    C->weight_image_max = 0;
+#if defined (CL_VERSION_1_2)
+    int major = 0, minor = 0;
+    char version[256] = "";
+    cl_bool image_support = CL_FALSE;
+    clGetDeviceInfo(C->dev, CL_DEVICE_VERSION, sizeof(version), version, NULL);
+    clGetDeviceInfo(C->dev, CL_DEVICE_IMAGE_SUPPORT, sizeof(cl_bool), &image_support, NULL);
+    clGetDeviceInfo(C->dev, CL_DEVICE_IMAGE2D_MAX_WIDTH, sizeof(size_t), &C->weight_image_max, NULL);
+    if (sscanf(version, "OpenCL %d.%d", &major, &minor) == 2 && (major > 1 || minor >= 2) &&
+        image_support == CL_TRUE && C->weight_image_max > 0) {
+        C->weight_images = 1;
+        snprintf(weight_option, sizeof(weight_option), "-DRS_USE_WEIGHT_IMAGES");
+    } else if (verb > 1) {
+        rsprint("Weight tables of worker[%d] are buffers (%s, image support %d).", (int)C->name, version, image_support);
+    }
+#endif
+    
+    char build_options[128];
+    snprintf(build_options, sizeof(build_options), "%s %s", options, weight_option);
+    
     if (verb) {
-        rsprint("clBuildProgram() ... worker[%d]", (int)C->name);
-        ret = clBuildProgram(C->prog, 1, &C->dev, "", &pfn_prog_notify, NULL);
+        rsprint("clBuildProgram() ... worker[%d] %s", (int)C->name, build_options);
+        ret = clBuildProgram(C->prog, 1, &C->dev, build_options, &pfn_prog_notify, NULL);
     } else {
-        ret = clBuildProgram(C->prog, 1, &C->dev, "", NULL, NULL);
+        ret = clBuildProgram(C->prog, 1, &C->dev, build_options, NULL, NULL);
     }
     
+    // Some drivers advertise the extension but cannot build with it
+    if (ret != CL_SUCCESS && strlen(options)) {
+        rsprint("WARNING: Unable to build with subgroups (%s), falling back to local memory reductions.", options);
+        options[0] = '\0';
+        ret = clBuildProgram(C->prog, 1, &C->dev, weight_option, NULL, NULL);
+    }
+    
+    // Kept for a rebuild without the weight images
+    snprintf(C->program_options, sizeof(C->program_options), "%s", options);
+    
     if (ret != CL_SUCCESS) {
         char char_buf[RS_MAX_STR] = "";
         clGetProgramBuildInfo(C->prog, C->dev, CL_PROGRAM_BUILD_LOG, RS_MAX_STR, char_buf, NULL);
@@ -489,20 +675,9 @@ void RS_worker_init(RSWorker *C, cl_device_id dev, cl_uint src_size, const char
     }
     
     // Tie all kernels to the program
-    C->kern_io = clCreateKernel(C->prog, "io", &ret);                                             CHECK_CL_CREATE_KERNEL
-    C->kern_dummy = clCreateKernel(C->prog, "dummy", &ret);                                       CHECK_CL_CREATE_KERNEL
-    C->kern_db_rcs = clCreateKernel(C->prog, "db_rcs", &ret);                                     CHECK_CL_CREATE_KERNEL
-    C->kern_bg_atts = clCreateKernel(C->prog, "bg_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
-    C->kern_fp_atts = clCreateKernel(C->prog, "fp_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
-    C->kern_el_atts = clCreateKernel(C->prog, "el_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
-    C->kern_db_atts = clCreateKernel(C->prog, "db_atts", &ret);                                   CHECK_CL_CREATE_KERNEL
-    C->kern_scat_clr = clCreateKernel(C->prog, "scat_clr", &ret);                                 CHECK_CL_CREATE_KERNEL
-    C->kern_scat_sig_aux = clCreateKernel(C->prog, "scat_sig_aux", &ret);                         CHECK_CL_CREATE_KERNEL
-    C->kern_make_pulse_pass_1 = clCreateKernel(C->prog, "make_pulse_pass_1", &ret);               CHECK_CL_CREATE_KERNEL
-    C->kern_make_pulse_pass_2_group = clCreateKernel(C->prog, "make_pulse_pass_2_group", &ret);   CHECK_CL_CREATE_KERNEL
-    C->kern_make_pulse_pass_2_local = clCreateKernel(C->prog, "make_pulse_pass_2_range", &ret);   CHECK_CL_CREATE_KERNEL
-    C->kern_make_pulse_pass_2_range = clCreateKernel(C->prog, "make_pulse_pass_2_local", &ret);   CHECK_CL_CREATE_KERNEL
-    C->kern_make_pulse_pass_2 = C->kern_make_pulse_pass_2_group;
+    if (RS_worker_create_kernels(C)) {
+        return;
+    }
     
     if (verb > 1) {
         rsprint("Kernels for program[%d] created.\n", (int)C->name);
@@ -552,19 +727,7 @@ void RS_worker_free(RSWorker *C) {
     
     clReleaseCommandQueue(C->que);
     
-    clReleaseKernel(C->kern_io);
-    clReleaseKernel(C->kern_dummy);
-    clReleaseKernel(C->kern_db_rcs);
-    clReleaseKernel(C->kern_bg_atts);
-    clReleaseKernel(C->kern_fp_atts);
-    clReleaseKernel(C->kern_el_atts);
-    clReleaseKernel(C->kern_db_atts);
-    clReleaseKernel(C->kern_scat_clr);
-    clReleaseKernel(C->kern_scat_sig_aux);
-    clReleaseKernel(C->kern_make_pulse_pass_1);
-    clReleaseKernel(C->kern_make_pulse_pass_2_group);
-    clReleaseKernel(C->kern_make_pulse_pass_2_local);
-    clReleaseKernel(C->kern_make_pulse_pass_2_range);
+    RS_worker_release_kernels(C);
     
     clReleaseProgram(C->prog);
     
@@ -590,7 +753,7 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     }
     
     // Derive the necessary parameters from host to compute workers
-    if (C->num_scats != H->num_scats / MAX(1, H->num_workers)) {
+    if (C->num_scats == 0 || H->offset[worker_id] + C->num_scats > H->num_scats) {
         rsprint("ERROR: Inconsistent number of scatterers.\n");
         return;
     }
@@ -628,7 +791,8 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
                                                 H->params.range_delta,
                                                 H->params.range_count);
     
-    const unsigned long work_numel = C->make_pulse_params.global[0] * C->make_pulse_params.local[0] * H->params.range_count;
+    // Pass 1 leaves range_count partial sums per group, twice that covers the pairwise reads of pass 2
+    const unsigned long work_numel = 2 * MAX(1, C->make_pulse_params.group_counts[0]) * H->params.range_count;
     
 #if defined (_USE_GCL_)
     
@@ -653,13 +817,38 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     C->scat_tum = gcl_malloc(C->num_scats * sizeof(cl_float4), NULL, 0);
     C->scat_aux = gcl_malloc(C->num_scats * sizeof(cl_float4), NULL, 0);
     C->scat_rcs = gcl_malloc(C->num_scats * sizeof(cl_float4), NULL, 0);
+    // Debris only, they follow the background scatterers
+    C->rcq_numel = H->rcs_tolerance > 0.0f ? MAX(C->num_scats - C->counts[0], 1) : 1;
+    cl_float4 *rcq_zeros = (cl_float4 *)calloc(C->rcq_numel, sizeof(cl_float4));
+    C->scat_rcq = gcl_malloc(C->rcq_numel * sizeof(cl_float4), rcq_zeros, CL_MEM_COPY_HOST_PTR);
+    free(rcq_zeros);
     C->scat_sig = gcl_malloc(C->num_scats * sizeof(cl_float4), NULL, 0);
     C->work = gcl_malloc(work_numel * sizeof(cl_float4), NULL, 0);
     C->pulse = gcl_malloc(H->params.range_count * sizeof(cl_float4), NULL, 0);
+    C->moment_acc = gcl_malloc(3 * H->params.range_count * sizeof(cl_float4), NULL, 0);
     
     C->scat_rnd = gcl_malloc(C->num_scats * sizeof(cl_int4), NULL, 0);
     
-    C->mem_size += (8 * C->num_scats + work_numel + H->params.range_count) * sizeof(cl_float4) + C->num_scats * sizeof(cl_uint4);
+    // A single element stands in when the placement is uniform
+    const size_t placement_numel = H->placement_grid ? H->placement_grid * H->placement_grid * H->placement_grid : 1;
+    const cl_float2 placement_uniform = {{1.0f, 1.0f}};
+    C->placement = gcl_malloc(placement_numel * sizeof(cl_float2), H->placement ? (void *)H->placement : (void *)&placement_uniform, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR);
+    
+    C->mem_size += (8 * C->num_scats + C->rcq_numel + work_numel + 4 * H->params.range_count) * sizeof(cl_float4) + C->num_scats * sizeof(cl_uint4) + placement_numel * sizeof(cl_float2);
+    
+    // The emulated background is added to the pulse of the first worker only
+    if (worker_id == 0 && H->bg_emulator) {
+        cl_float4 *state = (cl_float4 *)calloc(H->params.range_count, sizeof(cl_float4));
+        cl_uint4 *seed = (cl_uint4 *)malloc(H->params.range_count * sizeof(cl_uint4));
+        for (unsigned int k = 0; k < H->params.range_count; k++) {
+            seed[k] = (cl_uint4){{rand() | 1, rand() | 1, rand() | 1, rand() | 1}};
+        }
+        C->emulator_state = gcl_malloc(H->params.range_count * sizeof(cl_float4), state, CL_MEM_COPY_HOST_PTR);
+        C->emulator_seed = gcl_malloc(H->params.range_count * sizeof(cl_uint4), seed, CL_MEM_COPY_HOST_PTR);
+        free(state);
+        free(seed);
+        C->mem_size += H->params.range_count * (sizeof(cl_float4) + sizeof(cl_uint4));
+    }
     
 #else
     
@@ -689,20 +878,44 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     C->scat_tum = clCreateBuffer(C->context, CL_MEM_READ_WRITE, numel * sizeof(cl_float4), NULL, &ret);                      CHECK_CL_CREATE_BUFFER
     C->scat_aux = clCreateBuffer(C->context, CL_MEM_READ_WRITE, numel * sizeof(cl_float4), NULL, &ret);                      CHECK_CL_CREATE_BUFFER
     C->scat_rcs = clCreateBuffer(C->context, CL_MEM_READ_WRITE, numel * sizeof(cl_float4), NULL, &ret);                      CHECK_CL_CREATE_BUFFER
+    // Debris only, they follow the background scatterers
+    C->rcq_numel = H->rcs_tolerance > 0.0f ? MAX(C->num_scats - C->counts[0], 1) : 1;
+    C->scat_rcq = clCreateBuffer(C->context, CL_MEM_READ_WRITE, C->rcq_numel * sizeof(cl_float4), NULL, &ret);               CHECK_CL_CREATE_BUFFER
     C->scat_sig = clCreateBuffer(C->context, CL_MEM_READ_WRITE, numel * sizeof(cl_float4), NULL, &ret);                      CHECK_CL_CREATE_BUFFER
     C->scat_rnd = clCreateBuffer(C->context, CL_MEM_READ_WRITE, numel * sizeof(cl_int4), NULL, &ret);                        CHECK_CL_CREATE_BUFFER
     C->work     = clCreateBuffer(C->context, CL_MEM_READ_WRITE, work_numel * sizeof(cl_float4), NULL, &ret);                 CHECK_CL_CREATE_BUFFER
     C->pulse    = clCreateBuffer(C->context, CL_MEM_READ_WRITE, H->params.range_count * sizeof(cl_float4), NULL, &ret);      CHECK_CL_CREATE_BUFFER
+    C->moment_acc = clCreateBuffer(C->context, CL_MEM_READ_WRITE, 3 * H->params.range_count * sizeof(cl_float4), NULL, &ret); CHECK_CL_CREATE_BUFFER
+    
+    // A single element stands in when the placement is uniform
+    const size_t placement_numel = H->placement_grid ? H->placement_grid * H->placement_grid * H->placement_grid : 1;
+    const cl_float2 placement_uniform = {{1.0f, 1.0f}};
+    C->placement = clCreateBuffer(C->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, placement_numel * sizeof(cl_float2), H->placement ? (void *)H->placement : (void *)&placement_uniform, &ret); CHECK_CL_CREATE_BUFFER
     
     // Set some components to zero
     cl_float4 *zeros = (cl_float4 *)malloc(numel * sizeof(cl_float4));
     memset(zeros, 0, numel * sizeof(cl_float4));
     clEnqueueWriteBuffer(C->que, C->scat_aux, CL_TRUE, 0, numel * sizeof(cl_float4), zeros, 0, NULL, NULL);
     clEnqueueWriteBuffer(C->que, C->scat_rcs, CL_TRUE, 0, numel * sizeof(cl_float4), zeros, 0, NULL, NULL);
+    clEnqueueWriteBuffer(C->que, C->scat_rcq, CL_TRUE, 0, C->rcq_numel * sizeof(cl_float4), zeros, 0, NULL, NULL);
     clEnqueueWriteBuffer(C->que, C->scat_sig, CL_TRUE, 0, numel * sizeof(cl_float4), zeros, 0, NULL, NULL);
     free(zeros);
     
-    C->mem_usage += (8 * numel + work_numel + H->params.range_count) * sizeof(cl_float4) + numel * sizeof(cl_uint4);
+    C->mem_usage += (8 * numel + C->rcq_numel + work_numel + 4 * H->params.range_count) * sizeof(cl_float4) + numel * sizeof(cl_uint4) + placement_numel * sizeof(cl_float2);
+    
+    // The emulated background is added to the pulse of the first worker only
+    if (worker_id == 0 && H->bg_emulator) {
+        cl_float4 *state = (cl_float4 *)calloc(H->params.range_count, sizeof(cl_float4));
+        cl_uint4 *seed = (cl_uint4 *)malloc(H->params.range_count * sizeof(cl_uint4));
+        for (unsigned int k = 0; k < H->params.range_count; k++) {
+            seed[k] = (cl_uint4){{rand() | 1, rand() | 1, rand() | 1, rand() | 1}};
+        }
+        C->emulator_state = clCreateBuffer(C->context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, H->params.range_count * sizeof(cl_float4), state, &ret); CHECK_CL_CREATE_BUFFER
+        C->emulator_seed = clCreateBuffer(C->context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, H->params.range_count * sizeof(cl_uint4), seed, &ret);    CHECK_CL_CREATE_BUFFER
+        free(state);
+        free(seed);
+        C->mem_usage += H->params.range_count * (sizeof(cl_float4) + sizeof(cl_uint4));
+    }
     
     //
     // Set up kernel's input / output arguments
@@ -722,12 +935,18 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
         exit(EXIT_FAILURE);
     }
     
+    // The RCS cache starts at the first debris
+    const cl_uint rcq_origin = (cl_uint)C->counts[0];
+    
     ret = CL_SUCCESS;
     ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentPosition,                      sizeof(cl_mem),     &C->scat_pos);
     ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentOrientation,                   sizeof(cl_mem),     &C->scat_ori);
     ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSection,             sizeof(cl_mem),     &C->scat_rcs);
+    ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionCache,        sizeof(cl_mem),     &C->scat_rcq);
+    ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionCacheOrigin,  sizeof(cl_uint),    &rcq_origin);
     ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionReal,         sizeof(cl_mem),     &C->rcs_real[0]);
     ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionImag,         sizeof(cl_mem),     &C->rcs_imag[0]);
+    ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionGamma,        sizeof(cl_mem),     &C->rcs_gamma[0]);
     ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionDescription,  sizeof(cl_float16), &C->rcs_desc[0]);
     ret |= clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentSimulationDescription,         sizeof(cl_float16), &H->sim_desc);
     if (ret != CL_SUCCESS) {
@@ -745,6 +964,9 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     ret |= clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentBackgroundDescription,         sizeof(cl_float16), &C->les_desc);
     ret |= clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentEllipsoidRCS,                  sizeof(cl_mem),     &C->rcs_ellipsoid);
     ret |= clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentEllipsoidRCSDescription,       sizeof(cl_float4),  &C->rcs_ellipsoid_desc);
+    ret |= clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentPlacement,                     sizeof(cl_mem),     &C->placement);
+    ret |= clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentPlacementGrid,                 sizeof(cl_uint),    &H->placement_grid);
+    ret |= clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentSectorWidth,                   sizeof(cl_float),   &H->sector_width);
     ret |= clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentSimulationDescription,         sizeof(cl_float16), &H->sim_desc);
     if (ret != CL_SUCCESS) {
         fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_bg_atts().\n", now());
@@ -761,6 +983,9 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     ret |= clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentBackgroundDescription,         sizeof(cl_float16), &C->les_desc);
     ret |= clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentEllipsoidRCS,                  sizeof(cl_mem),     &C->rcs_ellipsoid);
     ret |= clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentEllipsoidRCSDescription,       sizeof(cl_float4),  &C->rcs_ellipsoid_desc);
+    ret |= clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentPlacement,                     sizeof(cl_mem),     &C->placement);
+    ret |= clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentPlacementGrid,                 sizeof(cl_uint),    &H->placement_grid);
+    ret |= clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentSectorWidth,                   sizeof(cl_float),   &H->sector_width);
     ret |= clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentSimulationDescription,         sizeof(cl_float16), &H->sim_desc);
     if (ret != CL_SUCCESS) {
         fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_fp_atts().\n", now());
@@ -777,6 +1002,9 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     ret |= clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentBackgroundDescription,         sizeof(cl_float16), &C->les_desc);
     ret |= clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentEllipsoidRCS,                  sizeof(cl_mem),     &C->rcs_ellipsoid);
     ret |= clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentEllipsoidRCSDescription,       sizeof(cl_float4),  &C->rcs_ellipsoid_desc);
+    ret |= clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentPlacement,                     sizeof(cl_mem),     &C->placement);
+    ret |= clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentPlacementGrid,                 sizeof(cl_uint),    &H->placement_grid);
+    ret |= clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentSectorWidth,                   sizeof(cl_float),   &H->sector_width);
     ret |= clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentSimulationDescription,         sizeof(cl_float16), &H->sim_desc);
     if (ret != CL_SUCCESS) {
         fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_el_atts().\n", now());
@@ -789,6 +1017,8 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentVelocity,                      sizeof(cl_mem),     &C->scat_vel);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentTumble,                        sizeof(cl_mem),     &C->scat_tum);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSection,             sizeof(cl_mem),     &C->scat_rcs);
+    ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionCache,        sizeof(cl_mem),     &C->scat_rcq);
+    ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionCacheOrigin,  sizeof(cl_uint),    &rcq_origin);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRandomSeed,                    sizeof(cl_mem),     &C->scat_rnd);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentBackgroundVelocity,            sizeof(cl_mem),     &C->les_uvwt[0]);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentBackgroundVelocityDescription, sizeof(cl_float16), &C->les_desc);
@@ -797,6 +1027,7 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentAirDragModelDescription,       sizeof(cl_float16), &C->adm_desc[0]);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionReal,         sizeof(cl_mem),     &C->rcs_real[0]);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionImag,         sizeof(cl_mem),     &C->rcs_imag[0]);
+    ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionGamma,        sizeof(cl_mem),     &C->rcs_gamma[0]);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionDescription,  sizeof(cl_float16), &C->rcs_desc[0]);
     ret |= clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentSimulationDescription,         sizeof(cl_float16), &H->sim_desc);
     if (ret != CL_SUCCESS) {
@@ -804,6 +1035,17 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
         exit(EXIT_FAILURE);
     }
     
+    ret = CL_SUCCESS;
+    ret |= clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentPosition,                 sizeof(cl_mem),     &C->scat_pos);
+    ret |= clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentOrientation,              sizeof(cl_mem),     &C->scat_ori);
+    ret |= clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentVelocity,                 sizeof(cl_mem),     &C->scat_vel);
+    ret |= clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentTumble,                   sizeof(cl_mem),     &C->scat_tum);
+    ret |= clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentSimulationDescription,    sizeof(cl_float16), &H->sim_desc);
+    if (ret != CL_SUCCESS) {
+        fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_kin_atts().\n", now());
+        exit(EXIT_FAILURE);
+    }
+    
     ret = CL_SUCCESS;
     ret |= clSetKernelArg(C->kern_scat_clr, RSScattererColorKernelArgumentColor,             sizeof(cl_mem),   &C->scat_clr);
     ret |= clSetKernelArg(C->kern_scat_clr, RSScattererColorKernelArgumentPosition,          sizeof(cl_mem),   &C->scat_pos);
@@ -822,6 +1064,7 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     ret |= clSetKernelArg(C->kern_scat_sig_aux, RSScattererAngularWeightKernalArgumentRadarCrossSection,      sizeof(cl_mem),     &C->scat_rcs);
     ret |= clSetKernelArg(C->kern_scat_sig_aux, RSScattererAngularWeightKernalArgumentWeightTable,            sizeof(cl_mem),     &C->angular_weight);
     ret |= clSetKernelArg(C->kern_scat_sig_aux, RSScattererAngularWeightKernalArgumentWeightTableDescription, sizeof(cl_float4),  &C->angular_weight_desc);
+    ret |= clSetKernelArg(C->kern_scat_sig_aux, RSScattererAngularWeightKernalArgumentEllipsoidCount,         sizeof(cl_uint),    &C->ellipsoid_count);
     ret |= clSetKernelArg(C->kern_scat_sig_aux, RSScattererAngularWeightKernalArgumentSimulationDescription,  sizeof(cl_float16), &H->sim_desc);
     if (ret != CL_SUCCESS) {
         fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_scat_sig_aux().\n", now());
@@ -829,26 +1072,31 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
     }
     
     if (C->verb > 1) {
-        rsprint("Pass 1   global =%7s   local = %3zu x %2d = %6s B   groups = %4d   N = %9s\n",
+        rsprint("Pass 1   global =%7s   local = %3zu x %2d = %6s B   groups = %4d   N = %9s   tiles = %d\n",
                 commaint(C->make_pulse_params.global[0]),
                 C->make_pulse_params.local[0],
-                C->make_pulse_params.range_count,
+                C->make_pulse_params.tile_size,
                 commaint(C->make_pulse_params.local_mem_size[0]),
                 C->make_pulse_params.group_counts[0],
-                commaint(C->make_pulse_params.entry_counts[0]));
+                commaint(C->make_pulse_params.entry_counts[0]),
+                C->make_pulse_params.tile_count);
     }
+    cl_kernel pass_1 = C->make_pulse_params.tile_count > 1 ? C->kern_make_pulse_pass_1_tiled : C->kern_make_pulse_pass_1;
     ret = CL_SUCCESS;
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 0, sizeof(cl_mem),                         &C->work);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 1, sizeof(cl_mem),                         &C->scat_sig);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 2, sizeof(cl_mem),                         &C->scat_aux);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 3, C->make_pulse_params.local_mem_size[0], NULL);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 4, sizeof(cl_mem),                         &C->range_weight);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 5, sizeof(cl_float4),                      &C->range_weight_desc);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 6, sizeof(float),                          &C->make_pulse_params.range_start);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 7, sizeof(float),                          &C->make_pulse_params.range_delta);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 8, sizeof(unsigned int),                   &C->make_pulse_params.range_count);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 9, sizeof(unsigned int),                   &C->make_pulse_params.group_counts[0]);
-    ret |= clSetKernelArg(C->kern_make_pulse_pass_1, 10, sizeof(unsigned int),                  &C->make_pulse_params.entry_counts[0]);
+    ret |= clSetKernelArg(pass_1, 0, sizeof(cl_mem),                         &C->work);
+    ret |= clSetKernelArg(pass_1, 1, sizeof(cl_mem),                         &C->scat_sig);
+    ret |= clSetKernelArg(pass_1, 2, sizeof(cl_mem),                         &C->scat_aux);
+    ret |= clSetKernelArg(pass_1, 3, C->make_pulse_params.local_mem_size[0], NULL);
+    ret |= clSetKernelArg(pass_1, 4, sizeof(cl_mem),                         &C->range_weight);
+    ret |= clSetKernelArg(pass_1, 5, sizeof(cl_float4),                      &C->range_weight_desc);
+    ret |= clSetKernelArg(pass_1, 6, sizeof(float),                          &C->make_pulse_params.range_start);
+    ret |= clSetKernelArg(pass_1, 7, sizeof(float),                          &C->make_pulse_params.range_delta);
+    ret |= clSetKernelArg(pass_1, 8, sizeof(unsigned int),                   &C->make_pulse_params.range_count);
+    ret |= clSetKernelArg(pass_1, 9, sizeof(unsigned int),                   &C->make_pulse_params.group_counts[0]);
+    ret |= clSetKernelArg(pass_1, 10, sizeof(unsigned int),                  &C->make_pulse_params.entry_counts[0]);
+    if (C->make_pulse_params.tile_count > 1) {
+        ret |= clSetKernelArg(pass_1, 11, sizeof(unsigned int),              &C->make_pulse_params.tile_size);
+    }
     if (ret != CL_SUCCESS) {
         fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel make_pulse_pass_1().\n", now());
         exit(EXIT_FAILURE);
@@ -885,6 +1133,29 @@ void RS_worker_malloc(RSHandle *H, const int worker_id) {
         exit(EXIT_FAILURE);
     }
     
+    ret = CL_SUCCESS;
+    ret |= clSetKernelArg(C->kern_moment_acc, 0, sizeof(cl_mem),                                &C->moment_acc);
+    ret |= clSetKernelArg(C->kern_moment_acc, 1, sizeof(cl_mem),                                &C->pulse);
+    if (ret != CL_SUCCESS) {
+        fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel moment_acc().\n", now());
+        exit(EXIT_FAILURE);
+    }
+    
+    if (C->emulator_state) {
+        ret = CL_SUCCESS;
+        ret |= clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentPulse,                   sizeof(cl_mem),     &C->pulse);
+        ret |= clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentState,                   sizeof(cl_mem),     &C->emulator_state);
+        ret |= clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentRandomSeed,              sizeof(cl_mem),     &C->emulator_seed);
+        ret |= clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentBackgroundVelocity,      sizeof(cl_mem),     &C->les_uvwt[0]);
+        ret |= clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentBackgroundDescription,   sizeof(cl_float16), &C->les_desc);
+        ret |= clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentEmulatorDescription,     sizeof(cl_float16), &H->emulator_desc);
+        ret |= clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentSimulationDescription,   sizeof(cl_float16), &H->sim_desc);
+        if (ret != CL_SUCCESS) {
+            fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel bg_emu().\n", now());
+            exit(EXIT_FAILURE);
+        }
+    }
+    
 #endif
     
     if (C->mem_usage > C->mem_size / 4 * 3) {
@@ -943,6 +1214,11 @@ RSHandle *RS_init_with_path(const char *bundle_path, RSMethod method, cl_context
     H->num_types = 1;
     H->method = method;
     H->random_seed = 19760520;
+    H->partition_index = 0;
+    H->partition_count = 1;
+    for (i = 0; i < RS_MAX_DEBRIS_TYPES; i++) {
+        H->physics_step[i] = 1;
+    }
     
     for (i = 0; i < RS_MAX_GPU_DEVICE; i++) {
         H->workers[i].name = i;
@@ -961,6 +1237,28 @@ RSHandle *RS_init_with_path(const char *bundle_path, RSMethod method, cl_context
     } else if (H->method == RS_METHOD_CPU) {
         // Run this to get the num_cus to the same values.
         get_device_info(CL_DEVICE_TYPE_CPU, &H->num_devs, H->devs, H->num_cus, H->vendors, 0);
+    } else if (H->method == RS_METHOD_HYBRID) {
+        if (verb) {
+            rsprint("Getting CL devices ...");
+        }
+        get_device_info(CL_DEVICE_TYPE_GPU, &H->num_devs, H->devs, H->num_cus, H->vendors, verb);
+        // The host joins as the last worker through the OpenCL CPU device
+        cl_uint num_cpus = 0;
+        cl_uint cpu_cus[RS_MAX_GPU_DEVICE];
+        cl_uint cpu_vendors[RS_MAX_GPU_DEVICE];
+        cl_device_id cpus[RS_MAX_GPU_DEVICE];
+        get_device_info(CL_DEVICE_TYPE_CPU, &num_cpus, cpus, cpu_cus, cpu_vendors, 0);
+        if (num_cpus > 0 && H->num_devs < RS_MAX_GPU_DEVICE) {
+            if (H->num_devs == 0) {
+                rsprint("WARNING: No OpenCL GPU device found. Host will be the only worker.");
+            }
+            H->devs[H->num_devs] = cpus[0];
+            H->num_cus[H->num_devs] = cpu_cus[0];
+            H->vendors[H->num_devs] = cpu_vendors[0];
+            H->num_devs++;
+        } else if (num_cpus == 0) {
+            rsprint("WARNING: No OpenCL CPU device found. Host will not be used as a worker.");
+        }
     }
     if (H->num_devs == 0 || H->num_cus[0] == 0) {
         rsprint("ERROR: No OpenCL devices found.");
@@ -968,6 +1266,11 @@ RSHandle *RS_init_with_path(const char *bundle_path, RSMethod method, cl_context
     }
     
     H->num_workers = H->num_devs;
+    
+    // Share of the population is proportional to the throughput of each worker; equal shares for homogeneous devices
+    for (i = 0; i < H->num_devs; i++) {
+        H->worker_share[i] = H->method == RS_METHOD_HYBRID ? get_device_throughput(H->devs[i]) : 1.0f;
+    }
     switch (H->vendors[0]) {
         case RS_GPU_VENDOR_AMD:
         case RS_GPU_VENDOR_INTEL:
@@ -1085,6 +1388,11 @@ RSHandle *RS_init_for_cpu_verbose(const char verb) {
 }
 
 
+RSHandle *RS_init_for_hybrid_verbose(const char verb) {
+    return RS_init_with_path(".", RS_METHOD_HYBRID, 0, verb);
+}
+
+
 RSHandle *RS_init_verbose(const char verb) {
     return RS_init_with_path(".", RS_METHOD_GPU, 0, verb);
 }
@@ -1095,6 +1403,134 @@ RSHandle *RS_init() {
 }
 
 
+// Host copies of the scatterer attributes, only made for the host population path and RS_download()
+// Backed by mapped CL_MEM_ALLOC_HOST_PTR buffers on discrete GPUs so the reads are DMA from pinned pages
+int RS_alloc_host_mirrors(RSHandle *H) {
+    
+    int i, k, n, w;
+    
+    if (H->scat_pos != NULL) {
+        return 0;
+    }
+    
+    void **mirrors[RS_HOST_MIRROR_COUNT] = {
+        (void **)&H->scat_uid, (void **)&H->scat_pos, (void **)&H->scat_vel,
+        (void **)&H->scat_ori, (void **)&H->scat_tum, (void **)&H->scat_aux,
+        (void **)&H->scat_rcs, (void **)&H->scat_sig, (void **)&H->scat_rnd
+    };
+    const size_t size = H->num_scats * sizeof(cl_float4);
+    
+#if defined (_USE_GCL_)
+    
+    const char pinned = 0;
+    
+#else
+    
+    cl_int ret;
+    cl_device_type type = CL_DEVICE_TYPE_DEFAULT;
+    cl_bool unified = CL_TRUE;
+    clGetDeviceInfo(H->workers[0].dev, CL_DEVICE_TYPE, sizeof(type), &type, NULL);
+    clGetDeviceInfo(H->workers[0].dev, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(unified), &unified, NULL);
+    const char pinned = (type & CL_DEVICE_TYPE_GPU) && !unified;
+    
+#endif
+    
+    for (k = 0; k < RS_HOST_MIRROR_COUNT; k++) {
+        H->scat_mirror[k] = NULL;
+        
+#if !defined (_USE_GCL_)
+        
+        if (pinned) {
+            H->scat_mirror[k] = clCreateBuffer(H->workers[0].context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size, NULL, &ret);
+            if (ret == CL_SUCCESS) {
+                *mirrors[k] = clEnqueueMapBuffer(H->workers[0].que, H->scat_mirror[k], CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, size, 0, NULL, NULL, &ret);
+                if (ret == CL_SUCCESS) {
+                    continue;
+                }
+                clReleaseMemObject(H->scat_mirror[k]);
+            }
+            // Fall back to plain memory
+            H->scat_mirror[k] = NULL;
+            *mirrors[k] = NULL;
+        }
+        
+#endif
+        
+        if (posix_memalign(mirrors[k], RS_ALIGN_SIZE, size)) {
+            *mirrors[k] = NULL;
+        }
+        if (*mirrors[k] == NULL) {
+            rsprint("ERROR: Unable to allocate memory space for scatterers.");
+            RS_free_host_mirrors(H);
+            return -1;
+        }
+    }
+    
+    H->mem_size += RS_HOST_MIRROR_COUNT * size;
+    
+    if (H->verb > 1) {
+        rsprint("Host mirrors = %s MB%s", commafloat((float)(RS_HOST_MIRROR_COUNT * size) * 1.0e-6f), pinned ? " (pinned)" : "");
+    }
+    
+    // Universal id of each scatterer, in the order they are laid out
+    if (H->sim_concept & RSSimulationConceptFixedScattererPosition) {
+        for (i = 0; i < H->num_scats; i++) {
+            H->scat_uid[i].s0 = i;
+            H->scat_uid[i].s1 = (cl_uint)H->num_scats;
+            H->scat_uid[i].s2 = 0;
+            H->scat_uid[i].s3 = 0;
+        }
+    } else {
+        uint32_t uid = 0;
+        for (k = 0; k < H->num_types; k++) {
+            for (w = 0; w < H->num_workers; w++) {
+                i = (int)(H->offset[w] + H->workers[w].origins[k]);
+                for (n = 0; n < H->workers[w].counts[k]; n++) {
+                    H->scat_uid[i].s0 = uid++;
+                    H->scat_uid[i].s1 = n;
+                    H->scat_uid[i].s2 = k;
+                    H->scat_uid[i].s3 = w;
+                    i++;
+                }
+            }
+        }
+    }
+    
+    return 0;
+}
+
+
+void RS_free_host_mirrors(RSHandle *H) {
+    
+    int k;
+    
+    void **mirrors[RS_HOST_MIRROR_COUNT] = {
+        (void **)&H->scat_uid, (void **)&H->scat_pos, (void **)&H->scat_vel,
+        (void **)&H->scat_ori, (void **)&H->scat_tum, (void **)&H->scat_aux,
+        (void **)&H->scat_rcs, (void **)&H->scat_sig, (void **)&H->scat_rnd
+    };
+    
+    for (k = 0; k < RS_HOST_MIRROR_COUNT; k++) {
+        
+#if !defined (_USE_GCL_)
+        
+        if (H->scat_mirror[k] != NULL) {
+            clEnqueueUnmapMemObject(H->workers[0].que, H->scat_mirror[k], *mirrors[k], 0, NULL, NULL);
+            clFinish(H->workers[0].que);
+            clReleaseMemObject(H->scat_mirror[k]);
+            H->scat_mirror[k] = NULL;
+            *mirrors[k] = NULL;
+            continue;
+        }
+        
+#endif
+        
+        free(*mirrors[k]);
+        *mirrors[k] = NULL;
+    }
+}
+
+
 void RS_free_scat_memory(RSHandle *H) {
     int i;
     
@@ -1115,11 +1551,18 @@ void RS_free_scat_memory(RSHandle *H) {
         gcl_free(H->workers[i].scat_ori);
         gcl_free(H->workers[i].scat_tum);
         gcl_free(H->workers[i].scat_aux);
+        gcl_free(H->workers[i].scat_rcq);
         gcl_free(H->workers[i].scat_rcs);
         gcl_free(H->workers[i].scat_sig);
         gcl_free(H->workers[i].work);
         gcl_free(H->workers[i].pulse);
+        gcl_free(H->workers[i].moment_acc);
         gcl_free(H->workers[i].scat_rnd);
+        if (H->workers[i].emulator_state) {
+            gcl_free(H->workers[i].emulator_state);
+            gcl_free(H->workers[i].emulator_seed);
+            H->workers[i].emulator_state = NULL;
+        }
     }
     
 #else
@@ -1131,11 +1574,23 @@ void RS_free_scat_memory(RSHandle *H) {
         clReleaseMemObject(H->workers[i].scat_ori);
         clReleaseMemObject(H->workers[i].scat_tum);
         clReleaseMemObject(H->workers[i].scat_aux);
+        clReleaseMemObject(H->workers[i].scat_rcq);
         clReleaseMemObject(H->workers[i].scat_rcs);
         clReleaseMemObject(H->workers[i].scat_sig);
         clReleaseMemObject(H->workers[i].work);
         clReleaseMemObject(H->workers[i].pulse);
+        clReleaseMemObject(H->workers[i].moment_acc);
         clReleaseMemObject(H->workers[i].scat_rnd);
+        if (H->workers[i].emulator_state) {
+            clReleaseMemObject(H->workers[i].emulator_state);
+            clReleaseMemObject(H->workers[i].emulator_seed);
+            H->workers[i].emulator_state = NULL;
+        }
+        if (H->workers[i].gather_capacity) {
+            clReleaseMemObject(H->workers[i].gather);
+            clReleaseMemObject(H->workers[i].gather_idx);
+            H->workers[i].gather_capacity = 0;
+        }
     }
     
 #endif
@@ -1144,16 +1599,10 @@ void RS_free_scat_memory(RSHandle *H) {
         rsprint("Freeing CPU memories ...");
     }
     
-    free(H->scat_pos);
-    free(H->scat_vel);
-    free(H->scat_ori);
-    free(H->scat_tum);
-    free(H->scat_aux);
-    free(H->scat_rcs);
-    free(H->scat_sig);
-    free(H->scat_rnd);
+    RS_free_host_mirrors(H);
     
     free(H->pulse);
+    free(H->moment_acc);
     
     for (i = 0; i < H->num_workers; i++) {
         free(H->pulse_tmp[i]);
@@ -1173,6 +1622,11 @@ void RS_free(RSHandle *H) {
         OBJ_free(H->O);
     }
     
+    RS_stop_trajectory_recorder(H);
+    
+    // Pinned host mirrors are unmapped through the queue of the first worker
+    RS_free_host_mirrors(H);
+    
     for (i = 0; i < H->num_workers; i++) {
         RS_worker_free(&H->workers[i]);
     }
@@ -1184,6 +1638,7 @@ void RS_free(RSHandle *H) {
     for (i = 0; i < H->num_workers; i++) {
         gcl_free(H->workers[i].angular_weight);
         gcl_free(H->workers[i].range_weight);
+        gcl_free(H->workers[i].placement);
         
         gcl_release_image(H->workers[i].rcs_ellipsoid);
         gcl_release_image(H->workers[i].les_uvwt[0]);
@@ -1197,6 +1652,7 @@ void RS_free(RSHandle *H) {
         for (int r = 0; r < H->rcs_count; r++) {
             gcl_release_image(H->workers[i].rcs_real[r]);
             gcl_release_image(H->workers[i].rcs_imag[r]);
+            gcl_release_image(H->workers[i].rcs_gamma[r]);
         }
     }
     
@@ -1205,6 +1661,9 @@ void RS_free(RSHandle *H) {
     for (i = 0; i < H->num_workers; i++) {
         clReleaseMemObject(H->workers[i].angular_weight);
         clReleaseMemObject(H->workers[i].range_weight);
+        if (H->workers[i].placement) {
+            clReleaseMemObject(H->workers[i].placement);
+        }
         
         clReleaseMemObject(H->workers[i].rcs_ellipsoid);
         clReleaseMemObject(H->workers[i].les_uvwt[0]);
@@ -1218,6 +1677,7 @@ void RS_free(RSHandle *H) {
         for (int r = 0; r < H->rcs_count; r++) {
             clReleaseMemObject(H->workers[i].rcs_real[r]);
             clReleaseMemObject(H->workers[i].rcs_imag[r]);
+            clReleaseMemObject(H->workers[i].rcs_gamma[r]);
         }
     }
     
@@ -1226,6 +1686,10 @@ void RS_free(RSHandle *H) {
     free(H->anchor_pos);
     free(H->anchor_lines);
     
+    RS_table_free(H->range_weight);
+    RS_table_free(H->angular_weight);
+    free(H->placement);
+    
     if (H->dsd_r != NULL) {
         free(H->dsd_r);
         free(H->dsd_pdf);
@@ -1282,26 +1746,24 @@ RSMakePulseParams RS_make_pulse_params(const cl_uint count,
     param.group_counts[0] = group_count;
     param.global[0] = group_count * work_items;
     param.local[0] = work_items;
-    param.local_mem_size[0] = range_count * work_items * sizeof(cl_float4);
-    while (param.local_mem_size[0] > max_local_mem_size) {
-        #ifdef DEBUG_CL
-        rsprint("Local memory size = %s. Adjusting ...", commaint((long long)max_local_mem_size));
-        #endif
-        if (range_count % 2 == 0) {
-            work_items /= 2;
-            group_count *= 2;
-            if (group_count > param.user_max_groups) {
-                group_count = param.user_max_groups;
-            }
-            param.group_counts[0] = group_count;
-            param.global[0] = group_count * work_items;
-            param.local[0] = work_items;
-            param.local_mem_size[0] = range_count * work_items * sizeof(cl_float4);
-        } else {
+    
+    // Gates in tiles that fit the local memory of this device rather than fewer work items
+    param.tile_size = param.range_count;
+    param.tile_count = 1;
+    if (param.range_count * work_items * sizeof(cl_float4) > max_local_mem_size) {
+        param.tile_size = (unsigned int)(max_local_mem_size / (work_items * sizeof(cl_float4)));
+        if (param.tile_size == 0) {
             rsprint("ERROR: Could not resolve local memory size limits.");
             exit(EXIT_FAILURE);
         }
+        param.tile_count = (param.range_count + param.tile_size - 1) / param.tile_size;
+        // Even out the tiles so that the last one is not a sliver
+        param.tile_size = (param.range_count + param.tile_count - 1) / param.tile_count;
+        #ifdef DEBUG_CL
+        rsprint("Local memory size = %s. Using %d tiles of %d gates.", commaint((long long)max_local_mem_size), param.tile_count, param.tile_size);
+        #endif
     }
+    param.local_mem_size[0] = param.tile_size * work_items * sizeof(cl_float4);
     
     // 2nd pass
     unsigned int work_count = group_count * param.range_count;
@@ -1338,9 +1800,6 @@ RSMakePulseParams RS_make_pulse_params(const cl_uint count,
         param.local_mem_size[1] = sizeof(cl_float4);
         
     }
-    if (param.entry_counts[1] > RS_MAX_GATES * work_items) {
-        fprintf(stderr, "%s : RS : H->dev_work may not be large enough.\n", now());
-    }
     return param;
 }
 
@@ -1353,13 +1812,24 @@ void RS_set_concept(RSHandle *H, RSSimulationConcept c) {
 }
 
 
+// Integrators are concept bits so that the kernels can pick them up from sim_desc
+void RS_set_integrator(RSHandle *H, const RSIntegrator integrator) {
+    H->sim_concept &= ~(RSSimulationConceptRungeKutta2 | RSSimulationConceptRungeKutta4);
+    H->sim_concept |= integrator;
+    float tmpf; memcpy(&tmpf, &H->sim_concept, sizeof(float));
+    H->sim_desc.s[RSSimulationDescriptionConcept] = tmpf;
+}
+
+
 char *RS_simulation_concept_string(RSHandle *H) {
     static char string[32];
     sprintf(string,
-            "Concepts used: %s%s%s%s%s%s",
+            "Concepts used: %s%s%s%s%s%s%s%s",
             H->sim_concept & RSSimulationConceptBoundedParticleVelocity ? "B" : "",
             H->sim_concept & RSSimulationConceptDraggedBackground ? "D" : "",
+            H->sim_concept & RSSimulationConceptEmulatedBackground ? "E" : "",
             H->sim_concept & RSSimulationConceptFixedScattererPosition ? "F" : "",
+            H->sim_concept & RSSimulationConceptImportanceSampledPlacement ? "I" : "",
             H->sim_concept & RSSimulationConceptTransparentBackground ? "T" : "",
             H->sim_concept & RSSimulationConceptUniformDSDScaledRCS ? "U" : "",
             H->sim_concept & RSSimulationConceptVerticallyPointingRadar ? "V" :"");
@@ -1376,9 +1846,15 @@ char *RS_simulation_concept_bulleted_string(RSHandle *H) {
     if (H->sim_concept & RSSimulationConceptDraggedBackground) {
         sprintf(string + strlen(string), RS_INDENT "o D - Dragged Meteorological Scatterers\n");
     }
+    if (H->sim_concept & RSSimulationConceptEmulatedBackground) {
+        sprintf(string + strlen(string), RS_INDENT "o E - Emulated Meteorological Background\n");
+    }
     if (H->sim_concept & RSSimulationConceptFixedScattererPosition) {
         sprintf(string + strlen(string), RS_INDENT "o F - Fixed Scatterer Positions\n");
     }
+    if (H->sim_concept & RSSimulationConceptImportanceSampledPlacement) {
+        sprintf(string + strlen(string), RS_INDENT "o I - Importance-Sampled Placement\n");
+    }
     if (H->sim_concept & RSSimulationConceptTransparentBackground) {
         sprintf(string + strlen(string), RS_INDENT "o T - Transparent Meteorological Scatterers\n");
     }
@@ -1388,6 +1864,11 @@ char *RS_simulation_concept_bulleted_string(RSHandle *H) {
     if (H->sim_concept & RSSimulationConceptVerticallyPointingRadar) {
         sprintf(string + strlen(string), RS_INDENT "o V - Vertically Pointing Radar\n");
     }
+    if (H->sim_concept & RSSimulationConceptRungeKutta4) {
+        sprintf(string + strlen(string), RS_INDENT "o RK4 Integrator\n");
+    } else if (H->sim_concept & RSSimulationConceptRungeKutta2) {
+        sprintf(string + strlen(string), RS_INDENT "o RK2 Integrator\n");
+    }
     return string;
 }
 
@@ -1407,16 +1888,81 @@ void RS_set_prt(RSHandle *H, const RSfloat prt) {
     H->params.prt = prt;
     
     H->sim_desc.s[RSSimulationDescriptionPRT] = H->params.prt;
+    H->sim_desc.s[RSSimulationDescriptionPhysicsStep] = H->params.prt;
     
     RS_update_computed_properties(H);
 }
 
 
-void RS_set_lambda(RSHandle *H, const RSfloat lambda) {
-    H->params.lambda = lambda;
-    
-    H->sim_desc.s[RSSimulationDescriptionWaveNumber] = 4.0f * M_PI / H->params.lambda;
-    
+// Full physics (wind, drag, ADM) every count pulses, only the kinematics in between
+void RS_set_physics_step(RSHandle *H, const int count) {
+    for (int k = 0; k < RS_MAX_DEBRIS_TYPES; k++) {
+        RS_set_physics_step_of_type(H, k, count);
+    }
+}
+
+
+// Type 0 is the background, 1, 2, ... are the debris in the order of RS_add_debris()
+void RS_set_physics_step_of_type(RSHandle *H, const int type, const int count) {
+    if (type < 0 || type >= RS_MAX_DEBRIS_TYPES) {
+        rsprint("ERROR: Invalid type %d for the physics step.", type);
+        return;
+    }
+    int n = MAX(1, count);
+    if (n > 1 && H->sim_concept & RSSimulationConceptFixedScattererPosition) {
+        rsprint("WARNING: Physics sub-steps are not used with fixed scatterer positions.");
+        n = 1;
+    }
+    H->physics_step[type] = n;
+    H->physics_count[type] = 0;
+    if (H->verb && n > 1 && type < H->num_types) {
+        rsprint("Physics step of type %d = %d pulses (%.2f ms).", type, n, 1.0e3f * H->params.prt * (RSfloat)n);
+    }
+}
+
+
+void RS_set_debris_rcs_gamma_resolution(RSHandle *H, const int count) {
+    if (H->rcs_count > 0) {
+        rsprint("WARNING: Gamma resolution only applies to the RCS tables added after this call.");
+    }
+    if (count == 1) {
+        rsprint("WARNING: Gamma resolution needs at least 2 angles.");
+    }
+    H->rcs_gamma_count = count > 1 ? count : 0;
+    if (H->verb && H->rcs_gamma_count) {
+        rsprint("Debris RCS gamma resolution = %d angles (%.2f deg).", H->rcs_gamma_count, 360.0f / (float)(H->rcs_gamma_count - 1));
+    }
+}
+
+
+void RS_set_debris_rcs_tolerance(RSHandle *H, const RSfloat angle_deg) {
+    if (H->status & RSStatusDomainPopulated) {
+        rsprint("WARNING: Debris RCS tolerance must be set before RS_populate().");
+        return;
+    }
+    H->rcs_tolerance = angle_deg > 0.0f ? MIN(angle_deg, 90.0f) * M_PI / 180.0f : 0.0f;
+    for (int i = 0; i < H->num_workers; i++) {
+        for (int t = 0; t < H->rcs_count; t++) {
+            H->workers[i].rcs_desc[t].s[RSTable3DDescriptionRCSTolerance] = RS_rcs_tolerance_desc(H);
+        }
+    }
+    if (H->verb && H->rcs_tolerance > 0.0f) {
+        rsprint("Debris RCS tolerance = %.2f deg.", H->rcs_tolerance * 180.0f / M_PI);
+    }
+}
+
+
+// Cosine of half the tolerance, the quaternions of two rotations that are within the tolerance have a larger |dot|
+float RS_rcs_tolerance_desc(RSHandle *H) {
+    return H->rcs_tolerance > 0.0f ? cosf(0.5f * H->rcs_tolerance) : 0.0f;
+}
+
+
+void RS_set_lambda(RSHandle *H, const RSfloat lambda) {
+    H->params.lambda = lambda;
+    
+    H->sim_desc.s[RSSimulationDescriptionWaveNumber] = 4.0f * M_PI / H->params.lambda;
+    
     RS_update_computed_properties(H);
 }
 
@@ -1436,6 +1982,21 @@ void RS_set_density(RSHandle *H, const RSfloat density) {
 }
 
 
+// Only a sector of this width around the beam azimuth is populated, scatterers that fall off the trailing edge
+// are recycled into the leading edge. Must come before RS_set_scan_box(), which pads the domain by half of it.
+void RS_set_sector_width(RSHandle *H, const RSfloat width_deg) {
+    if (H->status & (RSStatusDomainPopulated | RSStatusPopulationDefined)) {
+        rsprint("Population has been defined. Sector width cannot be changed.");
+        return;
+    }
+    if (H->sim_concept & (RSSimulationConceptFixedScattererPosition | RSSimulationConceptVerticallyPointingRadar) && width_deg > 0.0f) {
+        rsprint("WARNING: Sliding sector is not used with fixed scatterer positions or a vertically pointing radar.");
+        return;
+    }
+    H->sector_width = width_deg > 0.0f && width_deg < 360.0f ? 0.5f * width_deg / 180.0f * M_PI : 0.0f;
+}
+
+
 void RS_set_antenna_params(RSHandle *H, RSfloat beamwidth_deg, RSfloat gain_dbi) {
     if (H->status & RSStatusDomainPopulated) {
         rsprint("Simulation domain has been populated. Radar antenna parameters cannot be changed.");
@@ -1495,8 +2056,10 @@ void RS_set_scan_box(RSHandle *H,
     
     const RSfloat r_lo = floor(MAX(H->params.range_delta, H->params.range_start - H->params.domain_pad_factor * H->params.dr) / H->params.range_delta) * H->params.range_delta;
     const RSfloat r_hi = ceil(MIN(10.0e3f, H->params.range_end + H->params.domain_pad_factor * H->params.dr) / H->params.range_delta) * H->params.range_delta;
-    const RSfloat az_lo = is_full_sweep ? 0.0f : floor(H->params.azimuth_start_deg - H->params.domain_pad_factor * H->params.antenna_bw_deg) / H->params.antenna_bw_deg * H->params.antenna_bw_deg;
-    const RSfloat az_hi = is_full_sweep ? 360.0f : ceil(H->params.azimuth_end_deg + H->params.domain_pad_factor * H->params.antenna_bw_deg) / H->params.antenna_bw_deg * H->params.antenna_bw_deg;
+    // The sliding sector must stay within the domain at both ends of the sweep
+    const RSfloat sector_pad = H->sector_width * 180.0f / M_PI;
+    const RSfloat az_lo = is_full_sweep ? 0.0f : floor(H->params.azimuth_start_deg - sector_pad - H->params.domain_pad_factor * H->params.antenna_bw_deg) / H->params.antenna_bw_deg * H->params.antenna_bw_deg;
+    const RSfloat az_hi = is_full_sweep ? 360.0f : ceil(H->params.azimuth_end_deg + sector_pad + H->params.domain_pad_factor * H->params.antenna_bw_deg) / H->params.antenna_bw_deg * H->params.antenna_bw_deg;
     const RSfloat el_lo = floor(MAX(0.0f, H->params.elevation_start_deg - H->params.domain_pad_factor * H->params.antenna_bw_deg) / H->params.antenna_bw_deg) * H->params.antenna_bw_deg;
     const RSfloat el_hi = ceil(MIN(90.0f, H->params.elevation_end_deg + H->params.domain_pad_factor * H->params.antenna_bw_deg) / H->params.antenna_bw_deg) * H->params.antenna_bw_deg;
     const RSfloat tiny = 1.0e-5f;
@@ -2067,6 +2630,51 @@ void RS_set_debris_count(RSHandle *H, const int debris_id, const size_t count) {
 }
 
 
+void RS_set_worker_share(RSHandle *H, const int worker_id, const float share) {
+    
+    if (worker_id < 0 || worker_id >= H->num_workers) {
+        rsprint("ERROR: Worker %d does not exist.", worker_id);
+        return;
+    }
+    
+    if (H->status & RSStatusDomainPopulated) {
+        rsprint("Simulation domain has been populated. Worker share cannot be changed.");
+        return;
+    }
+    
+    H->worker_share[worker_id] = share;
+    
+    if (H->verb > 1) {
+        rsprint("workers[%d] share = %.4e", worker_id, share);
+    }
+}
+
+
+void RS_set_population_partition(RSHandle *H, const int index, const int count) {
+    
+    if (count < 1 || index < 0 || index >= count) {
+        rsprint("ERROR: Invalid population partition %d / %d.", index, count);
+        return;
+    }
+    
+    if (H->status & RSStatusDomainPopulated) {
+        rsprint("Simulation domain has been populated. Partition cannot be changed.");
+        return;
+    }
+    
+    if (H->sim_concept & (RSSimulationConceptFixedScattererPosition | RSSimulationConceptVerticallyPointingRadar) && count > 1) {
+        rsprint("WARNING: Fixed scatterer positions are not partitioned. Every partition simulates the full set.");
+    }
+    
+    H->partition_index = index;
+    H->partition_count = count;
+    
+    if (H->verb) {
+        rsprint("Population partition %d out of %d", index, count);
+    }
+}
+
+
 void RS_revise_population(RSHandle *H) {
     int ii;
     
@@ -2076,6 +2684,12 @@ void RS_revise_population(RSHandle *H) {
     clGetDeviceInfo(H->workers[0].dev, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(max_work_group_size), &max_work_group_size, NULL);
     const size_t mul = H->num_cus[0] * H->num_workers * max_work_group_size * 2;
     
+    H->bg_emulator = (H->sim_concept & RSSimulationConceptEmulatedBackground) &&
+                     !(H->sim_concept & (RSSimulationConceptFixedScattererPosition | RSSimulationConceptVerticallyPointingRadar));
+    if (H->sim_concept & RSSimulationConceptEmulatedBackground && !H->bg_emulator) {
+        rsprint("WARNING: Background emulator is not used with fixed scatterer positions or a vertically pointing radar.");
+    }
+    
     if (H->sim_concept & RSSimulationConceptVerticallyPointingRadar) {
         size_t anchors_per_plane = (H->num_anchors - 1) / 2;
         H->num_scats = H->params.range_count * anchors_per_plane;
@@ -2096,12 +2710,10 @@ void RS_revise_population(RSHandle *H) {
         // Volume of a single resolution cell at the start of the domain (svol = smallest volume)
         RSfloat r = H->params.range_start;
         RSfloat svol = (H->params.antenna_bw_rad * r) * (H->params.antenna_bw_rad * r) * (H->params.c * H->params.tau * 0.5f);
-        RSfloat nvol = H->sim_desc.s[RSSimulationDescriptionBoundSizeX]
-        * H->sim_desc.s[RSSimulationDescriptionBoundSizeY]
-        * H->sim_desc.s[RSSimulationDescriptionBoundSizeZ] / svol;
+        RSfloat nvol = RS_sector_volume(H) / svol;
         
-        // Suggest a number of scatter bodies to use
-        H->num_scats = (size_t)(H->params.body_per_cell * nvol);
+        // Suggest a number of scatter bodies to use, only a fraction of it if the population is partitioned
+        H->num_scats = (size_t)(H->params.body_per_cell * nvol / H->partition_count);
         H->counts[0] = H->num_scats;
         
         // Round the total population to a GPU preferred number
@@ -2113,6 +2725,11 @@ void RS_revise_population(RSHandle *H) {
             }
         }
         
+        // The emulator carries the background, a token of transparent drops keeps the rest intact
+        if (H->bg_emulator) {
+            preferred_n = MIN(preferred_n, mul);
+        }
+        
         // Revise the background (rain)
         H->counts[0] = preferred_n;
 
@@ -2151,6 +2768,12 @@ void RS_revise_debris_counts_to_gpu_preference(RSHandle *H) {
     
     int i;
     
+    // Rounding each partition would inflate the global count, round the count before RS_add_debris() instead
+    if (H->partition_count > 1) {
+        rsprint("WARNING: Debris counts of a partitioned population are not revised.");
+        return;
+    }
+    
     for (i = 0; i < RS_MAX_DEBRIS_TYPES; i++) {
         if (H->counts[i]) {
             H->counts[i] = ((H->counts[i] + H->preferred_multiple - 1) / H->preferred_multiple) * H->preferred_multiple;
@@ -2203,15 +2826,32 @@ void RS_update_origins_offsets(RSHandle *H) {
         exit(EXIT_FAILURE);
     }
     
-    // Divide the scatter bodies into (num_workers) chunks
-    const size_t sub_num_scats = H->num_scats / MAX(1, H->num_workers);
+    // Normalized share of each worker
+    float share[RS_MAX_GPU_DEVICE];
+    float share_sum = 0.0f;
+    for (i = 0; i < H->num_workers; i++) {
+        share_sum += MAX(0.0f, H->worker_share[i]);
+    }
+    for (i = 0; i < H->num_workers; i++) {
+        share[i] = share_sum > 0.0f ? MAX(0.0f, H->worker_share[i]) / share_sum : 1.0f / (float)H->num_workers;
+    }
+    
+    // Divide the scatter bodies into (num_workers) chunks, sized by the share and kept in multiples of the pass-1 stride
+    const size_t granule = 2 * RS_CL_GROUP_ITEMS;
+    size_t sub_num_scats = 0;
     
     size_t offset = 0;
     for (i = 0; i < H->num_workers; i++) {
+        if (i == H->num_workers - 1) {
+            // The last worker gets all the remainders
+            sub_num_scats = H->num_scats - offset;
+        } else {
+            sub_num_scats = (size_t)((double)share[i] * (double)H->num_scats) / granule * granule;
+        }
         H->offset[i] = offset;
         H->workers[i].num_scats = sub_num_scats;
         if (H->verb > 2) {
-            rsprint("workers[%d]   num_scats = %s   offset = %s", i, commaint(sub_num_scats), commaint(H->offset[i]));
+            rsprint("workers[%d]   num_scats = %s   offset = %s   share = %.3f", i, commaint(sub_num_scats), commaint(H->offset[i]), share[i]);
         }
         offset += sub_num_scats;
     }
@@ -2250,16 +2890,30 @@ void RS_update_origins_offsets(RSHandle *H) {
     while (k > 0) {
         k--;
         size_t debris_count_left = H->counts[k];
+        // Background scatterers take whatever is left after the debris
+        if (k == 0) {
+            for (i = 0; i < H->num_workers; i++) {
+                size_t debris_count = 0;
+                for (int j = 1; j < RS_MAX_DEBRIS_TYPES; j++) {
+                    debris_count += H->workers[i].counts[j];
+                }
+                if (debris_count > H->workers[i].num_scats) {
+                    rsprint("ERROR: workers[%d] has more debris (%s) than its share (%s).", i, commaint(debris_count), commaint(H->workers[i].num_scats));
+                    exit(EXIT_FAILURE);
+                }
+                H->workers[i].counts[0] = H->workers[i].num_scats - debris_count;
+            }
+            continue;
+        }
         if (debris_count_left == 0) {
             for (i = 0; i < H->num_workers; i++) {
                 H->workers[i].counts[k] = 0;
             }
             continue;
         }
-        // Groups of debris types
-        size_t round_up_down_toggle = H->num_workers > 1 ? k % H->num_workers : k;
-        size_t sub_counts = (H->counts[k] + round_up_down_toggle) / H->num_workers;
+        // Groups of debris types, split by the worker share
         for (i = 0; i < H->num_workers - 1; i++) {
+            size_t sub_counts = MIN(debris_count_left, (size_t)((double)share[i] * (double)H->counts[k] + 0.5));
             H->workers[i].counts[k] = sub_counts;
             debris_count_left -= sub_counts;
         }
@@ -2481,6 +3135,42 @@ void RS_set_rcs_ellipsoid_table(RSHandle *H, const cl_float4 *weights, const flo
 }
 
 
+#if !defined (_USE_GCL_)
+
+// Weights in .s0 of a CL_RGBA / CL_FLOAT 1-D image when the worker was built with RS_USE_WEIGHT_IMAGES, a plain buffer otherwise
+cl_mem RS_create_weight_table(RSWorker *C, const float *weights, const unsigned int table_size, cl_int *ret) {
+    
+#if defined (CL_VERSION_1_2)
+    
+    if (C->weight_images) {
+        cl_float4 *texels = (cl_float4 *)malloc(table_size * sizeof(cl_float4));
+        if (texels == NULL) {
+            *ret = CL_OUT_OF_HOST_MEMORY;
+            return NULL;
+        }
+        memset(texels, 0, table_size * sizeof(cl_float4));
+        for (unsigned int k = 0; k < table_size; k++) {
+            texels[k].s[0] = weights[k];
+        }
+        cl_image_format format = {CL_RGBA, CL_FLOAT};
+        cl_image_desc desc;
+        memset(&desc, 0, sizeof(cl_image_desc));
+        desc.image_type = CL_MEM_OBJECT_IMAGE1D;
+        desc.image_width = table_size;
+        desc.image_row_pitch = desc.image_width * sizeof(cl_float4);
+        cl_mem image = clCreateImage(C->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &format, &desc, texels, ret);
+        free(texels);
+        return image;
+    }
+    
+#endif
+    
+    return clCreateBuffer(C->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, table_size * sizeof(float), (void *)weights, ret);
+}
+
+#endif
+
+
 void RS_set_range_weight(RSHandle *H, const float *weights, const float table_index_start, const float table_index_delta, unsigned int table_size) {
     
     int i;
@@ -2519,6 +3209,10 @@ void RS_set_range_weight(RSHandle *H, const float *weights, const float table_in
     
     cl_int ret;
     for (i = 0; i < H->num_workers; i++) {
+        if (RS_worker_fit_weight_table(H, i, table_size)) {
+            RS_table_free(table);
+            return;
+        }
         if (H->workers[i].range_weight != NULL) {
             if (H->verb > 1) {
                 rsprint("workers[%d] setting range weight.", i);
@@ -2528,7 +3222,7 @@ void RS_set_range_weight(RSHandle *H, const float *weights, const float table_in
         if (H->verb > 2) {
             rsprint("workers[%d] creating range weight (cl_mem) & copying data from %p.", now(), i, table.data);
         }
-        H->workers[i].range_weight = clCreateBuffer(H->workers[i].context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, table_size * sizeof(float), table.data, &ret);
+        H->workers[i].range_weight = RS_create_weight_table(&H->workers[i], table.data, table_size, &ret);
         if (ret != CL_SUCCESS) {
             rsprint("ERROR: Unable to create range weight table on CL device.");
             return;
@@ -2545,10 +3239,12 @@ void RS_set_range_weight(RSHandle *H, const float *weights, const float table_in
         H->workers[i].range_weight_desc.s[RSTable1DDescriptionScale] = table.dx;
         H->workers[i].range_weight_desc.s[RSTable1DDescriptionOrigin] = table.x0;
         H->workers[i].range_weight_desc.s[RSTable1DDescriptionMaximum] = table.xm;
-        H->workers[i].mem_usage += (cl_uint)(table.xm + 1.0f) * sizeof(cl_float);
+        H->workers[i].mem_usage += (cl_uint)(table.xm + 1.0f) * (H->workers[i].weight_images ? sizeof(cl_float4) : sizeof(cl_float));
     }
     
-    RS_table_free(table);
+    // Keep the host copy for the placement density
+    RS_table_free(H->range_weight);
+    H->range_weight = table;
     
 }
 
@@ -2600,6 +3296,10 @@ void RS_set_angular_weight(RSHandle *H, const float *weights, const float table_
     
     cl_int ret;
     for (i = 0; i < H->num_workers; i++) {
+        if (RS_worker_fit_weight_table(H, i, table_size)) {
+            RS_table_free(table);
+            return;
+        }
         if (H->workers[i].angular_weight != NULL) {
             if (H->verb > 1) {
                 rsprint("workers[%d] setting angular weight.\n", i);
@@ -2609,7 +3309,7 @@ void RS_set_angular_weight(RSHandle *H, const float *weights, const float table_
         if (H->verb > 2) {
             rsprint("workers[%d] creating angular weight (cl_mem) & copying data from %p.", i, table.data);
         }
-        H->workers[i].angular_weight = clCreateBuffer(H->workers[i].context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, table_size * sizeof(float), table.data, &ret);
+        H->workers[i].angular_weight = RS_create_weight_table(&H->workers[i], table.data, table_size, &ret);
         if (ret != CL_SUCCESS) {
             rsprint("ERROR: Unable to create angular weight table on CL device.");
             return;
@@ -2626,10 +3326,12 @@ void RS_set_angular_weight(RSHandle *H, const float *weights, const float table_
         H->workers[i].angular_weight_desc.s[RSTable1DDescriptionScale] = table.dx;
         H->workers[i].angular_weight_desc.s[RSTable1DDescriptionOrigin] = table.x0;
         H->workers[i].angular_weight_desc.s[RSTable1DDescriptionMaximum] = table.xm;
-        H->workers[i].mem_usage += (cl_uint)(table.xm + 1.0f) * sizeof(cl_float);
+        H->workers[i].mem_usage += (cl_uint)(table.xm + 1.0f) * (H->workers[i].weight_images ? sizeof(cl_float4) : sizeof(cl_float));
     }
     
-    RS_table_free(table);
+    // Keep the host copy for the placement density
+    RS_table_free(H->angular_weight);
+    H->angular_weight = table;
 }
 
 
@@ -2926,6 +3628,14 @@ void RS_set_vel_data_to_LES_table(RSHandle *H, const LESTable *leslie) {
     table.uvwt = uvwt_orig;
     table.cpxx = cpxx_orig;
     
+    // Wind speed and cell size limit the adaptive time step
+    H->vel_max = 0.0f;
+    for (int k = 0; k < leslie->nn; k++) {
+        const float *u = leslie->uvwt[k];
+        H->vel_max = MAX(H->vel_max, sqrtf(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]));
+    }
+    H->vel_cell = leslie->is_stretched ? MIN(MIN(leslie->ax, leslie->ay), leslie->az) : MIN(MIN(leslie->rx, leslie->ry), leslie->rz);
+
     // Cache a copy of the parameters but not the data, the data could be deallocated immediately after this function call.
     H->vel_desc = *leslie;
     memset(&H->vel_desc.data, 0, sizeof(LESValue));
@@ -3118,7 +3828,9 @@ void RS_set_adm_data(RSHandle *H, const RSTable2D cd, const RSTable2D cm) {
             
 #endif
             
-            H->workers[i].mem_usage -= ((cl_uint)(H->workers[i].adm_desc[t].s8 + 1.0f) * (H->workers[i].adm_desc[t].s9 + 1.0f)) * 2 * sizeof(cl_float4);
+            if (!H->adm_shared[t]) {
+                H->workers[i].mem_usage -= ((cl_uint)(H->workers[i].adm_desc[t].s8 + 1.0f) * (H->workers[i].adm_desc[t].s9 + 1.0f)) * 2 * sizeof(cl_float4);
+            }
         }
         //  adm_cd & adm_cm always have the same desc
         
@@ -3188,14 +3900,69 @@ void RS_set_adm_data(RSHandle *H, const RSTable2D cd, const RSTable2D cm) {
         H->workers[i].adm_desc[t].s[RSTable3DDescriptionTachikawa] = H->adm_desc[t].phys.Ta;
         H->workers[i].mem_usage += ((cl_uint)(cd.xm + 1.0f) * (cd.ym + 1.0f)) * 2 * sizeof(cl_float4);
     }
+    H->adm_shared[t] = 0;
+    H->adm_count++;
+}
+
+
+#if !defined (_USE_GCL_)
+
+// Point the next ADM slot to the images of slot s, only the physical parameters differ
+void RS_share_adm_data(RSHandle *H, const int s) {
+    
+    int i;
+    
+    const int t = H->adm_count;
+    
+    if (H->verb > 1) {
+        rsprint("GPU ADM[%d] shares the images of ADM[%d]", t, s);
+    }
+    
+    for (i = 0; i < H->num_workers; i++) {
+        if (H->workers[i].adm_cd[t] != NULL && H->workers[i].adm_cm[t] != NULL) {
+            clReleaseMemObject(H->workers[i].adm_cd[t]);
+            clReleaseMemObject(H->workers[i].adm_cm[t]);
+            if (!H->adm_shared[t]) {
+                H->workers[i].mem_usage -= ((cl_uint)(H->workers[i].adm_desc[t].s8 + 1.0f) * (H->workers[i].adm_desc[t].s9 + 1.0f)) * 2 * sizeof(cl_float4);
+            }
+        }
+        clRetainMemObject(H->workers[i].adm_cd[s]);
+        clRetainMemObject(H->workers[i].adm_cm[s]);
+        H->workers[i].adm_cd[t] = H->workers[i].adm_cd[s];
+        H->workers[i].adm_cm[t] = H->workers[i].adm_cm[s];
+        H->workers[i].adm_desc[t] = H->workers[i].adm_desc[s];
+        H->workers[i].adm_desc[t].s[RSTable3DDescriptionRecipInLnX] = H->adm_desc[t].phys.inv_inln_x;
+        H->workers[i].adm_desc[t].s[RSTable3DDescriptionRecipInLnY] = H->adm_desc[t].phys.inv_inln_y;
+        H->workers[i].adm_desc[t].s[RSTable3DDescriptionRecipInLnZ] = H->adm_desc[t].phys.inv_inln_z;
+        H->workers[i].adm_desc[t].s[RSTable3DDescriptionTachikawa] = H->adm_desc[t].phys.Ta;
+    }
+    H->adm_shared[t] = 1;
     H->adm_count++;
 }
 
+#endif
+
 
 void RS_set_adm_data_to_ADM_table(RSHandle *H, const ADMTable *adam) {
     
     int i;
     
+#if !defined (_USE_GCL_)
+    
+    // Same physical table as an earlier slot, upload once and keep the parameters. The ADM cache gives one host copy
+    // per content, so the data pointer is the key, the hash guards against an address reused after a release
+    H->adm_key[H->adm_count] = adam->data.cdx;
+    for (i = 0; i < H->adm_count; i++) {
+        if (adam->hash && H->adm_desc[i].hash == adam->hash && H->adm_desc[i].nn == adam->nn && H->adm_key[i] == adam->data.cdx) {
+            H->adm_desc[H->adm_count] = *adam;
+            memset(&H->adm_desc[H->adm_count].data, 0, sizeof(ADMData));
+            RS_share_adm_data(H, i);
+            return;
+        }
+    }
+    
+#endif
+    
     RSTable2D cd = RS_table2d_init(adam->nn);
     RSTable2D cm = RS_table2d_init(adam->nn);
     
@@ -3247,6 +4014,10 @@ void RS_set_adm_data_to_unity(RSHandle *H) {
     
     RSTable2D table = RS_table2d_init(9);
     
+    // Not a file table, never shared
+    H->adm_desc[H->adm_count].hash = 0;
+    H->adm_key[H->adm_count] = NULL;
+    
     if (H->verb > 1) {
         rsprint("ADM to unity @ X:[ -M_PI - M_PI ]  Y:[ 0 - M_PI ]");
     }
@@ -3272,7 +4043,9 @@ void RS_clear_adm_data(RSHandle *H) {
         for (int t = 0; t < H->adm_count; t++) {
             cl_uint nx = (cl_uint)H->workers[i].adm_desc[t].s[RSTable3DDescriptionMaximumX] + 1;
             cl_uint ny = (cl_uint)H->workers[i].adm_desc[t].s[RSTable3DDescriptionMaximumY] + 1;
-            H->workers[i].mem_usage -= nx * ny * 2 * sizeof(cl_float4);
+            if (!H->adm_shared[t]) {
+                H->workers[i].mem_usage -= nx * ny * 2 * sizeof(cl_float4);
+            }
         }
     }
     H->adm_count = 0;
@@ -3329,7 +4102,10 @@ void RS_set_rcs_data(RSHandle *H, const RSTable2D real, const RSTable2D imag) {
             
 #endif
             
-            H->workers[i].mem_usage -= ((cl_uint)(H->workers[i].rcs_desc[t].s8 + 1.0f) * (H->workers[i].rcs_desc[t].s9 + 1.0f)) * 2 * sizeof(cl_float4);
+            if (!H->rcs_shared[t]) {
+                H->workers[i].mem_usage -= ((cl_uint)(H->workers[i].rcs_desc[t].s8 + 1.0f) * (H->workers[i].rcs_desc[t].s9 + 1.0f)) * 2 * sizeof(cl_float4);
+                H->workers[i].mem_usage -= RS_rcs_gamma_mem_size(H->workers[i].rcs_desc[t]);
+            }
         }
         //  rcs_real & rcs_imag always have the same desc
         
@@ -3396,103 +4172,336 @@ void RS_set_rcs_data(RSHandle *H, const RSTable2D real, const RSTable2D imag) {
         H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumX] = real.xm;
         H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumY] = real.ym;
         H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumZ] = 0.0f;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionRCSTolerance] = RS_rcs_tolerance_desc(H);
         H->workers[i].mem_usage += ((cl_uint)(real.xm + 1.0f) * (real.ym + 1.0f)) * 2 * sizeof(cl_float4);
     }
+    H->rcs_shared[t] = 0;
+    
+    // Kernels always take a 3-D table, this one keeps the projection in the kernel
+    cl_float4 zeros[8];
+    memset(zeros, 0, sizeof(zeros));
+    RSTable3D placeholder;
+    memset(&placeholder, 0, sizeof(RSTable3D));
+    placeholder.x_ = 2;
+    placeholder.y_ = 2;
+    placeholder.z_ = 2;
+    placeholder.uvwt = zeros;
+    RS_set_rcs_gamma_data(H, t, placeholder);
+    
     H->rcs_count++;
 }
 
 
-void RS_set_rcs_data_to_RCS_table(RSHandle *H, const RCSTable *rosie) {
-    
-    int i;
-    
-    RSTable2D real = RS_table2d_init(rosie->nn);
-    RSTable2D imag = RS_table2d_init(rosie->nn);
-    
-    if (real.data == NULL || imag.data == NULL) {
-        rsprint("ERROR: RCS input data cannot be NULL.");
-        return;
-    }
-    // Set up the mapping coefficients
-    // Assumptions: maps are always in alpha in [-180deg, +180deg] and beta in [0, +180deg]
-    real.x_ = rosie->na;    real.xm = (float)(real.x_ - 1);    real.xs = (float)(rosie->na - 1) / (2.0f * M_PI);    real.xo = -(-M_PI) * real.xs;
-    real.y_ = rosie->nb;    real.ym = (float)(real.y_ - 1);    real.ys = (float)(rosie->nb - 1) / M_PI;             real.yo = 0.0f;
-    
-    imag.x_ = rosie->na;    imag.xm = (float)(imag.x_ - 1);    imag.xs = (float)(rosie->na - 1) / (2.0f * M_PI);    imag.xo = -(-M_PI) * real.xs;
-    imag.y_ = rosie->nb;    imag.ym = (float)(imag.y_ - 1);    imag.ys = (float)(rosie->nb - 1) / M_PI;             imag.yo = 0.0f;
-    
-    // Arrange RCS values into float4, getting ready for GPU's global memory
-    for (i = 0; i < rosie->nn; i++) {
-        real.data[i].x = rosie->data.hh_real[i];
-        real.data[i].y = rosie->data.vv_real[i];
-        real.data[i].z = rosie->data.hv_real[i];
-        real.data[i].w = 0.0f;
-        imag.data[i].x = rosie->data.hh_imag[i];
-        imag.data[i].y = rosie->data.vv_imag[i];
-        imag.data[i].z = rosie->data.hv_imag[i];
-        imag.data[i].w = 0.0f;
-    }
-    
-    // Cache a copy of the parameters but not the data, the data could be deallocated immediately after this function call.
-    H->rcs_desc[H->rcs_count] = *rosie;
-    memset(&H->rcs_desc[H->rcs_count].data, 0, sizeof(RCSData));
-    
-    if (H->verb > 1) {
-        const int t = H->rcs_count;
-        rsprint("GPU RCS[%d]   lambda = %.2f m",
-                t, H->rcs_desc[t].lambda);
+size_t RS_rcs_gamma_mem_size(const cl_float16 desc) {
+    if (desc.s[RSTable3DDescriptionMaximumZ] == 0.0f) {
+        return 0;
     }
-    
-    RS_set_rcs_data(H, real, imag);
-    
-    RS_table2d_free(real);
-    RS_table2d_free(imag);
-    
+    return (size_t)(desc.s[RSTable3DDescriptionMaximumX] + 1.0f) * (size_t)(desc.s[RSTable3DDescriptionMaximumY] + 1.0f) * (size_t)(desc.s[RSTable3DDescriptionMaximumZ] + 1.0f) * sizeof(cl_float4);
 }
 
 
-void RS_set_rcs_data_to_unity(RSHandle *H) {
+// Gamma projected (Hi, Hq, Vi, Vq) of RCS slot t, a table with zm = 0 only fills the image argument
+void RS_set_rcs_gamma_data(RSHandle *H, const int t, const RSTable3D table) {
     
     int i;
     
-    RSTable2D table_real = RS_table2d_init(9);
-    RSTable2D table_imag = RS_table2d_init(9);
+    cl_image_format format = {CL_RGBA, CL_FLOAT};
     
-    if (H->verb > 1) {
-        rsprint("RCS to unity @ X:[ -M_PI - M_PI ]  Y:[ 0 - M_PI ]");
-    }
+#if defined (CL_VERSION_1_2)
     
-    table_real.x_ = 3;    table_real.xm = 2.0f;    table_real.xs = 3.0f / (2.0f * M_PI);    table_real.xo = -(-M_PI) * table_real.xs;
-    table_real.y_ = 3;    table_real.ym = 2.0f;    table_real.ys = 3.0f / M_PI;             table_real.yo = 0.0f;
+    cl_image_desc desc;
+    desc.image_type = CL_MEM_OBJECT_IMAGE3D;
+    desc.image_width  = table.x_;
+    desc.image_height = table.y_;
+    desc.image_depth  = table.z_;
+    desc.image_array_size = 0;
+    desc.image_row_pitch = desc.image_width * sizeof(cl_float4);
+    desc.image_slice_pitch = desc.image_height * desc.image_row_pitch;
+    desc.num_mip_levels = 0;
+    desc.num_samples = 0;
+    desc.buffer = NULL;
     
-    table_imag.x_ = 3;    table_imag.xm = 2.0f;    table_imag.xs = 3.0f / (2.0f * M_PI);    table_imag.xo = -(-M_PI) * table_imag.xs;
-    table_imag.y_ = 3;    table_imag.ym = 2.0f;    table_imag.ys = 3.0f / M_PI;             table_imag.yo = 0.0f;
+#endif
     
-    for (i =  0; i < 9; i++) {
-        table_real.data[i].x = 1.0f;
-        table_real.data[i].y = 1.0f;
-        table_real.data[i].z = 1.0f;
-        table_real.data[i].w = 0.0f;
+    for (i = 0; i < H->num_workers; i++) {
+        if (H->workers[i].rcs_gamma[t] != NULL) {
+            
+#if defined (_USE_GCL_)
+            
+            gcl_release_image(H->workers[i].rcs_gamma[t]);
+            
+#else
+            
+            clReleaseMemObject(H->workers[i].rcs_gamma[t]);
+            
+#endif
+            
+        }
         
-        table_imag.data[i].x = 0.0f;
-        table_imag.data[i].y = 0.0f;
-        table_imag.data[i].z = 0.0f;
-        table_imag.data[i].w = 0.0f;
-    }
-    
-    RS_set_rcs_data(H, table_real, table_imag);
-    
-    RS_table2d_free(table_real);
-    RS_table2d_free(table_imag);
-}
-
-
-void RS_clear_rcs_data(RSHandle *H) {
-    for (int i = 0; i < H->num_workers; i++) {
-        for (int t = 0; t < H->rcs_count; t++) {
+#if defined (_USE_GCL_)
+        
+        H->workers[i].rcs_gamma[t] = gcl_create_image(&format, table.x_, table.y_, table.z_, NULL);
+        
+#else
+        
+        cl_int ret;
+        cl_mem_flags flags = CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR;
+        
+#if defined (CL_VERSION_1_2)
+        
+        H->workers[i].rcs_gamma[t] = clCreateImage(H->workers[i].context, flags, &format, &desc, table.uvwt, &ret);
+        
+#else
+        
+        H->workers[i].rcs_gamma[t] = clCreateImage3D(H->workers[i].context, flags, &format, table.x_, table.y_, table.z_,
+                                                     table.x_ * sizeof(cl_float4), table.y_ * table.x_ * sizeof(cl_float4), table.uvwt, &ret);
+        
+#endif
+        
+#endif
+        
+        if (H->workers[i].rcs_gamma[t] == NULL) {
+            rsprint("ERROR: workers[%d] unable to create RCS gamma table of %d x %d x %d on CL device(s).", i, table.x_, table.y_, table.z_);
+            return;
+        }
+        
+#if defined (_USE_GCL_)
+        
+        dispatch_async(H->workers[i].que, ^{
+            size_t origin[3] = {0, 0, 0};
+            size_t region[3] = {table.x_, table.y_, table.z_};
+            gcl_copy_ptr_to_image(H->workers[i].rcs_gamma[t], table.uvwt, origin, region);
+            dispatch_semaphore_signal(H->workers[i].sem);
+        });
+        
+#endif
+        
+    }
+    
+    for (i = 0; i < H->num_workers; i++) {
+        
+#if defined (_USE_GCL_)
+        
+        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+        
+#endif
+        
+        if (table.zm == 0.0f) {
+            continue;
+        }
+        // The 3-D table replaces the 2-D lookup entirely, MaximumZ > 0 selects it in the kernel
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionScaleX] = table.xs;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionScaleY] = table.ys;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionScaleZ] = table.zs;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionOriginX] = table.xo;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionOriginY] = table.yo;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionOriginZ] = table.zo;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumX] = table.xm;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumY] = table.ym;
+        H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumZ] = table.zm;
+        if (!H->rcs_shared[t]) {
+            H->workers[i].mem_usage += RS_rcs_gamma_mem_size(H->workers[i].rcs_desc[t]);
+        }
+    }
+}
+
+
+#if !defined (_USE_GCL_)
+
+// Point the next RCS slot to the images of slot s
+void RS_share_rcs_data(RSHandle *H, const int s) {
+    
+    int i;
+    
+    const int t = H->rcs_count;
+    
+    if (H->verb > 1) {
+        rsprint("GPU RCS[%d] shares the images of RCS[%d]", t, s);
+    }
+    
+    for (i = 0; i < H->num_workers; i++) {
+        if (H->workers[i].rcs_real[t] != NULL && H->workers[i].rcs_imag[t] != NULL) {
+            clReleaseMemObject(H->workers[i].rcs_real[t]);
+            clReleaseMemObject(H->workers[i].rcs_imag[t]);
+            if (!H->rcs_shared[t]) {
+                H->workers[i].mem_usage -= ((cl_uint)(H->workers[i].rcs_desc[t].s8 + 1.0f) * (H->workers[i].rcs_desc[t].s9 + 1.0f)) * 2 * sizeof(cl_float4);
+                H->workers[i].mem_usage -= RS_rcs_gamma_mem_size(H->workers[i].rcs_desc[t]);
+            }
+        }
+        if (H->workers[i].rcs_gamma[t] != NULL) {
+            clReleaseMemObject(H->workers[i].rcs_gamma[t]);
+        }
+        clRetainMemObject(H->workers[i].rcs_real[s]);
+        clRetainMemObject(H->workers[i].rcs_imag[s]);
+        clRetainMemObject(H->workers[i].rcs_gamma[s]);
+        H->workers[i].rcs_real[t] = H->workers[i].rcs_real[s];
+        H->workers[i].rcs_imag[t] = H->workers[i].rcs_imag[s];
+        H->workers[i].rcs_gamma[t] = H->workers[i].rcs_gamma[s];
+        H->workers[i].rcs_desc[t] = H->workers[i].rcs_desc[s];
+    }
+    H->rcs_shared[t] = 1;
+    H->rcs_count++;
+}
+
+#endif
+
+
+void RS_set_rcs_data_to_RCS_table(RSHandle *H, const RCSTable *rosie) {
+    
+    int i;
+    
+#if !defined (_USE_GCL_)
+    
+    // Same physical table as an earlier slot, upload once, keyed as the ADM tables
+    H->rcs_key[H->rcs_count] = rosie->data.hh_real;
+    for (i = 0; i < H->rcs_count; i++) {
+        if (rosie->hash && H->rcs_desc[i].hash == rosie->hash && H->rcs_desc[i].nn == rosie->nn && H->rcs_key[i] == rosie->data.hh_real) {
+            H->rcs_desc[H->rcs_count] = *rosie;
+            memset(&H->rcs_desc[H->rcs_count].data, 0, sizeof(RCSData));
+            RS_share_rcs_data(H, i);
+            return;
+        }
+    }
+    
+#endif
+    
+    RSTable2D real = RS_table2d_init(rosie->nn);
+    RSTable2D imag = RS_table2d_init(rosie->nn);
+    
+    if (real.data == NULL || imag.data == NULL) {
+        rsprint("ERROR: RCS input data cannot be NULL.");
+        return;
+    }
+    // Set up the mapping coefficients
+    // Assumptions: maps are always in alpha in [-180deg, +180deg] and beta in [0, +180deg]
+    real.x_ = rosie->na;    real.xm = (float)(real.x_ - 1);    real.xs = (float)(rosie->na - 1) / (2.0f * M_PI);    real.xo = -(-M_PI) * real.xs;
+    real.y_ = rosie->nb;    real.ym = (float)(real.y_ - 1);    real.ys = (float)(rosie->nb - 1) / M_PI;             real.yo = 0.0f;
+    
+    imag.x_ = rosie->na;    imag.xm = (float)(imag.x_ - 1);    imag.xs = (float)(rosie->na - 1) / (2.0f * M_PI);    imag.xo = -(-M_PI) * real.xs;
+    imag.y_ = rosie->nb;    imag.ym = (float)(imag.y_ - 1);    imag.ys = (float)(rosie->nb - 1) / M_PI;             imag.yo = 0.0f;
+    
+    // Arrange RCS values into float4, getting ready for GPU's global memory
+    for (i = 0; i < rosie->nn; i++) {
+        real.data[i].x = rosie->data.hh_real[i];
+        real.data[i].y = rosie->data.vv_real[i];
+        real.data[i].z = rosie->data.hv_real[i];
+        real.data[i].w = 0.0f;
+        imag.data[i].x = rosie->data.hh_imag[i];
+        imag.data[i].y = rosie->data.vv_imag[i];
+        imag.data[i].z = rosie->data.hv_imag[i];
+        imag.data[i].w = 0.0f;
+    }
+    
+    // Cache a copy of the parameters but not the data, the data could be deallocated immediately after this function call.
+    H->rcs_desc[H->rcs_count] = *rosie;
+    memset(&H->rcs_desc[H->rcs_count].data, 0, sizeof(RCSData));
+    
+    if (H->verb > 1) {
+        const int t = H->rcs_count;
+        rsprint("GPU RCS[%d]   lambda = %.2f m",
+                t, H->rcs_desc[t].lambda);
+    }
+    
+    const int slot = H->rcs_count;
+    
+    RS_set_rcs_data(H, real, imag);
+    
+    RS_table2d_free(real);
+    RS_table2d_free(imag);
+    
+    if (H->rcs_gamma_count == 0 || H->rcs_count != slot + 1) {
+        return;
+    }
+    
+    // Bake the gamma projection (check smat.m for derivation) at the alpha-beta nodes of the table
+    const int ng = H->rcs_gamma_count;
+    RSTable3D table = RS_table3d_init(rosie->nn * ng);
+    if (table.uvwt == NULL) {
+        rsprint("ERROR: Unable to bake the RCS gamma table. Gamma projection stays in the kernel.");
+        return;
+    }
+    
+    // Alpha and beta use the same origins as the 2-D tables so that both paths read the same nodes. Gamma is exact in
+    // the 2-D path, so its nodes sit at the texel centers with an extra half texel
+    table.x_ = rosie->na;    table.xm = (float)(table.x_ - 1);    table.xs = (float)(rosie->na - 1) / (2.0f * M_PI);    table.xo = -(-M_PI) * table.xs;
+    table.y_ = rosie->nb;    table.ym = (float)(table.y_ - 1);    table.ys = (float)(rosie->nb - 1) / M_PI;             table.yo = 0.0f;
+    table.z_ = ng;           table.zm = (float)(table.z_ - 1);    table.zs = (float)(ng - 1) / (2.0f * M_PI);           table.zo = -(-M_PI) * table.zs + 0.5f;
+    
+    cl_float4 *g = table.uvwt;
+    for (int k = 0; k < ng; k++) {
+        const float angle = -M_PI + 2.0f * M_PI * (float)k / (float)(ng - 1);
+        const float cg = cosf(angle);
+        const float sg = sinf(angle);
+        for (i = 0; i < rosie->nn; i++) {
+            const float hh_r = rosie->data.hh_real[i], vv_r = rosie->data.vv_real[i], hv_r = rosie->data.hv_real[i];
+            const float hh_i = rosie->data.hh_imag[i], vv_i = rosie->data.vv_imag[i], hv_i = rosie->data.hv_imag[i];
+            g->x = cg * (cg * hh_r - hv_r * sg) - sg * (cg * hv_r - vv_r * sg);
+            g->y = cg * (cg * hh_i - hv_i * sg) - sg * (cg * hv_i - vv_i * sg);
+            g->z = cg * (cg * vv_r + hv_r * sg) + sg * (cg * hv_r + hh_r * sg);
+            g->w = cg * (cg * vv_i + hv_i * sg) + sg * (cg * hv_i + hh_i * sg);
+            g++;
+        }
+    }
+    
+    if (H->verb > 1) {
+        rsprint("GPU RCS[%d] gamma baked @ %d x %d x %d", slot, table.x_, table.y_, table.z_);
+    }
+    
+    RS_set_rcs_gamma_data(H, slot, table);
+    
+    RS_table3d_free(table);
+}
+
+
+void RS_set_rcs_data_to_unity(RSHandle *H) {
+    
+    int i;
+    
+    RSTable2D table_real = RS_table2d_init(9);
+    RSTable2D table_imag = RS_table2d_init(9);
+    
+    // Not a file table, never shared
+    H->rcs_desc[H->rcs_count].hash = 0;
+    H->rcs_key[H->rcs_count] = NULL;
+    
+    if (H->verb > 1) {
+        rsprint("RCS to unity @ X:[ -M_PI - M_PI ]  Y:[ 0 - M_PI ]");
+    }
+    
+    table_real.x_ = 3;    table_real.xm = 2.0f;    table_real.xs = 3.0f / (2.0f * M_PI);    table_real.xo = -(-M_PI) * table_real.xs;
+    table_real.y_ = 3;    table_real.ym = 2.0f;    table_real.ys = 3.0f / M_PI;             table_real.yo = 0.0f;
+    
+    table_imag.x_ = 3;    table_imag.xm = 2.0f;    table_imag.xs = 3.0f / (2.0f * M_PI);    table_imag.xo = -(-M_PI) * table_imag.xs;
+    table_imag.y_ = 3;    table_imag.ym = 2.0f;    table_imag.ys = 3.0f / M_PI;             table_imag.yo = 0.0f;
+    
+    for (i =  0; i < 9; i++) {
+        table_real.data[i].x = 1.0f;
+        table_real.data[i].y = 1.0f;
+        table_real.data[i].z = 1.0f;
+        table_real.data[i].w = 0.0f;
+        
+        table_imag.data[i].x = 0.0f;
+        table_imag.data[i].y = 0.0f;
+        table_imag.data[i].z = 0.0f;
+        table_imag.data[i].w = 0.0f;
+    }
+    
+    RS_set_rcs_data(H, table_real, table_imag);
+    
+    RS_table2d_free(table_real);
+    RS_table2d_free(table_imag);
+}
+
+
+void RS_clear_rcs_data(RSHandle *H) {
+    for (int i = 0; i < H->num_workers; i++) {
+        for (int t = 0; t < H->rcs_count; t++) {
             cl_uint nx = (cl_uint)H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumX] + 1;
             cl_uint ny = (cl_uint)H->workers[i].rcs_desc[t].s[RSTable3DDescriptionMaximumY] + 1;
-            H->workers[i].mem_usage -= nx * ny * 2 * sizeof(cl_float4);
+            if (!H->rcs_shared[t]) {
+                H->workers[i].mem_usage -= nx * ny * 2 * sizeof(cl_float4);
+                H->workers[i].mem_usage -= RS_rcs_gamma_mem_size(H->workers[i].rcs_desc[t]);
+            }
         }
     }
     H->rcs_count = 0;
@@ -3539,7 +4548,8 @@ void RS_add_debris(RSHandle *H, OBJConfig type, const size_t count) {
     OBJTable *obj_table = OBJ_get_table(H->O, type);
     RS_set_adm_data_to_ADM_table(H, obj_table->adm_table);
     RS_set_rcs_data_to_RCS_table(H, obj_table->rcs_table);
-    H->counts[k] = count;
+    // Only this partition's portion of the debris; the first few partitions get the remainders
+    H->counts[k] = count / H->partition_count + (H->partition_index < count % H->partition_count ? 1 : 0);
     H->num_types++;
     if (k != H->adm_count || k != H->rcs_count) {
         rsprint("WARNING: Inconsistent k = %d vs H->adm_count = %d vs H->rcs_count = %d.", k, H->adm_count, H->rcs_count);
@@ -3578,6 +4588,7 @@ void RS_update_auxiliary_attributes(RSHandle *H) {
                                 (cl_float4 *)H->workers[i].scat_rcs,
                                 (cl_float *)H->workers[i].angular_weight,
                                 H->workers[i].angular_weight_desc,
+                                H->workers[i].ellipsoid_count,
                                 H->sim_desc);
             dispatch_semaphore_signal(H->workers[i].sem);
         });
@@ -3637,8 +4648,11 @@ void RS_update_colors(RSHandle *H) {
                                       (cl_float4 *)C->scat_pos,
                                       (cl_float4 *)C->scat_ori,
                                       (cl_float4 *)C->scat_rcs,
+                                      (cl_float4 *)C->scat_rcq,
+                                      (cl_uint)C->counts[0],
                                       (cl_image)H->workers[i].rcs_real[r],
                                       (cl_image)H->workers[i].rcs_imag[r],
+                                      (cl_image)H->workers[i].rcs_gamma[r],
                                       H->workers[i].rcs_desc[r],
                                       H->sim_desc);
                         dispatch_semaphore_signal(C->sem);
@@ -3660,6 +4674,7 @@ void RS_update_colors(RSHandle *H) {
                                     (cl_float4 *)C->scat_rcs,
                                     (cl_float *)C->angular_weight,
                                     C->angular_weight_desc,
+                                    C->ellipsoid_count,
                                     H->sim_desc);
                 scat_clr_kernel(&C->ndrange_scat_all,
                                 (cl_float4 *)C->scat_clr,
@@ -3703,6 +4718,7 @@ void RS_update_colors(RSHandle *H) {
                 if (C->counts[k]) {
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionReal,         sizeof(cl_mem),     &C->rcs_real[r]);
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionImag,         sizeof(cl_mem),     &C->rcs_imag[r]);
+                    clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionGamma,        sizeof(cl_mem),     &C->rcs_gamma[r]);
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionDescription,  sizeof(cl_float16), &C->rcs_desc[r]);
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentSimulationDescription,         sizeof(cl_float16), &H->sim_desc);
                     clEnqueueNDRangeKernel(C->que, C->kern_db_rcs, 1, &C->origins[k], &C->counts[k], NULL, 0, NULL, &events[i][k]);
@@ -3802,10 +4818,13 @@ void RS_derive_ndranges(RSHandle *H) {
             }
         }
         
-        C->ndrange_pulse_pass_1.work_dim = 1;
+        C->ndrange_pulse_pass_1.work_dim = C->make_pulse_params.tile_count > 1 ? 2 : 1;
         C->ndrange_pulse_pass_1.global_work_offset[0] = 0;
         C->ndrange_pulse_pass_1.global_work_size[0] = C->make_pulse_params.global[0];
         C->ndrange_pulse_pass_1.local_work_size[0] = C->make_pulse_params.local[0];
+        C->ndrange_pulse_pass_1.global_work_offset[1] = 0;
+        C->ndrange_pulse_pass_1.global_work_size[1] = C->make_pulse_params.tile_count;
+        C->ndrange_pulse_pass_1.local_work_size[1] = 1;
         
         C->ndrange_pulse_pass_2.work_dim = 1;
         C->ndrange_pulse_pass_2.global_work_offset[0] = 0;
@@ -3858,100 +4877,372 @@ void RS_io_test(RSHandle *H) {
 }
 
 
-void RS_populate(RSHandle *H) {
-    
-    int i, k, n, w;
+// Importance-sampled placement: a coarse grid of cells over the domain where the probability of each cell follows the
+// angular and range weights along the scan pattern, plus a uniform floor so that no cell is left out. Each drop carries
+// the amplitude weight sqrt(1 / (N p)) of its cell, N cells with probability p, so the expected power stays unbiased.
+void RS_derive_placement(RSHandle *H) {
     
-    if (H->verb > 1) {
-        rsprint("RS_populate()   preferred_multiple = %s\n", commaint(H->preferred_multiple));
-    }
+    int i, j, k, n;
     
-    if (H->num_scats > RS_MAX_NUM_SCATS) {
-        rsprint("Number of scatterers exceed the maximum allowed. (%s > %s).\n", commaint(H->num_scats), commaint(RS_MAX_NUM_SCATS));
-        exit(EXIT_FAILURE);
-    }
+    free(H->placement);
+    H->placement = NULL;
+    H->placement_grid = 0;
     
-    size_t max_var_size;
-    CL_CHECK(clGetDeviceInfo(H->workers[0].dev, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_var_size), &max_var_size, NULL));
-    if (H->workers[0].num_scats * sizeof(cl_float4) > max_var_size) {
-        rsprint("ERROR: Every scatterer attribute occupies %s B > %s B.", commaint(H->workers[0].num_scats * sizeof(cl_float4)), commaint(max_var_size));
-        exit(EXIT_FAILURE);
+    if (!(H->sim_concept & RSSimulationConceptImportanceSampledPlacement)) {
+        return;
     }
-
-    // Set LES if they isn't set before
-    if (H->L == NULL) {
-        H->L = LES_init_with_config_path(LESConfigSuctionVortices, NULL);
+    if (H->sim_concept & RSSimulationConceptFixedScattererPosition || H->sector_width > 0.0f) {
+        rsprint("WARNING: Importance-sampled placement is not used with fixed scatterer positions or a sliding sector.");
+        return;
     }
-    
-    if (H->adm_count != H->rcs_count) {
-        rsprint("ADM & RCS are not consistent. Unexpected behavior may happen.");
+    if (H->angular_weight.data == NULL || H->range_weight.data == NULL) {
+        rsprint("WARNING: Importance-sampled placement needs the angular and range weights.");
+        return;
     }
     
-    // Use some default tables if there aren't any set
-    if (H->adm_count == 0) {
-        RS_set_adm_data_to_unity(H);
+    const int grid = RS_PLACEMENT_GRID;
+    const int count = grid * grid * grid;
+    
+    // Beam directions of the scan pattern, or the current beam without one
+    POSPattern *scan = (POSPattern *)H->P;
+    const bool has_scan = scan != NULL && !POS_is_empty(scan);
+    const int beam_count = has_scan ? scan->count : 1;
+    cl_float4 *beams = (cl_float4 *)malloc(beam_count * sizeof(cl_float4));
+    double *score = (double *)malloc(count * sizeof(double));
+    H->placement = (cl_float2 *)malloc(count * sizeof(cl_float2));
+    if (beams == NULL || score == NULL || H->placement == NULL) {
+        rsprint("ERROR: Unable to allocate the placement density.");
+        free(beams);
+        free(score);
+        free(H->placement);
+        H->placement = NULL;
+        return;
     }
-    if (H->rcs_count == 0) {
-        RS_set_rcs_data_to_unity(H);
+    if (has_scan) {
+        for (n = 0; n < beam_count; n++) {
+            const float az = scan->positions[n].az / 180.0f * M_PI;
+            const float el = scan->positions[n].el / 180.0f * M_PI;
+            beams[n].x = cosf(el) * sinf(az);
+            beams[n].y = cosf(el) * cosf(az);
+            beams[n].z = sinf(el);
+        }
+    } else {
+        beams[0].x = H->sim_desc.s[RSSimulationDescriptionBeamUnitX];
+        beams[0].y = H->sim_desc.s[RSSimulationDescriptionBeamUnitY];
+        beams[0].z = H->sim_desc.s[RSSimulationDescriptionBeamUnitZ];
     }
     
-    if (H->status & RSStatusDomainPopulated) {
-        rsprint("WARNING. Simulation was populated.");
-        exit(EXIT_FAILURE);
-    }
+    // Ranges covered by the range weight of the first and the last gates
+    const RSTable *rw = &H->range_weight;
+    const RSTable *aw = &H->angular_weight;
+    const float r_lo = H->params.range_start - rw->x0 / rw->dx;
+    const float r_hi = H->params.range_start + (float)(H->params.range_count - 1) * H->params.range_delta + (rw->xm - rw->x0) / rw->dx;
     
-    //
-    // CPU memory allocation
-    //
-    if (H->scat_pos != NULL) {
-        RS_free_scat_memory(H);
+    RSVolume domain = RS_get_domain(H);
+    const float cx = domain.size.x / (float)grid;
+    const float cy = domain.size.y / (float)grid;
+    const float cz = domain.size.z / (float)grid;
+    const float half = 0.5f * sqrtf(cx * cx + cy * cy + cz * cz);
+    
+    double total = 0.0;
+    for (k = 0; k < grid; k++) {
+        for (j = 0; j < grid; j++) {
+            for (i = 0; i < grid; i++) {
+                const float x = domain.origin.x + ((float)i + 0.5f) * cx;
+                const float y = domain.origin.y + ((float)j + 0.5f) * cy;
+                const float z = domain.origin.z + ((float)k + 0.5f) * cz;
+                const float r = sqrtf(x * x + y * y + z * z);
+                float w = 0.0f;
+                // Best weight anywhere in the cell, any part of it within the gates and the closest angle to a beam
+                if (r + half >= r_lo && r - half <= r_hi) {
+                    const float margin = r > half ? asinf(half / r) : M_PI;
+                    for (n = 0; n < beam_count; n++) {
+                        const float c = (x * beams[n].x + y * beams[n].y + z * beams[n].z) / r;
+                        const float a = MAX(0.0f, acosf(MIN(1.0f, MAX(-1.0f, c))) - margin);
+                        const float f = MIN(MAX(a * aw->dx + aw->x0, 0.0f), aw->xm);
+                        const int f0 = (int)f;
+                        const int f1 = MIN(f0 + 1, (int)aw->xm);
+                        w = MAX(w, aw->data[f0] + (aw->data[f1] - aw->data[f0]) * (f - (float)f0));
+                    }
+                }
+                score[(k * grid + j) * grid + i] = fabsf(w);
+                total += fabsf(w);
+            }
+        }
     }
+    free(beams);
     
-    posix_memalign((void **)&H->scat_uid, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_uint4));
-    posix_memalign((void **)&H->scat_pos, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_float4));
-    posix_memalign((void **)&H->scat_vel, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_float4));
-    posix_memalign((void **)&H->scat_ori, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_float4));
-    posix_memalign((void **)&H->scat_tum, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_float4));
-    posix_memalign((void **)&H->scat_aux, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_float4));
-    posix_memalign((void **)&H->scat_rcs, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_float4));
-    posix_memalign((void **)&H->scat_sig, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_float4));
-    posix_memalign((void **)&H->scat_rnd, RS_ALIGN_SIZE, H->num_scats * sizeof(cl_uint4));
-    posix_memalign((void **)&H->pulse, RS_ALIGN_SIZE, H->params.range_count * sizeof(cl_float4));
-    
-    if (H->scat_uid == NULL ||
-        H->scat_pos == NULL ||
-        H->scat_vel == NULL ||
-        H->scat_ori == NULL ||
-        H->scat_tum == NULL ||
-        H->scat_aux == NULL ||
-        H->scat_rcs == NULL ||
-        H->scat_sig == NULL ||
-        H->scat_rnd == NULL ||
-        H->pulse == NULL) {
-        rsprint("ERROR: Unable to allocate memory space for scatterers.");
+    if (total <= 0.0) {
+        rsprint("WARNING: The scan pattern does not look into the domain. Placement stays uniform.");
+        free(score);
+        free(H->placement);
+        H->placement = NULL;
         return;
     }
     
-    H->mem_size = H->num_scats * (8 * sizeof(cl_float4) + 2 * sizeof(cl_uint4)) + H->params.range_count * sizeof(cl_float4);
-    
-    char has_null = 0;
-    for (i = 0; i < H->num_workers; i++) {
-        posix_memalign((void **)&H->pulse_tmp[i], RS_ALIGN_SIZE, H->params.range_count * sizeof(cl_float4));
-        has_null |= H->pulse_tmp[i] == NULL;
-        H->mem_size += H->params.range_count * sizeof(cl_float4);
-    }
-    if (has_null) {
-        rsprint("ERROR: Unable to allocate memory space for pulses.");
-        return;
+    // Probability of each cell, the running sum is the cdf
+    double p, cdf = 0.0, beam_share = 0.0;
+    float w_min = INFINITY, w_max = 0.0f;
+    for (n = 0; n < count; n++) {
+        p = RS_PLACEMENT_FLOOR / (double)count + (1.0 - RS_PLACEMENT_FLOOR) * score[n] / total;
+        cdf += p;
+        H->placement[n].s[0] = (float)cdf;
+        H->placement[n].s[1] = (float)sqrt(1.0 / ((double)count * p));
+        w_min = MIN(w_min, H->placement[n].s[1]);
+        w_max = MAX(w_max, H->placement[n].s[1]);
+        if (score[n] > 0.0) {
+            beam_share += p;
+        }
     }
+    H->placement[count - 1].s[0] = 1.0f;
+    free(score);
     
-    // Get the available memory of the host
+    H->placement_grid = grid;
     
-#if defined(_SC_PHYS_PAGES)
+    sprintf(H->summary + strlen(H->summary), "Importance-sampled placement = %.1f %% of the drops where the beam looks\n", 100.0 * beam_share);
+    if (H->verb) {
+        rsprint("Importance-sampled placement: %d x %d x %d cells   %.1f %% where the beam looks   weight %.2f ~ %.2f",
+                grid, grid, grid, 100.0 * beam_share, w_min, w_max);
+    }
+}
+
+
+// Volume of the domain that is populated, the part of it within the sliding sector at the middle of the sweep
+RSfloat RS_sector_volume(RSHandle *H) {
     
-    long mem_pages = sysconf(_SC_PHYS_PAGES);
-    long mem_page_size = sysconf(_SC_PAGE_SIZE);
-    size_t host_mem = mem_pages * mem_page_size;
+    int i, j, k;
+    
+    RSVolume domain = RS_get_domain(H);
+    const RSfloat vol = domain.size.x * domain.size.y * domain.size.z;
+    if (H->sector_width == 0.0f) {
+        return vol;
+    }
+    
+    const int n = 64;
+    const RSfloat c = 0.5f * (H->params.azimuth_start_deg + H->params.azimuth_end_deg) / 180.0f * M_PI;
+    size_t inside = 0;
+    RSfloat x, y, d;
+    for (k = 0; k < n; k++) {
+        for (j = 0; j < n; j++) {
+            y = domain.origin.y + ((RSfloat)j + 0.5f) / (RSfloat)n * domain.size.y;
+            for (i = 0; i < n; i++) {
+                x = domain.origin.x + ((RSfloat)i + 0.5f) / (RSfloat)n * domain.size.x;
+                d = atan2f(x, y) - c;
+                d -= 2.0f * M_PI * rintf(d / (2.0f * M_PI));
+                inside += fabsf(d) <= H->sector_width;
+            }
+        }
+    }
+    return vol * (RSfloat)inside / (RSfloat)(n * n * n);
+}
+
+
+// Host counterpart of placement_sample() in rs.cl, a cell from the cdf then uniform within the cell
+void RS_placement_sample(RSHandle *H, cl_float4 *pos) {
+    const int grid = H->placement_grid;
+    // Uniform in [0, 1), u = 1 would step past the last cell of the cdf and a cell edge would be counted twice
+    const float u = (float)(rand() / (RAND_MAX + 1.0));
+    int lo = 0, hi = grid * grid * grid - 1, mid;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (u < H->placement[mid].s[0]) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    RSVolume domain = RS_get_domain(H);
+    pos->x = domain.origin.x + ((float)(lo % grid) + (float)(rand() / (RAND_MAX + 1.0))) / (float)grid * domain.size.x;
+    pos->y = domain.origin.y + ((float)(lo / grid % grid) + (float)(rand() / (RAND_MAX + 1.0))) / (float)grid * domain.size.y;
+    pos->z = domain.origin.z + ((float)(lo / (grid * grid)) + (float)(rand() / (RAND_MAX + 1.0))) / (float)grid * domain.size.z;
+}
+
+
+// Host counterpart of sector_sample() in rs.cl, uniform in the part of the domain within the sector about the beam
+void RS_sector_sample(RSHandle *H, cl_float4 *pos) {
+    RSVolume domain = RS_get_domain(H);
+    const float x_lo = domain.origin.x, x_hi = domain.origin.x + domain.size.x;
+    const float y_lo = domain.origin.y, y_hi = domain.origin.y + domain.size.y;
+    const float xc = MIN(MAX(0.0f, x_lo), x_hi), yc = MIN(MAX(0.0f, y_lo), y_hi);
+    const float xf = MAX(fabsf(x_lo), fabsf(x_hi)), yf = MAX(fabsf(y_lo), fabsf(y_hi));
+    const float r2_lo = xc * xc + yc * yc;
+    const float r2_hi = xf * xf + yf * yf;
+    const float beam = atan2f(H->sim_desc.s[RSSimulationDescriptionBeamUnitX], H->sim_desc.s[RSSimulationDescriptionBeamUnitY]);
+    float r, a;
+    for (int k = 0; k < 16; k++) {
+        r = sqrtf(r2_lo + (r2_hi - r2_lo) * (float)(rand() / (RAND_MAX + 1.0)));
+        a = beam + (2.0f * (float)(rand() / (RAND_MAX + 1.0)) - 1.0f) * H->sector_width;
+        pos->x = r * sinf(a);
+        pos->y = r * cosf(a);
+        pos->z = domain.origin.z + (float)(rand() / (RAND_MAX + 1.0)) * domain.size.z;
+        if (pos->x > x_lo && pos->x < x_hi && pos->y > y_lo && pos->y < y_hi) {
+            return;
+        }
+    }
+    pos->x = MIN(MAX(pos->x, x_lo + 1.0e-3f * domain.size.x), x_hi - 1.0e-3f * domain.size.x);
+    pos->y = MIN(MAX(pos->y, y_lo + 1.0e-3f * domain.size.y), y_hi - 1.0e-3f * domain.size.y);
+}
+
+
+// Volume and spread of the power weights for the background emulator, the drop moments come from RS_compute_rcs_ellipsoids()
+// The power of a gate at range r is the drop moments x volume / r^2
+void RS_derive_emulator(RSHandle *H) {
+    
+    int m;
+    
+    if (!H->bg_emulator) {
+        return;
+    }
+    if (H->angular_weight.data == NULL || H->range_weight.data == NULL) {
+        rsprint("WARNING: Background emulator needs the angular and range weights. There will be no background.");
+        H->emulator_desc.s[RSEmulatorDescriptionVolume] = 0.0f;
+        return;
+    }
+    
+    const RSTable *aw = &H->angular_weight;
+    const RSTable *rw = &H->range_weight;
+    double x, w2;
+    double solid = 0.0, solid_2 = 0.0;
+    double extent = 0.0, extent_2 = 0.0;
+    for (m = 0; m <= (int)aw->xm; m++) {
+        x = ((double)m - aw->x0) / aw->dx;
+        if (x >= 0.0 && x <= M_PI) {
+            w2 = aw->data[m] * aw->data[m] * 2.0 * M_PI * sin(x) / aw->dx;
+            solid += w2;
+            solid_2 += w2 * x * x;
+        }
+    }
+    for (m = 0; m <= (int)rw->xm; m++) {
+        x = ((double)m - rw->x0) / rw->dx;
+        w2 = rw->data[m] * rw->data[m] / rw->dx;
+        extent += w2;
+        extent_2 += w2 * x * x;
+    }
+    
+    H->emulator_desc.s[RSEmulatorDescriptionSigmaAngle] = solid > 0.0 ? (cl_float)sqrt(0.5 * solid_2 / solid) : 0.0f;
+    H->emulator_desc.s[RSEmulatorDescriptionSigmaRange] = extent > 0.0 ? (cl_float)sqrt(extent_2 / extent) : 0.0f;
+    H->emulator_desc.s[RSEmulatorDescriptionRangeStart] = H->params.range_start;
+    H->emulator_desc.s[RSEmulatorDescriptionRangeDelta] = H->params.range_delta;
+    H->emulator_desc.s[RSEmulatorDescriptionTimeStep] = 0.0f;
+    H->emulator_desc.s[RSEmulatorDescriptionScanCorrelation] = 0.0f;
+    H->emulator_desc.s[RSEmulatorDescriptionVolume] = (cl_float)(solid * extent);
+    H->emulator_tic = -1.0f;
+    
+    sprintf(H->summary + strlen(H->summary), "Background emulator = %.2f deg x %.1f m spread\n",
+            H->emulator_desc.s[RSEmulatorDescriptionSigmaAngle] * 180.0f / M_PI, H->emulator_desc.s[RSEmulatorDescriptionSigmaRange]);
+    if (H->verb) {
+        rsprint("Background emulator   sigma = %.2f deg x %.1f m   volume = %.3e r^2 m   fall = %.2f m/s",
+                H->emulator_desc.s[RSEmulatorDescriptionSigmaAngle] * 180.0f / M_PI, H->emulator_desc.s[RSEmulatorDescriptionSigmaRange],
+                solid * extent, H->emulator_desc.s[RSEmulatorDescriptionFallSpeed]);
+    }
+}
+
+
+// Time and beam motion since the last emulated pulse, both decorrelate the background
+void RS_emulator_step(RSHandle *H) {
+    const cl_float4 beam = {{
+        H->sim_desc.s[RSSimulationDescriptionBeamUnitX],
+        H->sim_desc.s[RSSimulationDescriptionBeamUnitY],
+        H->sim_desc.s[RSSimulationDescriptionBeamUnitZ],
+        0.0f
+    }};
+    if (H->emulator_tic < 0.0f) {
+        // The first pulse draws every gate afresh
+        H->emulator_desc.s[RSEmulatorDescriptionTimeStep] = 0.0f;
+        H->emulator_desc.s[RSEmulatorDescriptionScanCorrelation] = 0.0f;
+    } else {
+        // Overlap of the two-way amplitude patterns of Gaussian beams that are a apart
+        const float c = beam.s[0] * H->emulator_beam.s[0] + beam.s[1] * H->emulator_beam.s[1] + beam.s[2] * H->emulator_beam.s[2];
+        const float a = acosf(MIN(1.0f, MAX(-1.0f, c)));
+        const float s = H->emulator_desc.s[RSEmulatorDescriptionSigmaAngle];
+        H->emulator_desc.s[RSEmulatorDescriptionTimeStep] = H->sim_tic - H->emulator_tic;
+        H->emulator_desc.s[RSEmulatorDescriptionScanCorrelation] = s > 0.0f ? expf(-0.125f * a * a / (s * s)) : 1.0f;
+    }
+    H->emulator_beam = beam;
+    H->emulator_tic = H->sim_tic;
+}
+
+
+void RS_populate(RSHandle *H) {
+    
+    int i, k, n, w;
+    
+    if (H->verb > 1) {
+        rsprint("RS_populate()   preferred_multiple = %s\n", commaint(H->preferred_multiple));
+    }
+    
+    if (H->num_scats > RS_MAX_NUM_SCATS) {
+        rsprint("Number of scatterers exceed the maximum allowed. (%s > %s).\n", commaint(H->num_scats), commaint(RS_MAX_NUM_SCATS));
+        exit(EXIT_FAILURE);
+    }
+    
+    size_t max_var_size;
+    CL_CHECK(clGetDeviceInfo(H->workers[0].dev, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_var_size), &max_var_size, NULL));
+    if (H->workers[0].num_scats * sizeof(cl_float4) > max_var_size) {
+        rsprint("ERROR: Every scatterer attribute occupies %s B > %s B.", commaint(H->workers[0].num_scats * sizeof(cl_float4)), commaint(max_var_size));
+        exit(EXIT_FAILURE);
+    }
+
+    // Set LES if they isn't set before
+    if (H->L == NULL) {
+        H->L = LES_init_with_config_path(LESConfigSuctionVortices, NULL);
+    }
+    
+    if (H->adm_count != H->rcs_count) {
+        rsprint("ADM & RCS are not consistent. Unexpected behavior may happen.");
+    }
+    
+    // Use some default tables if there aren't any set
+    if (H->adm_count == 0) {
+        RS_set_adm_data_to_unity(H);
+    }
+    if (H->rcs_count == 0) {
+        RS_set_rcs_data_to_unity(H);
+    }
+    
+    if (H->status & RSStatusDomainPopulated) {
+        rsprint("WARNING. Simulation was populated.");
+        exit(EXIT_FAILURE);
+    }
+    
+    //
+    // CPU memory allocation
+    //
+    if (H->pulse != NULL) {
+        RS_stop_trajectory_recorder(H);
+        RS_free_scat_memory(H);
+    }
+    
+    // Scatterer attributes only have host copies when needed, see RS_alloc_host_mirrors()
+    posix_memalign((void **)&H->pulse, RS_ALIGN_SIZE, H->params.range_count * sizeof(cl_float4));
+    posix_memalign((void **)&H->moment_acc, RS_ALIGN_SIZE, 3 * H->params.range_count * sizeof(cl_float4));
+    
+    if (H->pulse == NULL ||
+        H->moment_acc == NULL) {
+        rsprint("ERROR: Unable to allocate memory space for pulses.");
+        return;
+    }
+    
+    H->mem_size = 4 * H->params.range_count * sizeof(cl_float4);
+    
+    char has_null = 0;
+    for (i = 0; i < H->num_workers; i++) {
+        posix_memalign((void **)&H->pulse_tmp[i], RS_ALIGN_SIZE, H->params.range_count * sizeof(cl_float4));
+        has_null |= H->pulse_tmp[i] == NULL;
+        H->mem_size += H->params.range_count * sizeof(cl_float4);
+    }
+    if (has_null) {
+        rsprint("ERROR: Unable to allocate memory space for pulses.");
+        return;
+    }
+    
+    // Get the available memory of the host
+    
+#if defined(_SC_PHYS_PAGES)
+    
+    long mem_pages = sysconf(_SC_PHYS_PAGES);
+    long mem_page_size = sysconf(_SC_PAGE_SIZE);
+    size_t host_mem = mem_pages * mem_page_size;
     
 #else
     
@@ -3975,13 +5266,26 @@ void RS_populate(RSHandle *H) {
     // Update scatterer origin and offset of each worker
     RS_update_origins_offsets(H);
     
+    // Cell density of the importance-sampled placement, if it is used
+    RS_derive_placement(H);
+    
+    // Randomly placed scatterers are generated by scat_pop directly on the devices, unless some debugging code needs the host copies
+#if !defined (_USE_GCL_) && !defined(DEBUG_RCS) && !defined(DEBUG_DEBRIS) && !defined(DEBUG_DSD)
+    const char on_device = !(H->sim_concept & RSSimulationConceptFixedScattererPosition);
+#else
+    const char on_device = 0;
+#endif
+    
+    if (!on_device && RS_alloc_host_mirrors(H)) {
+        return;
+    }
+    
     // Initialize the scatter body positions on CPU, will upload to the GPU later
-    srand(H->random_seed);
+    // Each partition of a population must have its own random sequence
+    srand(H->random_seed + H->partition_index);
     
     RSVolume domain = RS_get_domain(H);
     
-    uint32_t uid = 0;
-
     if (H->sim_concept & RSSimulationConceptFixedScattererPosition) {
         if (H->num_types > 1) {
             rsprint("WARNING. Debris particles are not emulated in RSSimulationConceptFixedScattererPosition mode.\n");
@@ -4009,11 +5313,6 @@ void RS_populate(RSHandle *H) {
         i = 0;
         for (n = 0; n < H->params.range_count; n++) {
             for (k = 0; k < anchors_per_layer; k++) {
-                H->scat_uid[i].s0 = uid++;
-                H->scat_uid[i].s1 = (cl_uint)H->num_scats;
-                H->scat_uid[i].s2 = 0;
-                H->scat_uid[i].s3 = 0;
-                
                 H->scat_pos[i].x = H->scat_pos[k].x / H->params.range_start * (H->params.range_start + (float)n * H->params.range_delta);
                 H->scat_pos[i].y = H->scat_pos[k].y / H->params.range_start * (H->params.range_start + (float)n * H->params.range_delta);
                 H->scat_pos[i].z = H->scat_pos[k].z / H->params.range_start * (H->params.range_start + (float)n * H->params.range_delta);
@@ -4057,106 +5356,110 @@ void RS_populate(RSHandle *H) {
             }
         }
     } else {
-        //
-        // Initialize the scatter body positions & velocities
-        //
-        for (k = 0; k < H->num_types; k++) {
-            for (w = 0; w < H->num_workers; w++) {
-                
-                i = (int)(H->offset[w] + H->workers[w].origins[k]);
-                
-                #ifdef DEBUG_HEAVY
-                rsprint(RS_INDENT "type[%d]   workers[%d]   n = %d", k, w,  H->workers[w].counts[k]);
-                #endif
-                
-                for (n = 0; n < H->workers[w].counts[k]; n++) {
-                    H->scat_uid[i].s0 = uid++;
-                    H->scat_uid[i].s1 = n;
-                    H->scat_uid[i].s2 = k;
-                    H->scat_uid[i].s3 = w;
-                    
-                    H->scat_pos[i].x = (float)rand() / RAND_MAX * domain.size.x + domain.origin.x;
-                    H->scat_pos[i].y = (float)rand() / RAND_MAX * domain.size.y + domain.origin.y;
-                    H->scat_pos[i].z = (float)rand() / RAND_MAX * domain.size.z + domain.origin.z;
-                    H->scat_pos[i].w = 0.0f;                       // Use this to store drop radius in m
-                    
-                    H->scat_aux[i].s0 = 0.0f;                      // range
-                    H->scat_aux[i].s1 = (float)rand() / RAND_MAX;  // age
-                    H->scat_aux[i].s2 = 0.0f;                      // dsd bin index
-                    H->scat_aux[i].s3 = 1.0f;                      // angular weight [0.0, 1.0]
-                    
-                    H->scat_vel[i].x = 0.0f;                       // u component of velocity
-                    H->scat_vel[i].y = 0.0f;                       // v component of velocity
-                    H->scat_vel[i].z = 0.0f;                       // w component of velocity
-                    H->scat_vel[i].w = 0.0f;                       // n/a
-                    
-                    // At the reference
-                    H->scat_ori[i].x = 0.0f;                       // x of quaternion
-                    H->scat_ori[i].y = 0.0f;                       // y of quaternion
-                    H->scat_ori[i].z = 0.0f;                       // z of quaternion
-                    H->scat_ori[i].w = 1.0f;                       // w of quaternion
-                    
-                    #if defined(QUAT_INIT_FACE_SKY)
-                    
-                    // Facing the sky
-                    H->scat_ori[i].x =  0.0f;                      // x of quaternion
-                    H->scat_ori[i].y = -0.707106781186547f;        // y of quaternion
-                    H->scat_ori[i].z =  0.0f;                      // z of quaternion
-                    H->scat_ori[i].w =  0.707106781186548f;        // w of quaternion
-                    
-                    #elif defined(QUAT_INIT_OTHER)
-                    
-                    // Some other tests
-                    H->scat_ori[i].x =  0.5f;                      // x of quaternion
-                    H->scat_ori[i].y = -0.5f;                      // y of quaternion
-                    H->scat_ori[i].z =  0.5f;                      // z of quaternion
-                    H->scat_ori[i].w =  0.5f;                      // w of quaternion
-                    
-                    #elif defined(QUAT_INIT_ROTATE_THETA)
+        if (!on_device) {
+            //
+            // Initialize the scatter body positions & velocities
+            //
+            for (k = 0; k < H->num_types; k++) {
+                for (w = 0; w < H->num_workers; w++) {
                     
-                    // Rotate by theta
-                    float theta = -70.0f / 180.0f * M_PI;
-                    H->scat_ori[i].x = 0.0f;
-                    H->scat_ori[i].y = sinf(0.5f * theta);
-                    H->scat_ori[i].z = 0.0f;
-                    H->scat_ori[i].w = cosf(0.5f * theta);
+                    i = (int)(H->offset[w] + H->workers[w].origins[k]);
                     
+                    #ifdef DEBUG_HEAVY
+                    rsprint(RS_INDENT "type[%d]   workers[%d]   n = %d", k, w,  H->workers[w].counts[k]);
                     #endif
                     
-                    // Facing the beam
-                    H->scat_ori[i].x =  0.5f;                      // x of quaternion
-                    H->scat_ori[i].y = -0.5f;                      // y of quaternion
-                    H->scat_ori[i].z = -0.5f;                      // z of quaternion
-                    H->scat_ori[i].w =  0.5f;                      // w of quaternion
-                    
-                    // Tumbling vector for orientation update
-                    H->scat_tum[i].x = 0.0f;                       // x of quaternion
-                    H->scat_tum[i].y = 0.0f;                       // y of quaternion
-                    H->scat_tum[i].z = 0.0f;                       // z of quaternion
-                    H->scat_tum[i].w = 1.0f;                       // w of quaternion
-                    
-                    // Initial return from each point
-                    H->scat_rcs[i].s0 = 1.0f;                      // sh_real of rcs
-                    H->scat_rcs[i].s1 = 0.0f;                      // sh_imag of rcs
-                    H->scat_rcs[i].s2 = 1.0f;                      // sv_real of rcs
-                    H->scat_rcs[i].s3 = 0.0f;                      // sv_imag of rcs
-                    
-                    // Random seeds
-                    H->scat_rnd[i].s0 = rand();                    // random seed
-                    H->scat_rnd[i].s1 = rand();                    // random seed
-                    H->scat_rnd[i].s2 = rand();                    // random seed
-                    H->scat_rnd[i].s3 = rand();                    // random seed
-                    
-                    i++;
-                }
-            } // for (w = 0; w < H->num_workers; w++) ...
-        } // for (k = 0; k < H->num_types; k++) ...
+                    for (n = 0; n < H->workers[w].counts[k]; n++) {
+                        H->scat_pos[i].x = (float)rand() / RAND_MAX * domain.size.x + domain.origin.x;
+                        H->scat_pos[i].y = (float)rand() / RAND_MAX * domain.size.y + domain.origin.y;
+                        H->scat_pos[i].z = (float)rand() / RAND_MAX * domain.size.z + domain.origin.z;
+                        H->scat_pos[i].w = 0.0f;                       // Use this to store drop radius in m
+                        
+                        H->scat_aux[i].s0 = 0.0f;                      // range
+                        H->scat_aux[i].s1 = (float)rand() / RAND_MAX;  // age
+                        H->scat_aux[i].s2 = 0.0f;                      // dsd bin index
+                        H->scat_aux[i].s3 = 1.0f;                      // angular weight [0.0, 1.0]
+                        
+                        H->scat_vel[i].x = 0.0f;                       // u component of velocity
+                        H->scat_vel[i].y = 0.0f;                       // v component of velocity
+                        H->scat_vel[i].z = 0.0f;                       // w component of velocity
+                        H->scat_vel[i].w = 0.0f;                       // n/a
+                        
+                        // At the reference
+                        H->scat_ori[i].x = 0.0f;                       // x of quaternion
+                        H->scat_ori[i].y = 0.0f;                       // y of quaternion
+                        H->scat_ori[i].z = 0.0f;                       // z of quaternion
+                        H->scat_ori[i].w = 1.0f;                       // w of quaternion
+                        
+                        #if defined(QUAT_INIT_FACE_SKY)
+                        
+                        // Facing the sky
+                        H->scat_ori[i].x =  0.0f;                      // x of quaternion
+                        H->scat_ori[i].y = -0.707106781186547f;        // y of quaternion
+                        H->scat_ori[i].z =  0.0f;                      // z of quaternion
+                        H->scat_ori[i].w =  0.707106781186548f;        // w of quaternion
+                        
+                        #elif defined(QUAT_INIT_OTHER)
+                        
+                        // Some other tests
+                        H->scat_ori[i].x =  0.5f;                      // x of quaternion
+                        H->scat_ori[i].y = -0.5f;                      // y of quaternion
+                        H->scat_ori[i].z =  0.5f;                      // z of quaternion
+                        H->scat_ori[i].w =  0.5f;                      // w of quaternion
+                        
+                        #elif defined(QUAT_INIT_ROTATE_THETA)
+                        
+                        // Rotate by theta
+                        float theta = -70.0f / 180.0f * M_PI;
+                        H->scat_ori[i].x = 0.0f;
+                        H->scat_ori[i].y = sinf(0.5f * theta);
+                        H->scat_ori[i].z = 0.0f;
+                        H->scat_ori[i].w = cosf(0.5f * theta);
+                        
+                        #endif
+                        
+                        // Facing the beam
+                        H->scat_ori[i].x =  0.5f;                      // x of quaternion
+                        H->scat_ori[i].y = -0.5f;                      // y of quaternion
+                        H->scat_ori[i].z = -0.5f;                      // z of quaternion
+                        H->scat_ori[i].w =  0.5f;                      // w of quaternion
+                        
+                        // Tumbling vector for orientation update
+                        H->scat_tum[i].x = 0.0f;                       // x of quaternion
+                        H->scat_tum[i].y = 0.0f;                       // y of quaternion
+                        H->scat_tum[i].z = 0.0f;                       // z of quaternion
+                        H->scat_tum[i].w = 1.0f;                       // w of quaternion
+                        
+                        // Initial return from each point
+                        H->scat_rcs[i].s0 = 1.0f;                      // sh_real of rcs
+                        H->scat_rcs[i].s1 = 0.0f;                      // sh_imag of rcs
+                        H->scat_rcs[i].s2 = 1.0f;                      // sv_real of rcs
+                        H->scat_rcs[i].s3 = 0.0f;                      // sv_imag of rcs
+                        
+                        // Random seeds
+                        H->scat_rnd[i].s0 = rand();                    // random seed
+                        H->scat_rnd[i].s1 = rand();                    // random seed
+                        H->scat_rnd[i].s2 = rand();                    // random seed
+                        H->scat_rnd[i].s3 = rand();                    // random seed
+                        
+                        // Drops may be concentrated where the beam will look
+                        if (k == 0 && H->placement) {
+                            RS_placement_sample(H, &H->scat_pos[i]);
+                        } else if (k == 0 && H->sector_width > 0.0f) {
+                            RS_sector_sample(H, &H->scat_pos[i]);
+                        }
+                        
+                        i++;
+                    }
+                } // for (w = 0; w < H->num_workers; w++) ...
+            } // for (k = 0; k < H->num_types; k++) ...
+        }
         
-        // Volume of the simulation domain (m^3)
-        float vol = H->sim_desc.s[RSSimulationDescriptionBoundSizeX] * H->sim_desc.s[RSSimulationDescriptionBoundSizeY] * H->sim_desc.s[RSSimulationDescriptionBoundSizeZ];
+        // Volume of the simulation domain (m^3), only the sliding sector if there is one
+        float vol = RS_sector_volume(H);
         
         // Re-initialize random seed
-        srand(H->random_seed + H->random_seed);
+        srand(H->random_seed + H->random_seed + H->partition_index);
         
         // Parameterized drop radius as scat_pos.w if DSD has been set
         // May want to add maximum relaxation time of each drop size
@@ -4164,7 +5467,8 @@ void RS_populate(RSHandle *H) {
         float a;
         int bin;
         if (H->dsd_name != RSDropSizeDistributionUndefined) {
-            float drops_per_scat = (vol * H->dsd_nd_sum) / H->counts[0];
+            // Scale with the total background population across all partitions
+            float drops_per_scat = (vol * H->dsd_nd_sum) / (H->counts[0] * H->partition_count);
             
             sprintf(H->summary + strlen(H->summary), "Drops / scatterer = %s  (%s / %s)\n", commafloat(drops_per_scat), commafloat((vol * H->dsd_nd_sum)), commaint(H->counts[0]));
             rsprint("Drops / scatterer = %s  (%s / %s)\n", commafloat(drops_per_scat), commafloat((vol * H->dsd_nd_sum)), commaint(H->counts[0]));
@@ -4172,7 +5476,9 @@ void RS_populate(RSHandle *H) {
             // Store a copy of concentration scale in simulation description
             H->sim_desc.s[RSSimulationDescriptionDropConcentrationScale] = sqrt(drops_per_scat);
             
-            if (H->sim_concept & RSSimulationConceptUniformDSDScaledRCS) {
+            if (on_device) {
+                // Drop radii and the population of each bin come from scat_pop
+            } else if (H->sim_concept & RSSimulationConceptUniformDSDScaledRCS) {
                 for (w = 0; w < H->num_workers; w++) {
                     i = (int)(H->offset[w] + H->workers[w].origins[0]);
                     for (n = 0; n < H->workers[w].counts[0]; n++) {
@@ -4217,38 +5523,9 @@ void RS_populate(RSHandle *H) {
 #endif
                 
             }
-            
-            sprintf(H->summary + strlen(H->summary),
-                    "DSD specifications:\n");
-            for (i = 0; i < MIN(H->dsd_count - 2, 3); i++) {
-                sprintf(H->summary + strlen(H->summary), "  o %.2f mm - P %.5f / %s particles\n", 2000.0f * H->dsd_r[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
-            }
-            if (H->dsd_count > 8) {
-                sprintf(H->summary + strlen(H->summary), "  o  :      -      :     /  :     /\n");
-                sprintf(H->summary + strlen(H->summary), "  o  :      -      :     /  :     /\n");
-                i = MAX(4, H->dsd_count - 1);
-            }
-            for (; i < H->dsd_count; i++) {
-                sprintf(H->summary + strlen(H->summary), "  o %.2f mm - P %.5f / %s particles\n", 2000.0f * H->dsd_r[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
-            }
-            
-            if (H->verb) {
-                rsprint("Actual DSD specifications:");
-                for (i = 0; i < MIN(H->dsd_count - 2, 3); i++) {
-                    printf(RS_INDENT "o %.2f mm - PDF %.5f / %.5f / %s particles\n", 2000.0f * H->dsd_r[i], H->dsd_pdf[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
-                }
-                if (H->dsd_count > 8) {
-                    printf(RS_INDENT "o  :      -      :     /  :     /\n");
-                    printf(RS_INDENT "o  :      -      :     /  :     /\n");
-                    i = MAX(4, H->dsd_count - 1);
-                }
-                for (; i < H->dsd_count; i++) {
-                    printf(RS_INDENT "o %.2f mm - PDF %.5f / %.5f / %s particles\n", 2000.0f * H->dsd_r[i], H->dsd_pdf[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
-                }
-            }
         } else {
             rsprint("INFO: No DSD specified. The meteorological scatterers do not return any power.");
-            float drops_per_scat = (vol * 1000.0f) / H->counts[0];
+            float drops_per_scat = (vol * 1000.0f) / (H->counts[0] * H->partition_count);
             
             sprintf(H->summary + strlen(H->summary), "Drops / scatterer = %s  (%s / %s)\n", commafloat(drops_per_scat), commafloat((vol * H->dsd_nd_sum)), commaint(H->counts[0]));
             rsprint("Drops / scatterer = %s  (%s / %s)\n", commafloat(drops_per_scat), commafloat((vol * H->dsd_nd_sum)), commaint(H->counts[0]));
@@ -4316,6 +5593,7 @@ void RS_populate(RSHandle *H) {
     // - ADM of debris table
     // - 3D wind table
     RS_compute_rcs_ellipsoids(H);
+    RS_derive_emulator(H);
     
     //
     // GPU memory allocation (probably should rename this to RS_worker_kernel_setup()
@@ -4345,8 +5623,18 @@ void RS_populate(RSHandle *H) {
     
     #endif
     
-    // Upload the particle parameters to the GPU
-    RS_upload(H);
+    // Upload the particle parameters to the GPU, or generate them there
+    if (on_device) {
+        RS_populate_on_device(H);
+    } else {
+        RS_upload(H);
+    }
+    
+    if (!(H->sim_concept & RSSimulationConceptFixedScattererPosition) && H->dsd_name != RSDropSizeDistributionUndefined) {
+        RS_summarize_dsd_population(H);
+    }
+    
+    RS_resolve_ellipsoid_rcs(H);
     
     if (H->verb) {
         rsprint("ADM / RCS count = %d / %d", H->adm_count, H->rcs_count);
@@ -4357,8 +5645,12 @@ void RS_populate(RSHandle *H) {
     
     // Advance time with 0 time so that all attributes kernels (el_atts, db_atts or bg_atts) are called once.
     H->sim_desc.s[RSSimulationDescriptionPRT] = 0.0f;
+    H->sim_desc.s[RSSimulationDescriptionPhysicsStep] = 0.0f;
+    memset(H->physics_count, 0, sizeof(H->physics_count));
     RS_advance_time(H);
+    memset(H->physics_count, 0, sizeof(H->physics_count));
     H->sim_desc.s[RSSimulationDescriptionPRT] = H->params.prt;
+    H->sim_desc.s[RSSimulationDescriptionPhysicsStep] = H->params.prt;
     H->sim_tic -= H->params.prt;
     H->sim_desc.s[RSSimulationDescriptionSimTic] = H->sim_tic;
     
@@ -4366,168 +5658,941 @@ void RS_populate(RSHandle *H) {
 }
 
 
-void RS_download(RSHandle *H) {
+// Drop radii are fixed, so the H and V coefficients are resolved once here and scat_sig_aux blends them with the elevation,
+// along with the amplitude weight of the importance-sampled placement
+void RS_resolve_ellipsoid_rcs(RSHandle *H) {
     
     int i;
     
-#if defined (_USE_GCL_)
+    for (i = 0; i < H->num_workers; i++) {
+        RSWorker *C = &H->workers[i];
+        // Fixed scatterers keep their Cn2 phasor in scat_rcs
+        C->ellipsoid_count = H->sim_concept & RSSimulationConceptFixedScattererPosition ? 0 : (cl_uint)C->counts[0];
+    }
     
-    //printf("%p <-----------------------\n", H->scat_ori);
+#if defined (_USE_GCL_)
     
     for (i = 0; i < H->num_workers; i++) {
-        dispatch_async(H->workers[i].que, ^{
-            gcl_memcpy(H->scat_pos + H->offset[i], H->workers[i].scat_pos, H->workers[i].num_scats * sizeof(cl_float4));
-            gcl_memcpy(H->scat_vel + H->offset[i], H->workers[i].scat_vel, H->workers[i].num_scats * sizeof(cl_float4));
-            gcl_memcpy(H->scat_ori + H->offset[i], H->workers[i].scat_ori, H->workers[i].num_scats * sizeof(cl_float4));
-            gcl_memcpy(H->scat_aux + H->offset[i], H->workers[i].scat_aux, H->workers[i].num_scats * sizeof(cl_float4));
-            gcl_memcpy(H->scat_rcs + H->offset[i], H->workers[i].scat_rcs, H->workers[i].num_scats * sizeof(cl_float4));
-            gcl_memcpy(H->scat_sig + H->offset[i], H->workers[i].scat_sig, H->workers[i].num_scats * sizeof(cl_float4));
-            gcl_memcpy(H->pulse_tmp[i], H->workers[i].pulse, H->params.range_count * sizeof(cl_float4));
-            dispatch_semaphore_signal(H->workers[i].sem);
+        RSWorker *C = &H->workers[i];
+        if (C->ellipsoid_count == 0) {
+            continue;
+        }
+        dispatch_async(C->que, ^{
+            el_rcs_kernel(&C->ndrange_scat[0],
+                          (cl_float4 *)C->scat_pos,
+                          (cl_float4 *)C->scat_rcs,
+                          (cl_float4 *)C->rcs_ellipsoid,
+                          C->rcs_ellipsoid_desc,
+                          (cl_float2 *)C->placement,
+                          H->placement_grid,
+                          H->sim_desc);
+            dispatch_semaphore_signal(C->sem);
         });
-        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
     }
-    
-#else
-    
-    int k;
-    
-    cl_event events[H->num_workers][7];
-    
-    // Non-blocking read, wait for events later when they are all queued up.
     for (i = 0; i < H->num_workers; i++) {
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_pos, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_pos + H->offset[i], 0, NULL, &events[i][0]);
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_vel, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_vel + H->offset[i], 0, NULL, &events[i][1]);
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_ori, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_ori + H->offset[i], 0, NULL, &events[i][2]);
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_aux, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_aux + H->offset[i], 0, NULL, &events[i][3]);
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_rcs, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_rcs + H->offset[i], 0, NULL, &events[i][4]);
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_sig, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_sig + H->offset[i], 0, NULL, &events[i][5]);
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].pulse, CL_FALSE, 0, H->params.range_count * sizeof(cl_float4), H->pulse_tmp[i], 0, NULL, &events[i][6]);
+        if (H->workers[i].ellipsoid_count) {
+            dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+        }
     }
     
+#else
+    
     cl_int ret;
     
     for (i = 0; i < H->num_workers; i++) {
-        ret = clWaitForEvents(7, events[i]);
+        RSWorker *C = &H->workers[i];
+        clSetKernelArg(C->kern_scat_sig_aux, RSScattererAngularWeightKernalArgumentEllipsoidCount, sizeof(cl_uint), &C->ellipsoid_count);
+        if (C->ellipsoid_count == 0) {
+            continue;
+        }
+        ret = CL_SUCCESS;
+        ret |= clSetKernelArg(C->kern_el_rcs, RSEllipsoidRCSKernelArgumentPosition,                sizeof(cl_mem),     &C->scat_pos);
+        ret |= clSetKernelArg(C->kern_el_rcs, RSEllipsoidRCSKernelArgumentRadarCrossSection,       sizeof(cl_mem),     &C->scat_rcs);
+        ret |= clSetKernelArg(C->kern_el_rcs, RSEllipsoidRCSKernelArgumentEllipsoidRCS,            sizeof(cl_mem),     &C->rcs_ellipsoid);
+        ret |= clSetKernelArg(C->kern_el_rcs, RSEllipsoidRCSKernelArgumentEllipsoidRCSDescription, sizeof(cl_float4),  &C->rcs_ellipsoid_desc);
+        ret |= clSetKernelArg(C->kern_el_rcs, RSEllipsoidRCSKernelArgumentPlacement,               sizeof(cl_mem),     &C->placement);
+        ret |= clSetKernelArg(C->kern_el_rcs, RSEllipsoidRCSKernelArgumentPlacementGrid,           sizeof(cl_uint),    &H->placement_grid);
+        ret |= clSetKernelArg(C->kern_el_rcs, RSEllipsoidRCSKernelArgumentSimulationDescription,   sizeof(cl_float16), &H->sim_desc);
         if (ret != CL_SUCCESS) {
-            rsprint("ERROR: Unable to properly read back the values.");
+            fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_el_rcs().\n", now());
+            exit(EXIT_FAILURE);
         }
-        for (k = 0; k < 7; k++) {
-            clReleaseEvent(events[i][k]);
+        ret = clEnqueueNDRangeKernel(C->que, C->kern_el_rcs, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, NULL);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to resolve the ellipsoid RCS on worker %d.  ret = %d", i, ret);
         }
     }
+    for (i = 0; i < H->num_workers; i++) {
+        clFinish(H->workers[i].que);
+    }
     
 #endif
     
-    RS_merge_pulse_tmp(H);
 }
 
 
-void RS_download_position_only(RSHandle *H) {
-    
-    int i;
+// Generate the scatterer attributes with scat_pop on each device, nothing goes through the host mirrors
+void RS_populate_on_device(RSHandle *H) {
     
 #if defined (_USE_GCL_)
     
+    rsprint("ERROR: Population on the device is not available with GCL.");
+    
+#else
+    
+    int i, k;
+    cl_int ret;
+    size_t local, global;
+    
+    const cl_uint dsd_count = H->dsd_name == RSDropSizeDistributionUndefined ? 0 : (cl_uint)H->dsd_count;
+    const cl_uint dsd_mode = dsd_count == 0 ? 0 : (H->sim_concept & RSSimulationConceptUniformDSDScaledRCS ? 2 : 1);
+    const cl_uint no_dsd = 0;                                            // Also no placement grid
+    const cl_float no_sector = 0.0f;
+    const cl_uint seed = H->random_seed + H->partition_index;
+    const size_t dsd_numel = MAX(1, dsd_count);
+    cl_uint dsd_pop[dsd_numel];
+    
     for (i = 0; i < H->num_workers; i++) {
-        dispatch_async(H->workers[i].que, ^{
-            gcl_memcpy(H->scat_pos + H->offset[i], H->workers[i].scat_pos, H->workers[i].num_scats * sizeof(cl_float4));
-            dispatch_semaphore_signal(H->workers[i].sem);
-        });
-        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+        RSWorker *C = &H->workers[i];
+        
+        // DSD tables are tiny, a single element stands in when there is no DSD
+        memset(dsd_pop, 0, sizeof(dsd_pop));
+        cl_mem pop = clCreateBuffer(C->context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, dsd_numel * sizeof(cl_uint), dsd_pop, &ret);                             CHECK_CL_CREATE_BUFFER
+        cl_mem cdf = clCreateBuffer(C->context, CL_MEM_READ_ONLY | (dsd_count ? CL_MEM_COPY_HOST_PTR : 0), dsd_numel * sizeof(cl_float), dsd_count ? H->dsd_cdf : NULL, &ret); CHECK_CL_CREATE_BUFFER
+        cl_mem rad = clCreateBuffer(C->context, CL_MEM_READ_ONLY | (dsd_count ? CL_MEM_COPY_HOST_PTR : 0), dsd_numel * sizeof(cl_float), dsd_count ? H->dsd_r : NULL, &ret);   CHECK_CL_CREATE_BUFFER
+        
+        const cl_uint index_offset = (cl_uint)H->offset[i];
+        
+        ret = CL_SUCCESS;
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentPosition,              sizeof(cl_mem),               &C->scat_pos);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentOrientation,           sizeof(cl_mem),               &C->scat_ori);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentVelocity,              sizeof(cl_mem),               &C->scat_vel);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentTumble,                sizeof(cl_mem),               &C->scat_tum);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentAuxiliary,             sizeof(cl_mem),               &C->scat_aux);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentRadarCrossSection,     sizeof(cl_mem),               &C->scat_rcs);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentRandomSeed,            sizeof(cl_mem),               &C->scat_rnd);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentDropSizePopulation,    sizeof(cl_mem),               &pop);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentDropSizeHistogram,     dsd_numel * sizeof(cl_uint),  NULL);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentDropSizeCDF,           sizeof(cl_mem),               &cdf);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentDropSizeRadius,        sizeof(cl_mem),               &rad);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentDropSizeCount,         sizeof(cl_uint),              &dsd_count);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentPlacement,             sizeof(cl_mem),               &C->placement);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentSeed,                  sizeof(cl_uint),              &seed);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentIndexOffset,           sizeof(cl_uint),              &index_offset);
+        ret |= clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentSimulationDescription, sizeof(cl_float16),           &H->sim_desc);
+        if (ret != CL_SUCCESS) {
+            fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_scat_pop().\n", now());
+            exit(EXIT_FAILURE);
+        }
+        
+        clGetKernelWorkGroupInfo(C->kern_scat_pop, C->dev, CL_KERNEL_WORK_GROUP_SIZE, sizeof(local), &local, NULL);
+        local = MAX(1, MIN(local, RS_CL_GROUP_ITEMS));
+        
+        // Only the background gets the drop sizes and the importance-sampled placement
+        for (k = 0; k < H->num_types; k++) {
+            if (C->counts[k] == 0) {
+                continue;
+            }
+            const cl_uint count = (cl_uint)C->counts[k];
+            global = (C->counts[k] + local - 1) / local * local;
+            clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentDropSizeMode, sizeof(cl_uint), k == 0 ? &dsd_mode : &no_dsd);
+            clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentPlacementGrid, sizeof(cl_uint), k == 0 ? &H->placement_grid : &no_dsd);
+            clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentSectorWidth,  sizeof(cl_float), k == 0 ? &H->sector_width : &no_sector);
+            clSetKernelArg(C->kern_scat_pop, RSScattererPopulationKernelArgumentCount,        sizeof(cl_uint), &count);
+            ret = clEnqueueNDRangeKernel(C->que, C->kern_scat_pop, 1, &C->origins[k], &global, &local, 0, NULL, NULL);
+            if (ret != CL_SUCCESS) {
+                rsprint("ERROR: Unable to populate type %d on worker %d.  ret = %d", k, i, ret);
+            }
+        }
+        
+        clEnqueueReadBuffer(C->que, pop, CL_TRUE, 0, dsd_numel * sizeof(cl_uint), dsd_pop, 0, NULL, NULL);
+        for (k = 0; k < (int)dsd_count; k++) {
+            H->dsd_pop[k] += dsd_pop[k];
+        }
+        
+        clReleaseMemObject(pop);
+        clReleaseMemObject(cdf);
+        clReleaseMemObject(rad);
+    }
+    
+    if (H->verb) {
+        rsprint("Population generated on %d device(s).", H->num_workers);
+    }
+    
+#endif
+    
+}
+
+
+void RS_summarize_dsd_population(RSHandle *H) {
+    
+    int i;
+    
+    sprintf(H->summary + strlen(H->summary),
+            "DSD specifications:\n");
+    for (i = 0; i < MIN(H->dsd_count - 2, 3); i++) {
+        sprintf(H->summary + strlen(H->summary), "  o %.2f mm - P %.5f / %s particles\n", 2000.0f * H->dsd_r[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
+    }
+    if (H->dsd_count > 8) {
+        sprintf(H->summary + strlen(H->summary), "  o  :      -      :     /  :     /\n");
+        sprintf(H->summary + strlen(H->summary), "  o  :      -      :     /  :     /\n");
+        i = MAX(4, H->dsd_count - 1);
+    }
+    for (; i < H->dsd_count; i++) {
+        sprintf(H->summary + strlen(H->summary), "  o %.2f mm - P %.5f / %s particles\n", 2000.0f * H->dsd_r[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
+    }
+    
+    if (H->verb) {
+        rsprint("Actual DSD specifications:");
+        for (i = 0; i < MIN(H->dsd_count - 2, 3); i++) {
+            printf(RS_INDENT "o %.2f mm - PDF %.5f / %.5f / %s particles\n", 2000.0f * H->dsd_r[i], H->dsd_pdf[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
+        }
+        if (H->dsd_count > 8) {
+            printf(RS_INDENT "o  :      -      :     /  :     /\n");
+            printf(RS_INDENT "o  :      -      :     /  :     /\n");
+            i = MAX(4, H->dsd_count - 1);
+        }
+        for (; i < H->dsd_count; i++) {
+            printf(RS_INDENT "o %.2f mm - PDF %.5f / %.5f / %s particles\n", 2000.0f * H->dsd_r[i], H->dsd_pdf[i], (float)H->dsd_pop[i] / (float)H->counts[0], commaint(H->dsd_pop[i]));
+        }
+    }
+}
+
+
+void RS_download(RSHandle *H) {
+    
+    int i;
+    
+    // Host mirrors are made on the first download
+    if (RS_alloc_host_mirrors(H)) {
+        return;
+    }
+    
+#if defined (_USE_GCL_)
+    
+    //printf("%p <-----------------------\n", H->scat_ori);
+    
+    for (i = 0; i < H->num_workers; i++) {
+        dispatch_async(H->workers[i].que, ^{
+            gcl_memcpy(H->scat_pos + H->offset[i], H->workers[i].scat_pos, H->workers[i].num_scats * sizeof(cl_float4));
+            gcl_memcpy(H->scat_vel + H->offset[i], H->workers[i].scat_vel, H->workers[i].num_scats * sizeof(cl_float4));
+            gcl_memcpy(H->scat_ori + H->offset[i], H->workers[i].scat_ori, H->workers[i].num_scats * sizeof(cl_float4));
+            gcl_memcpy(H->scat_aux + H->offset[i], H->workers[i].scat_aux, H->workers[i].num_scats * sizeof(cl_float4));
+            gcl_memcpy(H->scat_rcs + H->offset[i], H->workers[i].scat_rcs, H->workers[i].num_scats * sizeof(cl_float4));
+            gcl_memcpy(H->scat_sig + H->offset[i], H->workers[i].scat_sig, H->workers[i].num_scats * sizeof(cl_float4));
+            gcl_memcpy(H->scat_tum + H->offset[i], H->workers[i].scat_tum, H->workers[i].num_scats * sizeof(cl_float4));
+            gcl_memcpy(H->scat_rnd + H->offset[i], H->workers[i].scat_rnd, H->workers[i].num_scats * sizeof(cl_uint4));
+            gcl_memcpy(H->pulse_tmp[i], H->workers[i].pulse, H->params.range_count * sizeof(cl_float4));
+            dispatch_semaphore_signal(H->workers[i].sem);
+        });
+        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+    }
+    
+#else
+    
+    int k;
+    
+    cl_event events[H->num_workers][9];
+    
+    // Non-blocking read, wait for events later when they are all queued up.
+    for (i = 0; i < H->num_workers; i++) {
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_pos, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_pos + H->offset[i], 0, NULL, &events[i][0]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_vel, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_vel + H->offset[i], 0, NULL, &events[i][1]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_ori, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_ori + H->offset[i], 0, NULL, &events[i][2]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_aux, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_aux + H->offset[i], 0, NULL, &events[i][3]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_rcs, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_rcs + H->offset[i], 0, NULL, &events[i][4]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_sig, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_sig + H->offset[i], 0, NULL, &events[i][5]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_tum, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_tum + H->offset[i], 0, NULL, &events[i][6]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_rnd, CL_FALSE, 0, H->workers[i].num_scats * sizeof(cl_uint4),  H->scat_rnd + H->offset[i], 0, NULL, &events[i][7]);
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].pulse, CL_FALSE, 0, H->params.range_count * sizeof(cl_float4), H->pulse_tmp[i], 0, NULL, &events[i][8]);
+    }
+    
+    cl_int ret;
+    
+    for (i = 0; i < H->num_workers; i++) {
+        ret = clWaitForEvents(9, events[i]);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to properly read back the values.");
+        }
+        for (k = 0; k < 9; k++) {
+            clReleaseEvent(events[i][k]);
+        }
+    }
+    
+#endif
+    
+    RS_merge_pulse_tmp(H);
+}
+
+
+void RS_download_position_only(RSHandle *H) {
+    
+    int i;
+    
+    // Host mirrors are made on the first download
+    if (RS_alloc_host_mirrors(H)) {
+        return;
+    }
+    
+#if defined (_USE_GCL_)
+    
+    for (i = 0; i < H->num_workers; i++) {
+        dispatch_async(H->workers[i].que, ^{
+            gcl_memcpy(H->scat_pos + H->offset[i], H->workers[i].scat_pos, H->workers[i].num_scats * sizeof(cl_float4));
+            dispatch_semaphore_signal(H->workers[i].sem);
+        });
+        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+    }
+    
+#else
+    
+    for (i = 0; i < H->num_workers; i++) {
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_pos, CL_TRUE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_pos + H->offset[i], 0, NULL, NULL);
+    }
+    
+#endif
+    
+}
+
+void RS_download_orientation_only(RSHandle *H) {
+    
+    int i;
+    
+    // Host mirrors are made on the first download
+    if (RS_alloc_host_mirrors(H)) {
+        return;
+    }
+    
+#if defined (_USE_GCL_)
+    
+    for (i = 0; i < H->num_workers; i++) {
+        dispatch_async(H->workers[i].que, ^{
+            gcl_memcpy(H->scat_ori + H->offset[i], H->workers[i].scat_ori, H->workers[i].num_scats * sizeof(cl_float4));
+            dispatch_semaphore_signal(H->workers[i].sem);
+        });
+        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+    }
+    
+#else
+    
+    for (i = 0; i < H->num_workers; i++) {
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_ori, CL_TRUE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_ori + H->offset[i], 0, NULL, NULL);
+    }
+    
+#endif
+    
+}
+
+//
+// Scale the amplitude by antenna gain, tx power
+// Amplitude scaling, Ga = 10 ^ (Gt / 20) * 10 ^ (Gr / 20) * sqrt(Pt)
+// For dish antennas: Gt = Gr
+//
+//                  => g = 10 ^ (G / 20) * 10 ^ (G / 20) * sqrt(Pt)
+//                       = 10 ^ (G / 10) * sqrt(Pt)
+//
+// Amplitude scale to 1-km referece: sqrt(R ^ 4) = R ^ 2 = 1.0e6
+//
+float RS_pulse_amplitude_gain(RSHandle *H) {
+    return powf(10.0f, 0.1f * H->params.antenna_gain_dbi) * sqrtf(H->params.tx_power_watt) / (4.0f * M_PI) * 1.0e6f;
+}
+
+void RS_merge_pulse_tmp(RSHandle *H) {
+    memcpy(H->pulse, H->pulse_tmp[0], H->params.range_count * sizeof(cl_float4));
+    for (int i = 1; i < H->num_workers; i++) {
+        for (int k = 0; k < H->params.range_count; k++) {
+            H->pulse[k].s0 += H->pulse_tmp[i][k].s0;
+            H->pulse[k].s1 += H->pulse_tmp[i][k].s1;
+            H->pulse[k].s2 += H->pulse_tmp[i][k].s2;
+            H->pulse[k].s3 += H->pulse_tmp[i][k].s3;
+        }
+    }
+    float g = RS_pulse_amplitude_gain(H);
+    for (int k = 0; k < H->params.range_count; k++) {
+        H->pulse[k].s0 *= g;
+        H->pulse[k].s1 *= g;
+        H->pulse[k].s2 *= g;
+        H->pulse[k].s3 *= g;
+    }
+}
+
+void RS_download_pulse_only(RSHandle *H) {
+    
+    int i;
+    
+#if defined (_USE_GCL_)
+    
+    for (i = 0; i < H->num_workers; i++) {
+        dispatch_async(H->workers[i].que, ^{
+            gcl_memcpy(H->pulse_tmp[i], H->workers[i].pulse, H->params.range_count * sizeof(cl_float4));
+            dispatch_semaphore_signal(H->workers[i].sem);
+        });
+    }
+    for (i = 0; i < H->num_workers; i++)
+        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+    
+#else
+    
+    // Blocking read since there is only one read
+    for (i = 0; i < H->num_workers; i++) {
+        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].pulse, CL_TRUE, 0, H->params.range_count * sizeof(cl_float4), H->pulse_tmp[i], 0, NULL, NULL);
+    }
+    
+#endif
+    
+    RS_merge_pulse_tmp(H);
+    //    printf("pulse %f [ %+11.4e%+11.4ei %+11.4e%+11.4ei (%+6.2f)   %+11.4e%+11.4ei %+11.4e%+11.4ei (%+6.2f)  ... ]\n", H->sim_tic,
+    //           H->pulse[0].s0, H->pulse[0].s1, H->pulse[0].s2, H->pulse[0].s3, zdr(H->pulse[0]),
+    //           H->pulse[1].s0, H->pulse[1].s1, H->pulse[1].s2, H->pulse[1].s3, zdr(H->pulse[1]));
+}
+
+
+#pragma mark -
+#pragma mark Selective Download
+
+// First uid of a type on a worker, uids run through the types, then the workers, as in RS_alloc_host_mirrors()
+uint32_t RS_get_uid_base(RSHandle *H, const int type, const int worker_id) {
+    int k, w;
+    uint32_t uid = 0;
+    for (k = 0; k < type; k++) {
+        for (w = 0; w < H->num_workers; w++) {
+            uid += (uint32_t)H->workers[w].counts[k];
+        }
+    }
+    for (w = 0; w < worker_id; w++) {
+        uid += (uint32_t)H->workers[w].counts[type];
+    }
+    return uid;
+}
+
+
+// Index within its type, type and worker of a uid, in the same order as the uid of RSParticle
+int RS_locate_uid(RSHandle *H, const uint32_t uid, cl_uint4 *where) {
+    int k, w;
+    for (k = 0; k < H->num_types; k++) {
+        for (w = 0; w < H->num_workers; w++) {
+            const uint32_t base = RS_get_uid_base(H, k, w);
+            if (uid >= base && uid < base + H->workers[w].counts[k]) {
+                where->s0 = uid;
+                where->s1 = uid - base;
+                where->s2 = k;
+                where->s3 = w;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+
+// Position, velocity and orientation of count scatterers of a worker, 3 x count float4 in dst
+size_t RS_gather(RSHandle *H, const int worker_id, const uint32_t start, const uint32_t stride, const uint32_t *index, const size_t count, cl_float4 *dst) {
+    
+    if (count == 0) {
+        return 0;
+    }
+    
+#if defined (_USE_GCL_)
+    
+    size_t j;
+    
+    // The GCL path has just synchronized the whole arrays, so pick from the host copies
+    for (j = 0; j < count; j++) {
+        const size_t i = H->offset[worker_id] + (stride ? start + j * stride : index[j]);
+        dst[3 * j    ] = H->scat_pos[i];
+        dst[3 * j + 1] = H->scat_vel[i];
+        dst[3 * j + 2] = H->scat_ori[i];
+    }
+    
+#else
+    
+    cl_int ret;
+    RSWorker *C = &H->workers[worker_id];
+    
+    // Grow the compact buffers when needed, they are kept for the next call
+    if (count > C->gather_capacity) {
+        if (C->gather_capacity) {
+            clReleaseMemObject(C->gather);
+            clReleaseMemObject(C->gather_idx);
+            C->gather_capacity = 0;
+        }
+        size_t capacity = MAX(count, 1024);
+        C->gather = clCreateBuffer(C->context, CL_MEM_WRITE_ONLY, 3 * capacity * sizeof(cl_float4), NULL, &ret);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to allocate the gather buffer.  ret = %d", ret);
+            return 0;
+        }
+        C->gather_idx = clCreateBuffer(C->context, CL_MEM_READ_ONLY, capacity * sizeof(cl_uint), NULL, &ret);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to allocate the gather index buffer.  ret = %d", ret);
+            clReleaseMemObject(C->gather);
+            return 0;
+        }
+        C->gather_capacity = capacity;
+    }
+    
+    if (stride == 0) {
+        clEnqueueWriteBuffer(C->que, C->gather_idx, CL_FALSE, 0, count * sizeof(cl_uint), index, 0, NULL, NULL);
+    }
+    
+    const cl_uint n = (cl_uint)count;
+    const cl_uint offset = 0;
+    ret = CL_SUCCESS;
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentOutput,      sizeof(cl_mem),  &C->gather);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentPosition,    sizeof(cl_mem),  &C->scat_pos);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentVelocity,    sizeof(cl_mem),  &C->scat_vel);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentOrientation, sizeof(cl_mem),  &C->scat_ori);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentIndex,       sizeof(cl_mem),  &C->gather_idx);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentStart,       sizeof(cl_uint), &start);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentStride,      sizeof(cl_uint), &stride);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentCount,       sizeof(cl_uint), &n);
+    ret |= clSetKernelArg(C->kern_scat_gather, RSScattererGatherKernelArgumentOffset,      sizeof(cl_uint), &offset);
+    if (ret != CL_SUCCESS) {
+        fprintf(stderr, "%s : RS : Error: Failed to set arguments for kernel kern_scat_gather().\n", now());
+        return 0;
+    }
+    
+    // In-order queue, the read waits for the kernel
+    clEnqueueNDRangeKernel(C->que, C->kern_scat_gather, 1, NULL, &count, NULL, 0, NULL, NULL);
+    ret = clEnqueueReadBuffer(C->que, C->gather, CL_TRUE, 0, 3 * count * sizeof(cl_float4), dst, 0, NULL, NULL);
+    if (ret != CL_SUCCESS) {
+        rsprint("ERROR: Unable to read back the gathered scatterers.  ret = %d", ret);
+        return 0;
+    }
+    
+#endif
+    
+    return count;
+}
+
+
+size_t RS_get_type_sample_count(RSHandle *H, const int type, const size_t stride) {
+    int w;
+    size_t count = 0;
+    if (type < 0 || type >= H->num_types || stride == 0) {
+        return 0;
+    }
+    for (w = 0; w < H->num_workers; w++) {
+        count += (H->workers[w].counts[type] + stride - 1) / stride;
+    }
+    return count;
+}
+
+
+// Every stride-th scatterer of a type, particles must hold RS_get_type_sample_count() entries
+size_t RS_download_type(RSHandle *H, const int type, const size_t stride, RSParticle *particles) {
+    
+    int w;
+    size_t j, n, count = 0;
+    
+    if (type < 0 || type >= H->num_types || stride == 0) {
+        rsprint("ERROR: Invalid selection: type %d with stride %zu.", type, stride);
+        return 0;
+    }
+    
+#if defined (_USE_GCL_)
+    
+    RS_download(H);
+    
+#endif
+    
+    cl_float4 *buffer = (cl_float4 *)malloc(3 * RS_get_type_sample_count(H, type, stride) * sizeof(cl_float4));
+    if (buffer == NULL) {
+        rsprint("ERROR: Unable to allocate the selection buffer.");
+        return 0;
+    }
+    
+    for (w = 0; w < H->num_workers; w++) {
+        const uint32_t uid = RS_get_uid_base(H, type, w);
+        n = RS_gather(H, w, (uint32_t)H->workers[w].origins[type], (uint32_t)stride, NULL, (H->workers[w].counts[type] + stride - 1) / stride, buffer);
+        for (j = 0; j < n; j++) {
+            particles[count].pos = buffer[3 * j];
+            particles[count].vel = buffer[3 * j + 1];
+            particles[count].ori = buffer[3 * j + 2];
+            particles[count].uid.s0 = uid + (cl_uint)(j * stride);
+            particles[count].uid.s1 = (cl_uint)(j * stride);
+            particles[count].uid.s2 = type;
+            particles[count].uid.s3 = w;
+            count++;
+        }
+    }
+    
+    free(buffer);
+    
+    return count;
+}
+
+
+// Scatterers by uid, a uid that is out of range gives a particle with uid.s0 = UINT32_MAX
+size_t RS_download_uids(RSHandle *H, const uint32_t *uids, const size_t count, RSParticle *particles) {
+    
+    int w;
+    size_t j, n;
+    
+    if (count == 0) {
+        return 0;
+    }
+    
+#if defined (_USE_GCL_)
+    
+    RS_download(H);
+    
+#endif
+    
+    uint32_t *index = (uint32_t *)malloc(count * sizeof(uint32_t));
+    size_t *slot = (size_t *)malloc(count * sizeof(size_t));
+    cl_float4 *buffer = (cl_float4 *)malloc(3 * count * sizeof(cl_float4));
+    if (index == NULL || slot == NULL || buffer == NULL) {
+        rsprint("ERROR: Unable to allocate the selection buffer.");
+        free(index);
+        free(slot);
+        free(buffer);
+        return 0;
+    }
+    
+    for (j = 0; j < count; j++) {
+        memset(&particles[j], 0, sizeof(RSParticle));
+        if (RS_locate_uid(H, uids[j], &particles[j].uid)) {
+            particles[j].uid.s0 = UINT32_MAX;
+        }
+    }
+    
+    for (w = 0; w < H->num_workers; w++) {
+        n = 0;
+        for (j = 0; j < count; j++) {
+            if (particles[j].uid.s0 != UINT32_MAX && particles[j].uid.s3 == w) {
+                index[n] = (uint32_t)H->workers[w].origins[particles[j].uid.s2] + particles[j].uid.s1;
+                slot[n] = j;
+                n++;
+            }
+        }
+        n = RS_gather(H, w, 0, 0, index, n, buffer);
+        for (j = 0; j < n; j++) {
+            particles[slot[j]].pos = buffer[3 * j];
+            particles[slot[j]].vel = buffer[3 * j + 1];
+            particles[slot[j]].ori = buffer[3 * j + 2];
+        }
+    }
+    
+    free(index);
+    free(slot);
+    free(buffer);
+    
+    return count;
+}
+
+
+#pragma mark -
+#pragma mark Trajectory Recorder
+
+struct _rs_trajectory {
+    FILE           *fid;
+    uint32_t       count;                                // Number of tagged particles
+    uint32_t       depth;                                // Number of steps in the device rings
+    uint32_t       slot;                                 // Next step of the rings
+    uint32_t       num_workers;
+    uint32_t       counts[RS_MAX_GPU_DEVICE];            // Tagged particles of each worker
+    uint32_t       offsets[RS_MAX_GPU_DEVICE];           // First particle of each worker in a frame
+    float          *time[2];                             // Time of each step, one set is filled while the other is written
+    cl_float4      *frames[2];                           // Host copies of the rings, depth x counts[w] x 3 of each worker
+    int            stage;                                // Set that is being filled
+    int            drain_stage;                          // Set that is being written
+    uint32_t       drain_count;                          // Number of steps being written
+    bool           busy;
+    pthread_t      tid;
+    cl_mem         ring[RS_MAX_GPU_DEVICE];
+    cl_mem         index[RS_MAX_GPU_DEVICE];
+    cl_kernel      kern[RS_MAX_GPU_DEVICE];
+    cl_event       reads[RS_MAX_GPU_DEVICE];
+};
+
+
+// Background writer of a drained set, frames are interleaved from the worker-by-worker copies of the rings
+void *RS_trajectory_writer(void *in) {
+    RSTrajectory *T = (RSTrajectory *)in;
+    uint32_t s, w;
+    const int b = T->drain_stage;
+    for (w = 0; w < T->num_workers; w++) {
+        if (T->reads[w]) {
+            clWaitForEvents(1, &T->reads[w]);
+            clReleaseEvent(T->reads[w]);
+            T->reads[w] = NULL;
+        }
+    }
+    for (s = 0; s < T->drain_count; s++) {
+        fwrite(&T->time[b][s], sizeof(float), 1, T->fid);
+        for (w = 0; w < T->num_workers; w++) {
+            fwrite(&T->frames[b][3 * (T->depth * T->offsets[w] + s * T->counts[w])], sizeof(cl_float4), 3 * T->counts[w], T->fid);
+        }
+    }
+    return NULL;
+}
+
+
+void RS_wait_trajectory_writer(RSTrajectory *T) {
+    if (!T->busy) {
+        return;
+    }
+    pthread_join(T->tid, NULL);
+    T->busy = false;
+}
+
+
+// Non-blocking reads of the rings, the writer waits for them so the simulation carries on
+void RS_drain_trajectory(RSHandle *H) {
+    
+    uint32_t w;
+    cl_int ret;
+    RSTrajectory *T = H->trajectory;
+    
+    if (T->slot == 0) {
+        return;
+    }
+    
+    // The other set was handed out a drain earlier, only one writer at a time
+    RS_wait_trajectory_writer(T);
+    
+    for (w = 0; w < T->num_workers; w++) {
+        if (T->counts[w] == 0) {
+            continue;
+        }
+        // In-order queue, the ring is not overwritten until the read is done
+        ret = clEnqueueReadBuffer(H->workers[w].que, T->ring[w], CL_FALSE, 0, 3 * T->slot * T->counts[w] * sizeof(cl_float4),
+                                  &T->frames[T->stage][3 * T->depth * T->offsets[w]], 0, NULL, &T->reads[w]);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to read the trajectory ring of worker %d.  ret = %d", w, ret);
+            T->reads[w] = NULL;
+        }
+        clFlush(H->workers[w].que);
+    }
+    
+    T->drain_stage = T->stage;
+    T->drain_count = T->slot;
+    if (pthread_create(&T->tid, NULL, RS_trajectory_writer, T)) {
+        RS_trajectory_writer(T);
+    } else {
+        T->busy = true;
+    }
+    T->stage ^= 1;
+    T->slot = 0;
+}
+
+
+// Called after the attribute kernels are enqueued, the copy follows them in the same queue
+void RS_record_trajectory(RSHandle *H) {
+    
+    uint32_t w;
+    RSTrajectory *T = H->trajectory;
+    
+    for (w = 0; w < T->num_workers; w++) {
+        if (T->counts[w] == 0) {
+            continue;
+        }
+        const size_t count = T->counts[w];
+        const cl_uint offset = T->slot * T->counts[w];
+        clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentOffset, sizeof(cl_uint), &offset);
+        clEnqueueNDRangeKernel(H->workers[w].que, T->kern[w], 1, NULL, &count, NULL, 0, NULL, NULL);
+    }
+    
+    T->time[T->stage][T->slot] = (float)(H->sim_tic + H->params.prt);
+    
+    if (++T->slot == T->depth) {
+        RS_drain_trajectory(H);
+    }
+}
+
+
+int RS_start_trajectory_recorder(RSHandle *H, const char *filename, const uint32_t *uids, const size_t count, const int depth) {
+    
+    uint32_t j, n, w;
+    
+    if (!(H->status & RSStatusDomainPopulated)) {
+        rsprint("ERROR: Simulation domain not yet populated.");
+        return -1;
     }
     
-#else
+    if (count == 0 || depth < 0) {
+        rsprint("ERROR: Invalid trajectory recorder: %zu particles over %d steps.", count, depth);
+        return -1;
+    }
     
-    for (i = 0; i < H->num_workers; i++) {
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_pos, CL_TRUE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_pos + H->offset[i], 0, NULL, NULL);
+    if (H->trajectory) {
+        RS_stop_trajectory_recorder(H);
     }
     
-#endif
+#if defined (_USE_GCL_)
     
-}
-
-void RS_download_orientation_only(RSHandle *H) {
+    rsprint("ERROR: Trajectory recorder is not available with GCL.");
+    return -1;
     
-    int i;
+#else
     
-#if defined (_USE_GCL_)
+    cl_int ret;
     
-    for (i = 0; i < H->num_workers; i++) {
-        dispatch_async(H->workers[i].que, ^{
-            gcl_memcpy(H->scat_ori + H->offset[i], H->workers[i].scat_ori, H->workers[i].num_scats * sizeof(cl_float4));
-            dispatch_semaphore_signal(H->workers[i].sem);
-        });
-        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
+    cl_uint4 *where = (cl_uint4 *)malloc(count * sizeof(cl_uint4));
+    uint32_t *index = (uint32_t *)malloc(count * sizeof(uint32_t));
+    uint32_t *frame_uids = (uint32_t *)malloc(count * sizeof(uint32_t));
+    RSTrajectory *T = (RSTrajectory *)malloc(sizeof(RSTrajectory));
+    if (where == NULL || index == NULL || frame_uids == NULL || T == NULL) {
+        rsprint("ERROR: Unable to allocate the trajectory recorder.");
+        free(where);
+        free(index);
+        free(frame_uids);
+        free(T);
+        return -1;
+    }
+    memset(T, 0, sizeof(RSTrajectory));
+    H->trajectory = T;
+    
+    T->depth = depth ? depth : RS_TRAJECTORY_DEPTH;
+    T->num_workers = H->num_workers;
+    for (j = 0; j < count; j++) {
+        if (RS_locate_uid(H, uids[j], &where[j])) {
+            rsprint("WARNING: uid %u is out of range and will not be recorded.", uids[j]);
+            where[j].s0 = UINT32_MAX;
+        }
+    }
+    
+    // Frames hold the particles worker by worker, as listed in the file header
+    for (w = 0; w < T->num_workers; w++) {
+        RSWorker *C = &H->workers[w];
+        T->offsets[w] = T->count;
+        n = 0;
+        for (j = 0; j < count; j++) {
+            if (where[j].s0 != UINT32_MAX && where[j].s3 == w) {
+                index[n] = (uint32_t)C->origins[where[j].s2] + where[j].s1;
+                frame_uids[T->count + n] = where[j].s0;
+                n++;
+            }
+        }
+        T->counts[w] = n;
+        T->count += n;
+        if (n == 0) {
+            continue;
+        }
+        T->ring[w] = clCreateBuffer(C->context, CL_MEM_WRITE_ONLY, 3 * T->depth * n * sizeof(cl_float4), NULL, &ret);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to allocate the trajectory ring.  ret = %d", ret);
+            T->ring[w] = NULL;
+            break;
+        }
+        T->index[w] = clCreateBuffer(C->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, n * sizeof(cl_uint), index, &ret);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to allocate the trajectory index.  ret = %d", ret);
+            T->index[w] = NULL;
+            break;
+        }
+        // A kernel of its own so that only the offset changes from step to step
+        T->kern[w] = clCreateKernel(C->prog, "scat_gather", &ret);
+        if (ret != CL_SUCCESS) {
+            rsprint("ERROR: Unable to create the trajectory kernel.  ret = %d", ret);
+            T->kern[w] = NULL;
+            break;
+        }
+        const cl_uint zero = 0;
+        ret = CL_SUCCESS;
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentOutput,      sizeof(cl_mem),  &T->ring[w]);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentPosition,    sizeof(cl_mem),  &C->scat_pos);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentVelocity,    sizeof(cl_mem),  &C->scat_vel);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentOrientation, sizeof(cl_mem),  &C->scat_ori);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentIndex,       sizeof(cl_mem),  &T->index[w]);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentStart,       sizeof(cl_uint), &zero);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentStride,      sizeof(cl_uint), &zero);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentCount,       sizeof(cl_uint), &n);
+        ret |= clSetKernelArg(T->kern[w], RSScattererGatherKernelArgumentOffset,      sizeof(cl_uint), &zero);
+        if (ret != CL_SUCCESS) {
+            fprintf(stderr, "%s : RS : Error: Failed to set arguments for the trajectory kernel.\n", now());
+            break;
+        }
     }
+    free(where);
+    free(index);
     
-#else
+    if (w < T->num_workers || T->count == 0) {
+        if (T->count == 0) {
+            rsprint("ERROR: No particle to record.");
+        }
+        free(frame_uids);
+        RS_stop_trajectory_recorder(H);
+        return -1;
+    }
     
-    for (i = 0; i < H->num_workers; i++) {
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].scat_ori, CL_TRUE, 0, H->workers[i].num_scats * sizeof(cl_float4), H->scat_ori + H->offset[i], 0, NULL, NULL);
+    for (j = 0; j < 2; j++) {
+        T->time[j] = (float *)malloc(T->depth * sizeof(float));
+        posix_memalign((void **)&T->frames[j], RS_ALIGN_SIZE, 3 * T->depth * T->count * sizeof(cl_float4));
+    }
+    if (T->time[0] == NULL || T->time[1] == NULL || T->frames[0] == NULL || T->frames[1] == NULL) {
+        rsprint("ERROR: Unable to allocate the trajectory frames.");
+        free(frame_uids);
+        RS_stop_trajectory_recorder(H);
+        return -1;
+    }
+    
+    T->fid = fopen(filename, "wb");
+    if (T->fid == NULL) {
+        rsprint("ERROR: Unable to create trajectory file %s.", filename);
+        free(frame_uids);
+        RS_stop_trajectory_recorder(H);
+        return -1;
+    }
+    RSTrajectoryFileHeader header;
+    memset(&header, 0, sizeof(RSTrajectoryFileHeader));
+    memcpy(header.magic, RS_TRAJECTORY_FILE_MAGIC, sizeof(header.magic));
+    header.version = RS_TRAJECTORY_FILE_VERSION;
+    header.count = T->count;
+    fwrite(&header, sizeof(RSTrajectoryFileHeader), 1, T->fid);
+    fwrite(frame_uids, sizeof(uint32_t), T->count, T->fid);
+    free(frame_uids);
+    
+    if (H->verb) {
+        rsprint("Trajectory recorder with %s particles, %d steps per drain -> %s", commaint(T->count), T->depth, filename);
     }
     
+    return 0;
+    
 #endif
     
 }
 
-void RS_merge_pulse_tmp(RSHandle *H) {
-    memcpy(H->pulse, H->pulse_tmp[0], H->params.range_count * sizeof(cl_float4));
-    for (int i = 1; i < H->num_workers; i++) {
-        for (int k = 0; k < H->params.range_count; k++) {
-            H->pulse[k].s0 += H->pulse_tmp[i][k].s0;
-            H->pulse[k].s1 += H->pulse_tmp[i][k].s1;
-            H->pulse[k].s2 += H->pulse_tmp[i][k].s2;
-            H->pulse[k].s3 += H->pulse_tmp[i][k].s3;
-        }
-    }
-    //
-    // Scale the amplitude by antenna gain, tx power
-    // Amplitude scaling, Ga = 10 ^ (Gt / 20) * 10 ^ (Gr / 20) * sqrt(Pt)
-    // For dish antennas: Gt = Gr
-    //
-    //                  => g = 10 ^ (G / 20) * 10 ^ (G / 20) * sqrt(Pt)
-    //                       = 10 ^ (G / 10) * sqrt(Pt)
-    //
-    // Amplitude scale to 1-km referece: sqrt(R ^ 4) = R ^ 2 = 1.0e6
-    //
-    float g = powf(10.0f, 0.1f * H->params.antenna_gain_dbi) * sqrtf(H->params.tx_power_watt) / (4.0f * M_PI) * 1.0e6f;
-    for (int k = 0; k < H->params.range_count; k++) {
-        H->pulse[k].s0 *= g;
-        H->pulse[k].s1 *= g;
-        H->pulse[k].s2 *= g;
-        H->pulse[k].s3 *= g;
-    }
-}
 
-void RS_download_pulse_only(RSHandle *H) {
-    
-    int i;
+void RS_stop_trajectory_recorder(RSHandle *H) {
     
-#if defined (_USE_GCL_)
+    uint32_t w;
+    RSTrajectory *T = H->trajectory;
     
-    for (i = 0; i < H->num_workers; i++) {
-        dispatch_async(H->workers[i].que, ^{
-            gcl_memcpy(H->pulse_tmp[i], H->workers[i].pulse, H->params.range_count * sizeof(cl_float4));
-            dispatch_semaphore_signal(H->workers[i].sem);
-        });
+    if (T == NULL) {
+        return;
     }
-    for (i = 0; i < H->num_workers; i++)
-        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
-    
-#else
     
-    // Blocking read since there is only one read
-    for (i = 0; i < H->num_workers; i++) {
-        clEnqueueReadBuffer(H->workers[i].que, H->workers[i].pulse, CL_TRUE, 0, H->params.range_count * sizeof(cl_float4), H->pulse_tmp[i], 0, NULL, NULL);
+    // Whatever is left in the rings
+    if (T->fid) {
+        RS_drain_trajectory(H);
     }
+    RS_wait_trajectory_writer(T);
     
-#endif
-    
-    RS_merge_pulse_tmp(H);
-    //    printf("pulse %f [ %+11.4e%+11.4ei %+11.4e%+11.4ei (%+6.2f)   %+11.4e%+11.4ei %+11.4e%+11.4ei (%+6.2f)  ... ]\n", H->sim_tic,
-    //           H->pulse[0].s0, H->pulse[0].s1, H->pulse[0].s2, H->pulse[0].s3, zdr(H->pulse[0]),
-    //           H->pulse[1].s0, H->pulse[1].s1, H->pulse[1].s2, H->pulse[1].s3, zdr(H->pulse[1]));
+    for (w = 0; w < T->num_workers; w++) {
+        if (T->kern[w]) {
+            clReleaseKernel(T->kern[w]);
+        }
+        if (T->ring[w]) {
+            clReleaseMemObject(T->ring[w]);
+        }
+        if (T->index[w]) {
+            clReleaseMemObject(T->index[w]);
+        }
+    }
+    if (T->fid) {
+        if (H->verb) {
+            rsprint("Trajectory file closed with %s B.", commaint(ftell(T->fid)));
+        }
+        fclose(T->fid);
+    }
+    free(T->time[0]);
+    free(T->time[1]);
+    free(T->frames[0]);
+    free(T->frames[1]);
+    free(T);
+    H->trajectory = NULL;
 }
 
 
@@ -4549,6 +6614,11 @@ void RS_upload(RSHandle *H) {
         return;
     }
     
+    if (H->scat_pos == NULL) {
+        rsprint("ERROR: No host copies of the scatterers to upload.");
+        return;
+    }
+    
 #if defined (_USE_GCL_)
     
     for (i = 0; i < H->num_workers; i++) {
@@ -4587,6 +6657,7 @@ void RS_advance_time(RSHandle *H) {
     
     int i, k;
     int r, a;
+    int due[RS_MAX_DEBRIS_TYPES];
     
     if (!(H->status & RSStatusDomainPopulated)) {
         rsprint("ERROR: Simulation domain not yet populated.");
@@ -4608,8 +6679,19 @@ void RS_advance_time(RSHandle *H) {
         if (H->verb > 2) {
             rsprint("Wind table advanced. vel_idx = %d   ( tp = %.2f / prt = %.4f )  vel_id = %d", H->vel_idx, H->vel_desc.tp, H->params.prt, H->workers[0].les_id);
         }
+        
+        // A new wind table always gets a full physics update
+        memset(H->physics_count, 0, sizeof(H->physics_count));
     }
     
+    // Each type gets its full physics when its own clock is due, only the kinematics otherwise
+    for (k = 0; k < H->num_types; k++) {
+        due[k] = H->physics_count[k] == 0;
+    }
+    
+    // The token drops under the background emulator are transparent, they need not move
+    const char move_background = !H->bg_emulator;
+    
 #if defined (_USE_GCL_)
     
 #if defined (_DUMMY_)
@@ -4643,6 +6725,8 @@ void RS_advance_time(RSHandle *H) {
                        (cl_float4 *)H->workers[i].scat_vel,
                        (cl_float4 *)H->workers[i].scat_tum,
                        (cl_float4 *)H->workers[i].scat_sig,
+                       (cl_float4 *)H->workers[i].scat_rcq,
+                       (cl_uint)H->workers[i].counts[0],
                        (cl_uint4 *)H->workers[i].scat_rnd,
                        (cl_image)H->workers[i].vel[H->workers[i].vel_id],
                        H->workers[i].vel_desc,
@@ -4651,6 +6735,7 @@ void RS_advance_time(RSHandle *H) {
                        H->workers[i].adm_desc[a],
                        (cl_image)H->workers[i].rcs_real[r],
                        (cl_image)H->workers[i].rcs_imag[r],
+                       (cl_image)H->workers[i].rcs_gamma[r],
                        H->workers[i].rcs_desc[r],
                        H->sim_desc);
         dispatch_semaphore_signal(H->workers[i].sem);
@@ -4659,60 +6744,105 @@ void RS_advance_time(RSHandle *H) {
     
 #else
     
+    int launches[RS_MAX_GPU_DEVICE];
+    memset(launches, 0, sizeof(launches));
+    
     // These kernels are actually independent and, thus, can be parallelized.
     for (i = 0; i < H->num_workers; i++) {
-        dispatch_async(H->workers[i].que, ^{
-            if (H->sim_concept & RSSimulationConceptDraggedBackground) {
-                el_atts_kernel(&H->workers[i].ndrange_scat[0],
-                               (cl_float4 *)H->workers[i].scat_pos,
-                               (cl_float4 *)H->workers[i].scat_vel,
-                               (cl_float4 *)H->workers[i].scat_rcs,
-                               (cl_uint4 *)H->workers[i].scat_rnd,
-                               (cl_image)H->workers[i].les_uvwt[H->workers[i].les_id],
-                               (cl_image)H->workers[i].les_cpxx[H->workers[i].les_id],
-                               H->workers[i].les_desc,
-                               (cl_float4 *)H->workers[i].rcs_ellipsoid,
-                               H->workers[i].rcs_ellipsoid_desc,
-                               H->sim_desc);
-            } else {
-                bg_atts_kernel(&H->workers[i].ndrange_scat[0],
-                               (cl_float4 *)H->workers[i].scat_pos,
-                               (cl_float4 *)H->workers[i].scat_vel,
-                               (cl_float4 *)H->workers[i].scat_rcs,
-                               (cl_uint4 *)H->workers[i].scat_rnd,
-                               (cl_image)H->workers[i].les_uvwt[H->workers[i].les_id],
-                               (cl_image)H->workers[i].les_cpxx[H->workers[i].les_id],
-                               H->workers[i].les_desc,
-                               (cl_float4 *)H->workers[i].rcs_ellipsoid,
-                               H->workers[i].rcs_ellipsoid_desc,
-                               H->sim_desc);
-            }
-            dispatch_semaphore_signal(H->workers[i].sem);
-        });
+        RSWorker *C = &H->workers[i];
+        if (move_background && due[0]) {
+            const cl_float16 desc = RS_get_type_sim_desc(H, 0);
+            dispatch_async(C->que, ^{
+                if (H->sim_concept & RSSimulationConceptDraggedBackground) {
+                    el_atts_kernel(&C->ndrange_scat[0],
+                                   (cl_float4 *)C->scat_pos,
+                                   (cl_float4 *)C->scat_vel,
+                                   (cl_float4 *)C->scat_rcs,
+                                   (cl_uint4 *)C->scat_rnd,
+                                   (cl_image)C->les_uvwt[C->les_id],
+                                   (cl_image)C->les_cpxx[C->les_id],
+                                   C->les_desc,
+                                   (cl_float4 *)C->rcs_ellipsoid,
+                                   C->rcs_ellipsoid_desc,
+                                   (cl_float2 *)C->placement,
+                                   H->placement_grid,
+                                   H->sector_width,
+                                   desc);
+                } else {
+                    bg_atts_kernel(&C->ndrange_scat[0],
+                                   (cl_float4 *)C->scat_pos,
+                                   (cl_float4 *)C->scat_vel,
+                                   (cl_float4 *)C->scat_rcs,
+                                   (cl_uint4 *)C->scat_rnd,
+                                   (cl_image)C->les_uvwt[C->les_id],
+                                   (cl_image)C->les_cpxx[C->les_id],
+                                   C->les_desc,
+                                   (cl_float4 *)C->rcs_ellipsoid,
+                                   C->rcs_ellipsoid_desc,
+                                   (cl_float2 *)C->placement,
+                                   H->placement_grid,
+                                   H->sector_width,
+                                   desc);
+                }
+                dispatch_semaphore_signal(C->sem);
+            });
+            launches[i]++;
+        } else if (move_background && C->counts[0]) {
+            dispatch_async(C->que, ^{
+                kin_atts_kernel(&C->ndrange_scat[0],
+                                (cl_float4 *)C->scat_pos,
+                                (cl_float4 *)C->scat_ori,
+                                (cl_float4 *)C->scat_vel,
+                                (cl_float4 *)C->scat_tum,
+                                H->sim_desc,
+                                0);
+                dispatch_semaphore_signal(C->sem);
+            });
+            launches[i]++;
+        }
         
         r = 0;
         a = 0;
-        for (k = 1; k < RS_MAX_DEBRIS_TYPES; k++) {
-            if (H->workers[i].counts[k]) {
-                dispatch_async(H->workers[i].que, ^{
-                    db_atts_kernel(&H->workers[i].ndrange_scat[k],
-                                   (cl_float4 *)H->workers[i].scat_pos,
-                                   (cl_float4 *)H->workers[i].scat_ori,
-                                   (cl_float4 *)H->workers[i].scat_vel,
-                                   (cl_float4 *)H->workers[i].scat_tum,
-                                   (cl_float4 *)H->workers[i].scat_rcs,
-                                   (cl_uint4 *)H->workers[i].scat_rnd,
-                                   (cl_image)H->workers[i].les_uvwt[H->workers[i].les_id],
-                                   H->workers[i].les_desc,
-                                   (cl_image)H->workers[i].adm_cd[a],
-                                   (cl_image)H->workers[i].adm_cm[a],
-                                   H->workers[i].adm_desc[a],
-                                   (cl_image)H->workers[i].rcs_real[r],
-                                   (cl_image)H->workers[i].rcs_imag[r],
-                                   H->workers[i].rcs_desc[r],
-                                   H->sim_desc);
-                    dispatch_semaphore_signal(H->workers[i].sem);
+        for (k = 1; k < H->num_types; k++) {
+            if (C->counts[k] && due[k]) {
+                const int ka = a, kr = r, kk = k;
+                const cl_float16 desc = RS_get_type_sim_desc(H, k);
+                dispatch_async(C->que, ^{
+                    db_atts_kernel(&C->ndrange_scat[kk],
+                                   (cl_float4 *)C->scat_pos,
+                                   (cl_float4 *)C->scat_ori,
+                                   (cl_float4 *)C->scat_vel,
+                                   (cl_float4 *)C->scat_tum,
+                                   (cl_float4 *)C->scat_rcs,
+                                   (cl_float4 *)C->scat_rcq,
+                                   (cl_uint)C->counts[0],
+                                   (cl_uint4 *)C->scat_rnd,
+                                   (cl_image)C->les_uvwt[C->les_id],
+                                   C->les_desc,
+                                   (cl_image)C->adm_cd[ka],
+                                   (cl_image)C->adm_cm[ka],
+                                   C->adm_desc[ka],
+                                   (cl_image)C->rcs_real[kr],
+                                   (cl_image)C->rcs_imag[kr],
+                                   (cl_image)C->rcs_gamma[kr],
+                                   C->rcs_desc[kr],
+                                   desc);
+                    dispatch_semaphore_signal(C->sem);
+                });
+                launches[i]++;
+            } else if (C->counts[k]) {
+                const int kk = k;
+                dispatch_async(C->que, ^{
+                    kin_atts_kernel(&C->ndrange_scat[kk],
+                                    (cl_float4 *)C->scat_pos,
+                                    (cl_float4 *)C->scat_ori,
+                                    (cl_float4 *)C->scat_vel,
+                                    (cl_float4 *)C->scat_tum,
+                                    H->sim_desc,
+                                    1);
+                    dispatch_semaphore_signal(C->sem);
                 });
+                launches[i]++;
             }
             r = r == H->rcs_count - 1 ? 0 : r + 1;
             a = a == H->adm_count - 1 ? 0 : a + 1;
@@ -4720,11 +6850,8 @@ void RS_advance_time(RSHandle *H) {
     }
     
     for (i = 0; i < H->num_workers; i++) {
-        dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
-        for (k = 1; k < RS_MAX_DEBRIS_TYPES; k++) {
-            if (H->workers[i].counts[k]) {
-                dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
-            }
+        for (k = 0; k < launches[i]; k++) {
+            dispatch_semaphore_wait(H->workers[i].sem, DISPATCH_TIME_FOREVER);
         }
     }
     
@@ -4735,6 +6862,10 @@ void RS_advance_time(RSHandle *H) {
     cl_event events[RS_MAX_GPU_DEVICE][H->num_types];
     memset(events, 0, sizeof(events));
     
+    cl_float16 desc;
+    const int tumbling = 1;
+    const int not_tumbling = 0;
+    
     for (i = 0; i < H->num_workers; i++) {
         r = 0;
         a = 0;
@@ -4742,49 +6873,70 @@ void RS_advance_time(RSHandle *H) {
         // A convenient pointer to reduce dereferencing
         RSWorker *C = &H->workers[i];
         
-        // Need to refresh some parameters of the background at each time update
-        if (H->sim_concept & RSSimulationConceptDraggedBackground) {
-            clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
-            clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentBackgroundCn2Pressure, sizeof(cl_mem),     &C->les_cpxx[C->les_id]);
-            clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &H->sim_desc);
-            clEnqueueNDRangeKernel(C->que, C->kern_el_atts, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, &events[i][0]);
-        } else if (H->sim_concept & RSSimulationConceptFixedScattererPosition) {
-            clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
-            clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentBackgroundCn2Pressure, sizeof(cl_mem),     &C->les_cpxx[C->les_id]);
-            clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &H->sim_desc);
-            clEnqueueNDRangeKernel(C->que, C->kern_fp_atts, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, &events[i][0]);
-        } else {
-            clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
-            clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentBackgroundCn2Pressure, sizeof(cl_mem),     &C->les_cpxx[C->les_id]);
-            clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &H->sim_desc);
-            clEnqueueNDRangeKernel(C->que, C->kern_bg_atts, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, &events[i][0]);
+        // Kinematics only uses the PRT, velocity and tumble are from the last full update
+        clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &H->sim_desc);
+        
+        if (move_background) {
+            // Need to refresh some parameters of the background at each time update
+            desc = RS_get_type_sim_desc(H, 0);
+            if (!due[0]) {
+                if (C->counts[0]) {
+                    clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentTumbling, sizeof(int), &not_tumbling);
+                    clEnqueueNDRangeKernel(C->que, C->kern_kin_atts, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, &events[i][0]);
+                }
+            } else if (H->sim_concept & RSSimulationConceptDraggedBackground) {
+                clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
+                clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentBackgroundCn2Pressure, sizeof(cl_mem),     &C->les_cpxx[C->les_id]);
+                clSetKernelArg(C->kern_el_atts, RSBackgroundAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &desc);
+                clEnqueueNDRangeKernel(C->que, C->kern_el_atts, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, &events[i][0]);
+            } else if (H->sim_concept & RSSimulationConceptFixedScattererPosition) {
+                clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
+                clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentBackgroundCn2Pressure, sizeof(cl_mem),     &C->les_cpxx[C->les_id]);
+                clSetKernelArg(C->kern_fp_atts, RSBackgroundAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &desc);
+                clEnqueueNDRangeKernel(C->que, C->kern_fp_atts, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, &events[i][0]);
+            } else {
+                clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
+                clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentBackgroundCn2Pressure, sizeof(cl_mem),     &C->les_cpxx[C->les_id]);
+                clSetKernelArg(C->kern_bg_atts, RSBackgroundAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &desc);
+                clEnqueueNDRangeKernel(C->que, C->kern_bg_atts, 1, &C->origins[0], &C->counts[0], NULL, 0, NULL, &events[i][0]);
+            }
         }
         
         // Debris particles
         clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
-        clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentSimulationDescription, sizeof(cl_float16), &H->sim_desc);
+        clSetKernelArg(C->kern_kin_atts, RSKinematicAttributeKernelArgumentTumbling,          sizeof(int),        &tumbling);
         for (k = 1; k < H->num_types; k++) {
-            if (C->counts[k]) {
+            if (C->counts[k] && due[k]) {
+                desc = RS_get_type_sim_desc(H, k);
                 clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentAirDragModelDrag,              sizeof(cl_mem),     &C->adm_cd[a]);
                 clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentAirDragModelMomentum,          sizeof(cl_mem),     &C->adm_cm[a]);
                 clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentAirDragModelDescription,       sizeof(cl_float16), &C->adm_desc[a]);
                 clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionReal,         sizeof(cl_mem),     &C->rcs_real[r]);
                 clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionImag,         sizeof(cl_mem),     &C->rcs_imag[r]);
+                clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionGamma,        sizeof(cl_mem),     &C->rcs_gamma[r]);
                 clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentRadarCrossSectionDescription,  sizeof(cl_float16), &C->rcs_desc[r]);
+                clSetKernelArg(C->kern_db_atts, RSDebrisAttributeKernelArgumentSimulationDescription,         sizeof(cl_float16), &desc);
                 clEnqueueNDRangeKernel(C->que, C->kern_db_atts, 1, &C->origins[k], &C->counts[k], NULL, 0, NULL, &events[i][k]);
+            } else if (C->counts[k]) {
+                clEnqueueNDRangeKernel(C->que, C->kern_kin_atts, 1, &C->origins[k], &C->counts[k], NULL, 0, NULL, &events[i][k]);
             }
             r = r == H->rcs_count - 1 ? 0 : r + 1;
             a = a == H->adm_count - 1 ? 0 : a + 1;
         }
     }
     
+    // Copies of the tagged particles go in behind the attribute kernels
+    if (H->trajectory) {
+        RS_record_trajectory(H);
+    }
+    
     for (i = 0; i < H->num_workers; i++) {
         clFlush(H->workers[i].que);
     }
     
     for (i = 0; i < H->num_workers; i++) {
         for (k = 0; k < H->num_types; k++) {
-            if (H->workers[i].counts[k]) {
+            if (events[i][k]) {
                 clWaitForEvents(1, &events[i][k]);
                 clReleaseEvent(events[i][k]);
             }
@@ -4796,6 +6948,83 @@ void RS_advance_time(RSHandle *H) {
     H->sim_tic += H->params.prt;
     H->sim_desc.s[RSSimulationDescriptionSimTic] = H->sim_tic;
     H->status |= RSStatusScattererSignalNeedsUpdate;
+    
+    // Extrapolated debris has a new orientation but no new RCS
+    for (k = 1; k < H->num_types; k++) {
+        if (!due[k]) {
+            H->status |= RSStatusDebrisRCSNeedsUpdate;
+        }
+    }
+    for (k = 0; k < H->num_types; k++) {
+        H->physics_count[k] = H->physics_count[k] + 1 < H->physics_step[k] ? H->physics_count[k] + 1 : 0;
+    }
+}
+
+
+// Simulation description of a type with the velocity time step of its own physics clock
+cl_float16 RS_get_type_sim_desc(RSHandle *H, const int type) {
+    cl_float16 desc = H->sim_desc;
+    desc.s[RSSimulationDescriptionPhysicsStep] = H->sim_desc.s[RSSimulationDescriptionPRT] * (RSfloat)H->physics_step[type];
+    return desc;
+}
+
+
+// Largest stable step from the drag relaxation times and the wind table, growing at most 2x per step
+RSfloat RS_get_adaptive_time_step(RSHandle *H, const RSfloat dt_max) {
+    
+    int k;
+    RSfloat tau = 1.0e9f;
+    const RSfloat u = MAX(H->vel_max, 1.0f);
+    
+    // Debris: a = Ta |u|^2 cd, linearized rate 2 Ta |u| with cd of order one
+    for (k = 0; k < H->adm_count; k++) {
+        if (H->adm_desc[k].phys.Ta > 0.0f) {
+            tau = MIN(tau, 1.0f / (2.0f * H->adm_desc[k].phys.Ta * u));
+        }
+    }
+    
+    // Dragged drops: terminal velocity over g of the smallest drop (Atlas et al., 1973)
+    if (H->sim_concept & RSSimulationConceptDraggedBackground && H->dsd_r != NULL && H->dsd_count > 0) {
+        RSfloat d = 2.0e3f * H->dsd_r[0];
+        for (k = 1; k < H->dsd_count; k++) {
+            d = MIN(d, 2.0e3f * H->dsd_r[k]);
+        }
+        tau = MIN(tau, MAX(9.65f - 10.3f * expf(-0.6f * d), 0.1f) / 9.8f);
+    }
+    
+    // Real-axis stability limits of dv/dt = -v / tau: 2 tau for Euler and RK2, 2.785 tau for RK4, scaled by one margin
+    const RSfloat limit = H->sim_concept & RSSimulationConceptRungeKutta4 ? 2.785f : 2.0f;
+    RSfloat dt = (RSfloat)RS_ADAPTIVE_SAFETY * limit * tau;
+    
+    // Scatterers should not skip over a wind table cell
+    if (H->vel_cell > 0.0f) {
+        dt = MIN(dt, H->vel_cell / u);
+    }
+    
+    // Types on a slower physics clock integrate over physics_step pulses at once
+    int step = 1;
+    for (k = 0; k < H->num_types; k++) {
+        step = MAX(step, H->physics_step[k]);
+    }
+    dt /= (RSfloat)step;
+    
+    // Smooth ramp from the current step and land on the next wind table
+    dt = MIN(dt, 2.0f * H->params.prt);
+    dt = MIN(dt, dt_max);
+    if (H->sim_toc > H->sim_tic) {
+        dt = MIN(dt, H->sim_toc - H->sim_tic);
+    }
+    
+    return MAX(dt, 1.0e-4f);
+}
+
+
+// Advance with an adaptive step, mainly for warm up, returns the step used
+RSfloat RS_advance_time_adaptive(RSHandle *H, const RSfloat dt_max) {
+    RSfloat dt = RS_get_adaptive_time_step(H, dt_max);
+    RS_set_prt(H, dt);
+    RS_advance_time(H);
+    return dt;
 }
 
 
@@ -4816,6 +7045,12 @@ void RS_make_pulse(RSHandle *H) {
         return;
     }
     
+    // Only one partition carries the emulated background
+    const char emulate = H->bg_emulator && H->partition_index == 0 && H->workers[0].emulator_state != NULL;
+    if (emulate) {
+        RS_emulator_step(H);
+    }
+    
 #if defined (_USE_GCL_)
     
     if (H->status & RSStatusDebrisRCSNeedsUpdate) {
@@ -4830,8 +7065,11 @@ void RS_make_pulse(RSHandle *H) {
                                       (cl_float4 *)C->scat_pos,
                                       (cl_float4 *)C->scat_ori,
                                       (cl_float4 *)C->scat_rcs,
+                                      (cl_float4 *)C->scat_rcq,
+                                      (cl_uint)C->counts[0],
                                       (cl_image)H->workers[i].rcs_real[r],
                                       (cl_image)H->workers[i].rcs_imag[r],
+                                      (cl_image)H->workers[i].rcs_gamma[r],
                                       H->workers[i].rcs_desc[r],
                                       H->sim_desc);
                         dispatch_semaphore_signal(C->sem);
@@ -4859,6 +7097,7 @@ void RS_make_pulse(RSHandle *H) {
                                     (cl_float4 *)C->scat_rcs,
                                     (cl_float *)C->angular_weight,
                                     C->angular_weight_desc,
+                                    C->ellipsoid_count,
                                     H->sim_desc);
                 dispatch_semaphore_signal(C->sem);
             });
@@ -4879,20 +7118,37 @@ void RS_make_pulse(RSHandle *H) {
                                     (cl_float4 *)C->scat_rcs,
                                     (cl_float *)C->angular_weight,
                                     C->angular_weight_desc,
+                                    C->ellipsoid_count,
                                     H->sim_desc);
             }
-            make_pulse_pass_1_kernel(&C->ndrange_pulse_pass_1,
-                                     (cl_float4 *)C->work,
-                                     (cl_float4 *)C->scat_sig,
-                                     (cl_float4 *)C->scat_aux,
-                                     C->make_pulse_params.local_mem_size[0],
-                                     (cl_float *)C->range_weight,
-                                     C->range_weight_desc,
-                                     C->make_pulse_params.range_start,
-                                     C->make_pulse_params.range_delta,
-                                     C->make_pulse_params.range_count,
-                                     C->make_pulse_params.group_counts[0],
-                                     C->make_pulse_params.entry_counts[0]);
+            if (C->make_pulse_params.tile_count > 1) {
+                make_pulse_pass_1_tiled_kernel(&C->ndrange_pulse_pass_1,
+                                               (cl_float4 *)C->work,
+                                               (cl_float4 *)C->scat_sig,
+                                               (cl_float4 *)C->scat_aux,
+                                               C->make_pulse_params.local_mem_size[0],
+                                               (cl_float *)C->range_weight,
+                                               C->range_weight_desc,
+                                               C->make_pulse_params.range_start,
+                                               C->make_pulse_params.range_delta,
+                                               C->make_pulse_params.range_count,
+                                               C->make_pulse_params.group_counts[0],
+                                               C->make_pulse_params.entry_counts[0],
+                                               C->make_pulse_params.tile_size);
+            } else {
+                make_pulse_pass_1_kernel(&C->ndrange_pulse_pass_1,
+                                         (cl_float4 *)C->work,
+                                         (cl_float4 *)C->scat_sig,
+                                         (cl_float4 *)C->scat_aux,
+                                         C->make_pulse_params.local_mem_size[0],
+                                         (cl_float *)C->range_weight,
+                                         C->range_weight_desc,
+                                         C->make_pulse_params.range_start,
+                                         C->make_pulse_params.range_delta,
+                                         C->make_pulse_params.range_count,
+                                         C->make_pulse_params.group_counts[0],
+                                         C->make_pulse_params.entry_counts[0]);
+            }
             switch (C->make_pulse_params.cl_pass_2_method) {
                 case RS_CL_PASS_2_IN_LOCAL:
                     make_pulse_pass_2_local_kernel(&C->ndrange_pulse_pass_2,
@@ -4919,6 +7175,17 @@ void RS_make_pulse(RSHandle *H) {
                                                    C->make_pulse_params.entry_counts[1]);
                     break;
             }
+            if (i == 0 && emulate) {
+                cl_ndrange range = {1, {0, 0, 0}, {H->params.range_count, 0, 0}, {0, 0, 0}};
+                bg_emu_kernel(&range,
+                              (cl_float4 *)C->pulse,
+                              (cl_float4 *)C->emulator_state,
+                              (cl_uint4 *)C->emulator_seed,
+                              (cl_image)C->les_uvwt[C->les_id],
+                              C->les_desc,
+                              H->emulator_desc,
+                              H->sim_desc);
+            }
             dispatch_semaphore_signal(C->sem);
         });
     }
@@ -4928,7 +7195,7 @@ void RS_make_pulse(RSHandle *H) {
     
 #else
     
-    cl_event events[H->num_workers][MAX(H->num_types, 3)];
+    cl_event events[H->num_workers][MAX(H->num_types, 4)];
     memset(events, 0, sizeof(events));
     
     // In this implementation, kern_make_pulse_pass_2 should point to kern_make_pulse_pass_2_group, kern_make_pulse_pass_2_local or kern_make_pulse_pass_2_range,
@@ -4943,6 +7210,7 @@ void RS_make_pulse(RSHandle *H) {
                 if (C->counts[k]) {
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionReal,         sizeof(cl_mem),     &C->rcs_real[r]);
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionImag,         sizeof(cl_mem),     &C->rcs_imag[r]);
+                    clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionGamma,        sizeof(cl_mem),     &C->rcs_gamma[r]);
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentRadarCrossSectionDescription,  sizeof(cl_float16), &C->rcs_desc[r]);
                     clSetKernelArg(C->kern_db_rcs, RSDebrisRCSKernelArgumentSimulationDescription,         sizeof(cl_float16), &H->sim_desc);
                     clEnqueueNDRangeKernel(C->que, C->kern_db_rcs, 1, &C->origins[k], &C->counts[k], NULL, 0, NULL, &events[i][k]);
@@ -4966,15 +7234,27 @@ void RS_make_pulse(RSHandle *H) {
     }
     for (i = 0; i < H->num_workers; i++) {
         RSWorker *C = &H->workers[i];
+        // Tiles of gates are the 2nd dimension of the tiled kernel
+        const cl_uint pass_1_dim = C->make_pulse_params.tile_count > 1 ? 2 : 1;
+        const cl_kernel pass_1 = pass_1_dim == 2 ? C->kern_make_pulse_pass_1_tiled : C->kern_make_pulse_pass_1;
+        const size_t pass_1_global[] = {C->make_pulse_params.global[0], C->make_pulse_params.tile_count};
+        const size_t pass_1_local[] = {C->make_pulse_params.local[0], 1};
         if (H->status & RSStatusScattererSignalNeedsUpdate) {
             //printf("RS_make_pulse() kern_scat_sig_aux : %zu\n", C->num_scats);
             clSetKernelArg(C->kern_scat_sig_aux, RSScattererAngularWeightKernalArgumentSimulationDescription, sizeof(cl_float16), &H->sim_desc);
             clEnqueueNDRangeKernel(C->que, C->kern_scat_sig_aux, 1, NULL, &C->num_scats, NULL, 0, NULL, &events[i][0]);
-            clEnqueueNDRangeKernel(C->que, C->kern_make_pulse_pass_1, 1, NULL, &C->make_pulse_params.global[0], &C->make_pulse_params.local[0], 1, &events[i][0], &events[i][1]);
+            clEnqueueNDRangeKernel(C->que, pass_1, pass_1_dim, NULL, pass_1_global, pass_1_local, 1, &events[i][0], &events[i][1]);
         } else {
-            clEnqueueNDRangeKernel(C->que, C->kern_make_pulse_pass_1, 1, NULL, &C->make_pulse_params.global[0], &C->make_pulse_params.local[0], 0, NULL, &events[i][1]);
+            clEnqueueNDRangeKernel(C->que, pass_1, pass_1_dim, NULL, pass_1_global, pass_1_local, 0, NULL, &events[i][1]);
         }
         clEnqueueNDRangeKernel(C->que, C->kern_make_pulse_pass_2, 1, NULL, &C->make_pulse_params.global[1], &C->make_pulse_params.local[1], 1, &events[i][1], &events[i][2]);
+        if (i == 0 && emulate) {
+            const size_t range_count = H->params.range_count;
+            clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentBackgroundVelocity,    sizeof(cl_mem),     &C->les_uvwt[C->les_id]);
+            clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentEmulatorDescription,   sizeof(cl_float16), &H->emulator_desc);
+            clSetKernelArg(C->kern_bg_emu, RSBackgroundEmulatorKernelArgumentSimulationDescription, sizeof(cl_float16), &H->sim_desc);
+            clEnqueueNDRangeKernel(C->que, C->kern_bg_emu, 1, NULL, &range_count, NULL, 1, &events[i][2], &events[i][3]);
+        }
     }
     for (i = 0; i < H->num_workers; i++) {
         clFlush(H->workers[i].que);
@@ -4985,6 +7265,10 @@ void RS_make_pulse(RSHandle *H) {
             clReleaseEvent(events[i][0]);
         clReleaseEvent(events[i][1]);
         clReleaseEvent(events[i][2]);
+        if (events[i][3]) {
+            clWaitForEvents(1, &events[i][3]);
+            clReleaseEvent(events[i][3]);
+        }
     }
     
 #endif
@@ -4994,6 +7278,180 @@ void RS_make_pulse(RSHandle *H) {
 }
 
 
+#pragma mark -
+#pragma mark Moment Processing
+
+// A count of 0 derives the dwell from the scan pattern, i.e., pulses within one beamwidth
+void RS_set_moment_dwell(RSHandle *H, const int count) {
+    int n = count;
+    POSPattern *scan = (POSPattern *)H->P;
+    if (n <= 0 && scan != NULL && !POS_is_empty(scan)) {
+        if (POS_is_ppi(scan) && scan->sweeps[0].azDelta != 0.0f) {
+            n = (int)roundf(H->params.antenna_bw_deg / fabsf(scan->sweeps[0].azDelta));
+        } else if (POS_is_rhi(scan) && scan->sweeps[0].elDelta != 0.0f) {
+            n = (int)roundf(H->params.antenna_bw_deg / fabsf(scan->sweeps[0].elDelta));
+        } else if (POS_is_dbs(scan)) {
+            n = (int)scan->positions[0].count;
+        }
+    }
+    if (n < 2) {
+        rsprint("WARNING: Moment dwell of %d pulse(s) is too short, using 2 pulses.", n);
+        n = 2;
+    }
+    H->moment_dwell = n;
+    H->moment_count = 0;
+    if (H->verb) {
+        rsprint("Moment dwell = %d pulses.", H->moment_dwell);
+    }
+}
+
+
+// Accumulate the latest pulse from RS_make_pulse(), returns the number of pulses in the current dwell
+int RS_accumulate_moments(RSHandle *H) {
+    
+    if (H->moment_dwell == 0) {
+        rsprint("ERROR: Moment dwell has not been set.");
+        return 0;
+    }
+    
+    // Partial pulses from multiple workers must be summed before the correlations
+    if (H->num_workers > 1) {
+        RS_download_pulse_only(H);
+        return RS_accumulate_moments_from_pulse(H, H->pulse);
+    }
+    
+    if (H->moment_count == H->moment_dwell) {
+        H->moment_count = 0;
+    }
+    
+    const float g = RS_pulse_amplitude_gain(H);
+    const int first = H->moment_count == 0;
+    
+    RSWorker *C = &H->workers[0];
+    
+#if defined (_USE_GCL_)
+    
+    dispatch_async(C->que, ^{
+        cl_ndrange range = {1, {0, 0, 0}, {H->params.range_count, 0, 0}, {0, 0, 0}};
+        moment_acc_kernel(&range, (cl_float4 *)C->moment_acc, (cl_float4 *)C->pulse, g, first);
+        dispatch_semaphore_signal(C->sem);
+    });
+    dispatch_semaphore_wait(C->sem, DISPATCH_TIME_FOREVER);
+    
+#else
+    
+    // The queue is in order so the pulse buffer is not overwritten until this is done
+    size_t global = H->params.range_count;
+    clSetKernelArg(C->kern_moment_acc, 2, sizeof(float), &g);
+    clSetKernelArg(C->kern_moment_acc, 3, sizeof(int), &first);
+    clEnqueueNDRangeKernel(C->que, C->kern_moment_acc, 1, NULL, &global, NULL, 0, NULL, NULL);
+    
+#endif
+    
+    H->moment_on_host = FALSE;
+    return ++H->moment_count;
+}
+
+
+// Host version of moment_acc in rs.cl, for pulses that have been merged and scaled by RS_merge_pulse_tmp()
+int RS_accumulate_moments_from_pulse(RSHandle *H, const cl_float4 *pulse) {
+    
+    if (H->moment_dwell == 0) {
+        rsprint("ERROR: Moment dwell has not been set.");
+        return 0;
+    }
+    
+    if (H->moment_count == H->moment_dwell) {
+        H->moment_count = 0;
+    }
+    
+    cl_float4 *acc = H->moment_acc;
+    
+    for (int k = 0; k < H->params.range_count; k++) {
+        const cl_float4 x = pulse[k];
+        if (H->moment_count == 0) {
+            memset(&acc[3 * k], 0, 2 * sizeof(cl_float4));
+        } else {
+            const cl_float4 p = acc[3 * k + 2];
+            acc[3 * k + 1].s0 += x.s0 * p.s0 + x.s1 * p.s1;
+            acc[3 * k + 1].s1 += x.s1 * p.s0 - x.s0 * p.s1;
+            acc[3 * k + 1].s2 += x.s2 * p.s2 + x.s3 * p.s3;
+            acc[3 * k + 1].s3 += x.s3 * p.s2 - x.s2 * p.s3;
+        }
+        acc[3 * k].s0 += x.s0 * x.s0 + x.s1 * x.s1;
+        acc[3 * k].s1 += x.s2 * x.s2 + x.s3 * x.s3;
+        acc[3 * k].s2 += x.s2 * x.s0 + x.s3 * x.s1;
+        acc[3 * k].s3 += x.s3 * x.s0 - x.s2 * x.s1;
+        acc[3 * k + 2] = x;
+    }
+    
+    H->moment_on_host = TRUE;
+    return ++H->moment_count;
+}
+
+
+// Pulse pair estimates from the correlations of the current dwell. Correlations stay on the
+// device only with a single worker; RS_accumulate_moments() sums the partial pulses of multiple
+// workers on the host. Gates without power are RS_MOMENT_MISSING.
+void RS_download_moments(RSHandle *H, RSMoment *moments) {
+    
+    int k;
+    
+    if (H->moment_count < 2) {
+        rsprint("ERROR: Need at least two pulses for the moments.");
+        return;
+    }
+    
+    if (!H->moment_on_host) {
+        
+#if defined (_USE_GCL_)
+        
+        dispatch_async(H->workers[0].que, ^{
+            gcl_memcpy(H->moment_acc, H->workers[0].moment_acc, 3 * H->params.range_count * sizeof(cl_float4));
+            dispatch_semaphore_signal(H->workers[0].sem);
+        });
+        dispatch_semaphore_wait(H->workers[0].sem, DISPATCH_TIME_FOREVER);
+        
+#else
+        
+        clEnqueueReadBuffer(H->workers[0].que, H->workers[0].moment_acc, CL_TRUE, 0, 3 * H->params.range_count * sizeof(cl_float4), H->moment_acc, 0, NULL, NULL);
+        
+#endif
+        
+    }
+    
+    const float m0 = 1.0f / (float)H->moment_count;
+    const float m1 = 1.0f / (float)(H->moment_count - 1);
+    const float va = H->params.va;
+    
+    for (k = 0; k < H->params.range_count; k++) {
+        const cl_float4 a0 = H->moment_acc[3 * k];
+        const cl_float4 a1 = H->moment_acc[3 * k + 1];
+        const float sh = a0.s0 * m0;
+        const float sv = a0.s1 * m0;
+        const float rx = sqrtf(a0.s2 * a0.s2 + a0.s3 * a0.s3) * m0;
+        const float r1 = sqrtf(a1.s0 * a1.s0 + a1.s1 * a1.s1) * m1;
+        if (sh <= 0.0f) {
+            moments[k].z = RS_MOMENT_MISSING;
+            moments[k].v = RS_MOMENT_MISSING;
+            moments[k].w = RS_MOMENT_MISSING;
+            moments[k].zdr = RS_MOMENT_MISSING;
+            moments[k].rhohv = RS_MOMENT_MISSING;
+            moments[k].phidp = RS_MOMENT_MISSING;
+            continue;
+        }
+        const float r = MAX(H->params.range_start + (float)k * H->params.range_delta, 1.0f);
+        // Signal is exp(-j k r) so a receding target has a negative lag-1 phase
+        moments[k].z = 10.0f * log10f(sh) + 20.0f * log10f(r * 1.0e-3f);
+        moments[k].v = -va / M_PI * atan2f(a1.s1, a1.s0);
+        moments[k].w = r1 > 0.0f && sh > r1 ? M_SQRT2 * va / M_PI * sqrtf(logf(sh / r1)) : 0.0f;
+        moments[k].zdr = sv > 0.0f ? 10.0f * log10f(sh / sv) : RS_MOMENT_MISSING;
+        moments[k].rhohv = sv > 0.0f ? rx / sqrtf(sh * sv) : RS_MOMENT_MISSING;
+        moments[k].phidp = atan2f(a0.s3, a0.s2) * 180.0f / M_PI;
+    }
+}
+
+
 #pragma mark -
 #pragma mark Elements for table lookup
 
@@ -5117,6 +7575,10 @@ static void RS_show_att_i(RSHandle *H, const size_t i) {
 
 void RS_show_scat_pos(RSHandle *H) {
     size_t i, w;
+    if (H->scat_pos == NULL) {
+        rsprint("No host copies of the scatterers, call RS_download() first.");
+        return;
+    }
     printf("A subset of meteorological scatterer positions, velocities & orientations:\n");
     for (w = 0; w < H->num_workers; w++) {
         for (i = H->workers[w].origins[0];
@@ -5143,6 +7605,10 @@ void RS_show_scat_pos(RSHandle *H) {
 
 void RS_show_scat_sig(RSHandle *H) {
     size_t i, w;
+    if (H->scat_pos == NULL) {
+        rsprint("No host copies of the scatterers, call RS_download() first.");
+        return;
+    }
     printf("A subset of meteorological scatterer signal, RCS & aux. attributes:\n");
     for (w = 0; w < H->num_workers; w++) {
         for (i = 0; i < H->workers[w].counts[0]; i += H->workers[w].counts[0] / RS_SHOW_DIV) {
@@ -5163,6 +7629,10 @@ void RS_show_scat_sig(RSHandle *H) {
 
 void RS_show_scat_att(RSHandle *H) {
     size_t i, w;
+    if (H->scat_pos == NULL) {
+        rsprint("No host copies of the scatterers, call RS_download() first.");
+        return;
+    }
     printf("A subset of meteorological scatterer position, velocity, orientation, signal, RCS, etc.:\n");
     for (w = 0; w < H->num_workers; w++) {
         for (i = 0; i < H->workers[w].counts[0]; i += H->workers[w].counts[0] / RS_SHOW_DIV) {
@@ -5374,9 +7844,42 @@ void RS_compute_rcs_ellipsoids(RSHandle *H) {
 #endif
         }
         
-        // Each size has same probably of occurence, the return power is scaled by the ratio of the
-        if (H->sim_concept & RSSimulationConceptUniformDSDScaledRCS) {
+        if (H->bg_emulator) {
+            
+            // The emulator takes the moments of a single drop over the DSD, the token drops are transparent
+            int k;
+            double p, pw, v, v_sum = 0.0, v_sq = 0.0;
+            double m[4] = {0.0, 0.0, 0.0, 0.0};
+            const double s = H->sim_desc.s[RSSimulationDescriptionDropConcentrationScale];
+            for (i = 0; i < H->dsd_count && s > 0.0; i++) {
+                k = MIN(MAX((int)(H->dsd_r[i] * 20000.0f) - 5, 0), (int)n - 1);
+                p = H->dsd_pdf[i] / (s * s);
+                pw = p * (table[k].s0 * table[k].s0 + table[k].s1 * table[k].s1);
+                m[0] += pw;
+                m[1] += p * (table[k].s2 * table[k].s2 + table[k].s3 * table[k].s3);
+                m[2] += p * (table[k].s0 * table[k].s2 + table[k].s1 * table[k].s3);
+                m[3] += p * (table[k].s1 * table[k].s2 - table[k].s0 * table[k].s3);
+                // Terminal velocity (Atlas et al., 1973) with D = 2000 r mm
+                v = MAX(9.65 - 10.3 * exp(-1200.0 * H->dsd_r[i]), 0.0);
+                v_sum += pw * v;
+                v_sq += pw * v * v;
+            }
+            for (k = 0; k < 4; k++) {
+                H->emulator_desc.s[RSEmulatorDescriptionPowerH + k] = (cl_float)(H->dsd_nd_sum * m[k]);
+            }
+            // Only the dragged drops fall, the others follow the wind
+            if (m[0] > 0.0 && H->sim_concept & RSSimulationConceptDraggedBackground) {
+                H->emulator_desc.s[RSEmulatorDescriptionFallSpeed] = (cl_float)(v_sum / m[0]);
+                H->emulator_desc.s[RSEmulatorDescriptionFallSpeedVariance] = (cl_float)MAX(v_sq / m[0] - v_sum * v_sum / (m[0] * m[0]), 0.0);
+            } else {
+                H->emulator_desc.s[RSEmulatorDescriptionFallSpeed] = 0.0f;
+                H->emulator_desc.s[RSEmulatorDescriptionFallSpeedVariance] = 0.0f;
+            }
+            memset(table, 0, n * sizeof(cl_float4));
+            
+        } else if (H->sim_concept & RSSimulationConceptUniformDSDScaledRCS) {
             
+            // Each size has same probably of occurence, the return power is scaled by the ratio of the
             int k;
             float s;
             const float p = 1.0f / (float)H->dsd_count;
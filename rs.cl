@@ -2,6 +2,13 @@
 #define FLOAT4_ZERO      (float4)(0.0f, 0.0f, 0.0f, 0.0f)
 #define QUAT_IDENTITY    (float4)(0.0f, 0.0f, 0.0f, 1.0f)
 
+// Set by the host from the device extensions: 1 = cl_khr_subgroups, 2 = cl_intel_subgroups
+#if RS_USE_SUBGROUPS == 1
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#elif RS_USE_SUBGROUPS == 2
+#pragma OPENCL EXTENSION cl_intel_subgroups : enable
+#endif
+
 enum RSTable1DDescrip {
     RSTable1DDescriptionScale        = 0,
     RSTable1DDescriptionOrigin       = 1,
@@ -20,7 +27,9 @@ enum RSTableSpacing {
 enum RSSimulationConcept {
     RSSimulationConceptNull                    = 0,
     RSSimulationConceptDraggedBackground       = 1,
-    RSSimulationConceptBoundedParticleVelocity = 1 << 1
+    RSSimulationConceptBoundedParticleVelocity = 1 << 1,
+    RSSimulationConceptRungeKutta2             = 1 << 6,
+    RSSimulationConceptRungeKutta4             = 1 << 7
 };
 
 enum RSSimulationDescription {
@@ -39,7 +48,7 @@ enum RSSimulationDescription {
     RSSimulationDescriptionBoundSizeX         =  12, // hi.s4
     RSSimulationDescriptionBoundSizeY         =  13, // hi.s5
     RSSimulationDescriptionBoundSizeZ         =  14, // hi.s6
-    RSSimulationDescription15                 =  15  //
+    RSSimulationDescriptionPhysicsStep        =  15  // sf
 };
 
 enum RSTable3DDescription {
@@ -54,7 +63,7 @@ enum RSTable3DDescription {
     RSTable3DDescriptionMaximumX    =  8,
     RSTable3DDescriptionMaximumY    =  9,
     RSTable3DDescriptionMaximumZ    = 10,
-    RSTable3DDescription11          = 11,
+    RSTable3DDescriptionRCSTolerance = 11,
     RSTable3DDescriptionRecipInLnX  = 12,
     RSTable3DDescriptionRecipInLnY  = 13,
     RSTable3DDescriptionRecipInLnZ  = 14,
@@ -86,6 +95,7 @@ enum RSTable3DStaggeredDescription {
 const sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
 
 float4 rand(uint4 *seed);
+uint hash_uint(uint x);
 
 float4 quat_mult(float4 left, float4 right);
 float4 quat_conj(float4 quat);
@@ -96,12 +106,26 @@ float4 quat_rotate(float4 vector, float4 quat);
 
 float4 cl_complex_multiply(const float4 a, const float4 b);
 float4 cl_complex_divide(const float4 a, const float4 b);
+#if defined (RS_USE_SUBGROUPS)
+float4 sub_group_reduce_add4(const float4 v);
+void consolidate_gates(__local float4 *shared, const unsigned int local_numel);
+#endif
 float4 wind_table_index(const float4 pos, const float16 wind_desc, const float16 sim_desc);
 float4 compute_bg_vel(const float4 pos, __read_only image3d_t wind_uvwt, const float16 wind_desc, const float16 sim_desc);
 float4 compute_dudt_dwdt(float4 *dwdt, const float4 vel, const float4 vel_bg, const float4 ori, __read_only image2d_t adm_cd, __read_only image2d_t adm_cm, const float16 adm_desc);
+float4 integrate_dudt_dwdt(float4 *dwdt, const float4 vel, const float4 vel_bg, const float4 ori, __read_only image2d_t adm_cd, __read_only image2d_t adm_cm, const float16 adm_desc, const float h, const uint concept);
+float4 compute_drop_dudt(const float4 vel, const float4 vel_bg, const float radius);
+float4 integrate_drop_dudt(const float4 vel, const float4 vel_bg, const float radius, const float h, const uint concept);
 //float4 compute_ellipsoid_rcs(const float4 pos, __read_only image1d_t rcs, const float4 rcs_desc);
-float4 compute_ellipsoid_rcs(const float4 pos, __constant float4 *table, const float4 table_desc);
-float4 compute_debris_rcs(const float4 pos, const float4 ori, __read_only image2d_t rcs_real, __read_only image2d_t rcs_imag, const float16 rcs_desc, const float16 sim_desc);
+float4 compute_ellipsoid_rcs(const float radius, __constant float4 *table, const float4 table_desc);
+float4 compute_debris_rotation(const float4 pos, const float4 ori);
+float4 compute_debris_rcs(const float4 rot, __read_only image2d_t rcs_real, __read_only image2d_t rcs_imag, __read_only image3d_t rcs_gamma, const float16 rcs_desc, const float16 sim_desc);
+bool debris_rcs_is_current(const float4 rot, __global float4 *q, const unsigned int j, const float16 rcs_desc);
+float4 placement_sample(const float4 r, __constant float2 *placement, const uint grid, const float16 sim_desc);
+float placement_weight(const float4 pos, __constant float2 *placement, const uint grid, const float16 sim_desc);
+float sector_offset(const float4 pos, const float16 sim_desc);
+float4 sector_sample(const float4 pos, const float half_width, uint4 *seed, const float16 sim_desc);
+float4 sector_fold(const float4 pos, const float offset, const float half_width, uint4 *seed, const float16 sim_desc);
 
 /////////////////////////////////////////////////////////////////////////////////////////
 //
@@ -122,6 +146,17 @@ float4 rand(uint4 *seed)
     return convert_float4(*seed) * n;
 }
 
+// Integer hash with good avalanche, for counter-based random numbers
+uint hash_uint(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
 #pragma mark -
 #pragma mark Quaternion Fun
 
@@ -194,6 +229,53 @@ float4 cl_complex_divide(const float4 a, const float4 b)
     return shuffle(iiqq, (uint4)(0, 2, 1, 3));
 }
 
+#if defined (RS_USE_SUBGROUPS)
+
+float4 sub_group_reduce_add4(const float4 v)
+{
+    return (float4)(sub_group_reduce_add(v.s0),
+                    sub_group_reduce_add(v.s1),
+                    sub_group_reduce_add(v.s2),
+                    sub_group_reduce_add(v.s3));
+}
+
+//
+// Sums the local_size accumulators of every gate, shared[local_id + k], k = 0, local_size, ... local_numel - local_size,
+// into shared[k]. Each subgroup adds up in registers and leaves its sum in the slot of its first work item, which
+// nobody else reads, so one barrier is enough before one work item per gate adds up the subgroups.
+//
+void consolidate_gates(__local float4 *shared, const unsigned int local_numel)
+{
+    const unsigned int local_id = get_local_id(0);
+    const unsigned int local_size = get_local_size(0);
+    const unsigned int sub_stride = get_max_sub_group_size();
+    const unsigned int sub_count = get_num_sub_groups();
+    const bool sub_lead = get_sub_group_local_id() == 0;
+    
+    unsigned int g;
+    unsigned int k;
+    float4 v;
+    
+    for (k = 0; k < local_numel; k += local_size) {
+        v = sub_group_reduce_add4(shared[local_id + k]);
+        if (sub_lead) {
+            shared[local_id + k] = v;
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    
+    for (k = local_id * local_size; k < local_numel; k += local_size * local_size) {
+        v = shared[k];
+        for (g = 1; g < sub_count; g++) {
+            v += shared[k + g * sub_stride];
+        }
+        shared[k] = v;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+#endif
+
 /////////////////////////////////////////////////////////////////////////////////////////
 //
 //  Wind Table Index
@@ -316,49 +398,174 @@ float4 compute_dudt_dwdt(float4 *dwdt,
     
     float ur_norm_sq = dot(ur.xyz, ur.xyz);
     
-    // Euler method: dudt is just a scaled version of drag coefficient
+    // dudt is just a scaled version of drag coefficient, see integrate_dudt_dwdt() for the higher order steps
     float4 dudt = Ta * ur_norm_sq * cd + (float4)(0.0f, 0.0f, -9.8f, 0.0f);
 
     *dwdt = radians((Ta * ur_norm_sq * inv_inln) * cm);
     
-    // Runge-Kutta: dudt is a two-point average
-    //    float4 dudt1 = Ta * ur_norm_sq * cd;
-    //
-    //    // Project to the next lookup
-    //    float4 udt1 = vel;
-    //    float4 udt2 = udt1 + dt * dudt1;
-    //
-    //    // New delta
-    //    float4 ur2 = vel_bg - udt2;
-    //    float ur2_norm_sq = dot(ur2.xyz, ur2.xyz);
-    //    float4 dudt2 = Ta * ur2_norm_sq * cd;
-    //
-    //    float4 dudt = 0.5f * (dudt1 + dudt2) + (float4)(0.0f, 0.0f, -9.8f, 0.0f);
-    //    *dwdt = radians((Ta * 0.5f * (ur_norm_sq + ur2_norm_sq) * inv_inln) * cm);
-
     return dudt;
 }
 
+//
+// Effective dudt & dwdt over a step h: Euler, Heun (RK2) or classic RK4 on the velocity, orientation is held
+//
+float4 integrate_dudt_dwdt(float4 *dwdt,
+                           const float4 vel,
+                           const float4 vel_bg,
+                           const float4 ori,
+                           __read_only image2d_t adm_cd,
+                           __read_only image2d_t adm_cm,
+                           const float16 adm_desc,
+                           const float h,
+                           const uint concept) {
+    float4 w1, w2, w3, w4;
+    float4 k1 = compute_dudt_dwdt(&w1, vel, vel_bg, ori, adm_cd, adm_cm, adm_desc);
+    if (concept & RSSimulationConceptRungeKutta4) {
+        float4 k2 = compute_dudt_dwdt(&w2, vel + (0.5f * h) * k1, vel_bg, ori, adm_cd, adm_cm, adm_desc);
+        float4 k3 = compute_dudt_dwdt(&w3, vel + (0.5f * h) * k2, vel_bg, ori, adm_cd, adm_cm, adm_desc);
+        float4 k4 = compute_dudt_dwdt(&w4, vel + h * k3, vel_bg, ori, adm_cd, adm_cm, adm_desc);
+        *dwdt = (w1 + 2.0f * (w2 + w3) + w4) * (1.0f / 6.0f);
+        return (k1 + 2.0f * (k2 + k3) + k4) * (1.0f / 6.0f);
+    } else if (concept & RSSimulationConceptRungeKutta2) {
+        float4 k2 = compute_dudt_dwdt(&w2, vel + h * k1, vel_bg, ori, adm_cd, adm_cm, adm_desc);
+        *dwdt = 0.5f * (w1 + w2);
+        return 0.5f * (k1 + k2);
+    }
+    *dwdt = w1;
+    return k1;
+}
+
+//
+// Drag and gravity of a drop with a given radius
+//
+float4 compute_drop_dudt(const float4 vel, const float4 vel_bg, const float radius) {
+    // Calculate Reynold's number with air density and viscousity
+    const float rho_air = 1.225f;                                // 1.225 kg m^-3
+    const float rho_over_mu_air = 6.7308e4f;                     // 1.225 / 1.82e-5 kg m^-1 s^-1 = 6.7308e4 (David)
+    const float area_over_mass_particle = 0.003006012f / radius; // 4 * PI * R ^ 2 / ( ( 4 / 3 ) * PI * R ^ 3 * rho ) = 0.0030054 / r (rho = 998)
+
+    float4 delta_v = vel_bg - vel;
+    float delta_v_abs = length(delta_v.xyz);
+    
+    if (delta_v_abs <= 1.0e-3f) {
+        return (float4)(0.0f, 0.0f, -9.8f, 0.0f);
+    }
+    
+    float re = rho_over_mu_air * (2.0f * radius) * delta_v_abs;
+    float cd = 24.0f / re + 6.0f / (1.0f + sqrt(re)) + 0.4f;
+    return (0.5f * rho_air * cd * area_over_mass_particle * delta_v_abs) * delta_v + (float4)(0.0f, 0.0f, -9.8f, 0.0f);
+}
+
+float4 integrate_drop_dudt(const float4 vel, const float4 vel_bg, const float radius, const float h, const uint concept) {
+    float4 k1 = compute_drop_dudt(vel, vel_bg, radius);
+    if (concept & RSSimulationConceptRungeKutta4) {
+        float4 k2 = compute_drop_dudt(vel + (0.5f * h) * k1, vel_bg, radius);
+        float4 k3 = compute_drop_dudt(vel + (0.5f * h) * k2, vel_bg, radius);
+        float4 k4 = compute_drop_dudt(vel + h * k3, vel_bg, radius);
+        return (k1 + 2.0f * (k2 + k3) + k4) * (1.0f / 6.0f);
+    } else if (concept & RSSimulationConceptRungeKutta2) {
+        float4 k2 = compute_drop_dudt(vel + h * k1, vel_bg, radius);
+        return 0.5f * (k1 + k2);
+    }
+    return k1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Importance-Sampled Placement
+//
+
+// Position (x, y, z) and amplitude weight (w) from a cell drawn with r.w, see RS_derive_placement in rs.c
+float4 placement_sample(const float4 r, __constant float2 *placement, const uint grid, const float16 sim_desc) {
+    // First cell with r.w < cdf
+    uint lo = 0;
+    uint hi = grid * grid * grid - 1;
+    while (lo < hi) {
+        const uint mid = (lo + hi) / 2;
+        if (r.w < placement[mid].s0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    const float3 cell = (float3)((float)(lo % grid), (float)(lo / grid % grid), (float)(lo / (grid * grid)));
+    const float3 pos = fma((cell + r.xyz) / (float)grid, sim_desc.hi.s456, sim_desc.hi.s012);
+    return (float4)(pos, placement[lo].s1);
+}
+
+float placement_weight(const float4 pos, __constant float2 *placement, const uint grid, const float16 sim_desc) {
+    const uint3 cell = min(convert_uint3(clamp((pos.xyz - sim_desc.hi.s012) / sim_desc.hi.s456, 0.0f, 1.0f) * (float)grid), grid - 1);
+    return placement[(cell.z * grid + cell.y) * grid + cell.x].s1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Sliding Sector
+//
+
+// Azimuth of a position relative to the beam, wrapped to [-pi, pi]
+float sector_offset(const float4 pos, const float16 sim_desc) {
+    const float d = atan2(pos.x, pos.y) - atan2(sim_desc.s0, sim_desc.s1);
+    return d - 2.0f * M_PI_F * rint(d * (0.5f * M_1_PI_F));
+}
+
+// Uniform position in the part of the box within the sector: horizontal range with a pdf proportional to itself
+// between the nearest and the farthest corner, azimuth uniform about the beam, height uniform. Draws that land
+// outside the box are drawn again, the last one is clamped into the box if the sector barely overlaps it
+float4 sector_sample(const float4 pos, const float half_width, uint4 *seed, const float16 sim_desc) {
+    const float2 lo = sim_desc.hi.s01;
+    const float2 hi = sim_desc.hi.s01 + sim_desc.hi.s45;
+    const float2 closest = clamp((float2)(0.0f, 0.0f), lo, hi);
+    const float2 farthest = fmax(fabs(lo), fabs(hi));
+    const float r2_lo = dot(closest, closest);
+    const float r2_hi = dot(farthest, farthest);
+    const float beam = atan2(sim_desc.s0, sim_desc.s1);
+    float4 out = pos;
+    for (int k = 0; k < 16; k++) {
+        const float4 r = rand(seed);
+        float c, s = sincos(fma(2.0f * r.y - 1.0f, half_width, beam), &c);
+        out.xyz = (float3)(sqrt(mix(r2_lo, r2_hi, r.x)) * (float2)(s, c), fma(r.z, sim_desc.hi.s6, sim_desc.hi.s2));
+        if (all(isgreater(out.xy, lo) & isless(out.xy, hi))) {
+            return out;
+        }
+    }
+    out.xy = clamp(out.xy, fma(sim_desc.hi.s45, 1.0e-3f, lo), fma(sim_desc.hi.s45, -1.0e-3f, hi));
+    return out;
+}
+
+// Rotate a position that fell off the trailing edge by the sector width into the leading edge; range and height
+// are kept. A position that rotates out of the box, or any position after the beam has jumped further than the
+// sector width, is drawn anew within the sector
+float4 sector_fold(const float4 pos, const float offset, const float half_width, uint4 *seed, const float16 sim_desc) {
+    const float d = offset - copysign(2.0f * half_width, offset);
+    if (fabs(d) > half_width) {
+        return sector_sample(pos, half_width, seed, sim_desc);
+    }
+    float c, s = sincos(atan2(sim_desc.s0, sim_desc.s1) + d, &c);
+    const float4 out = (float4)(length(pos.xy) * (float2)(s, c), pos.zw);
+    if (any(islessequal(out.xy, sim_desc.hi.s01) | isgreaterequal(out.xy, sim_desc.hi.s01 + sim_desc.hi.s45))) {
+        return sector_sample(pos, half_width, seed, sim_desc);
+    }
+    return out;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 //
 //  Particle RCS
 //
 
-float4 compute_ellipsoid_rcs(const float4 pos, __constant float4 *table, const float4 table_desc) {
+// H and V coefficients (xz) of a drop, which is also the RCS at zero elevation, see scat_sig_aux for the blend
+float4 compute_ellipsoid_rcs(const float radius, __constant float4 *table, const float4 table_desc) {
     // Clamp to the edge, pick the nearest coefficient
-    float fidx = clamp(fma(pos.w, table_desc.s0, table_desc.s1), 0.0f, table_desc.s2);
+    float fidx = clamp(fma(radius, table_desc.s0, table_desc.s1), 0.0f, table_desc.s2);
     uint idx = (uint)fidx;
 
     // Actual weight in the table
-    float4 xz = table[idx];
-    
-    const float beta = atan2(pos.s2, length(pos.s01));
-    float cb = cos(beta);
-
-    return (float4)(xz.s01, xz.s01 + (xz.s23 - xz.s01) * cb * cb);
+    return table[idx];
 }
 
-float4 compute_debris_rcs(const float4 pos, const float4 ori, __read_only image2d_t rcs_real, __read_only image2d_t rcs_imag, const float16 rcs_desc, const float16 sim_desc) {
+// Rotation of the RCS frame relative to the line of sight, the RCS is a function of this alone
+float4 compute_debris_rotation(const float4 pos, const float4 ori) {
 
     const float el = atan2(pos.s2, length(pos.s01));
     const float az = atan2(pos.s0, pos.s1);
@@ -385,10 +592,25 @@ float4 compute_debris_rcs(const float4 pos, const float4 ori, __read_only image2
     float4 o_conj = ((float4)(-se, ce, se, ce) * ca + (float4)(ce, se, ce, -se) * sa) * M_SQRT1_2_F;
     
     // Relative rotation from the identity
-    float4 R = quat_mult(ori, o_conj);
+    return quat_mult(ori, o_conj);
+}
+
+// RCS cache q holds the rotation of the last evaluation of debris j, q and -q are the same rotation
+bool debris_rcs_is_current(const float4 rot, __global float4 *q, const unsigned int j, const float16 rcs_desc) {
+    if (rcs_desc.sb == 0.0f) {
+        return false;
+    }
+    if (fabs(dot(rot, q[j])) >= rcs_desc.sb) {
+        return true;
+    }
+    q[j] = rot;
+    return false;
+}
+
+float4 compute_debris_rcs(const float4 rot, __read_only image2d_t rcs_real, __read_only image2d_t rcs_imag, __read_only image3d_t rcs_gamma, const float16 rcs_desc, const float16 sim_desc) {
     
     // Axis shuffle for reference frame permutation (ADM -> RCS)
-    float4 quat_rel = (float4)(R.x, R.z, -R.y, R.w);
+    float4 quat_rel = (float4)(rot.x, rot.z, -rot.y, rot.w);
     
     float alpha;
     float beta;
@@ -407,6 +629,13 @@ float4 compute_debris_rcs(const float4 pos, const float4 ori, __read_only image2
         gamma = atan2(quat_rel.y * quat_rel.z + quat_rel.w * quat_rel.x , quat_rel.w * quat_rel.y - quat_rel.x * quat_rel.z);
     }
 
+    // Gamma projection baked into (Hi, Hq, Vi, Vq) of a 3-D table, see RS_set_rcs_gamma_data(). Gamma of the lumped
+    // case spans [-2 pi, 2 pi] so it is wrapped into the [-pi, pi] of the table
+    if (rcs_desc.sa > 0.0f) {
+        gamma -= 2.0f * M_PI_F * rint(gamma * (0.5f * M_1_PI_F));
+        return read_imagef(rcs_gamma, sampler, (float4)(fma((float3)(alpha, beta, gamma), rcs_desc.s012, rcs_desc.s456), 0.0f));
+    }
+
     // RCS values are stored as real(hh, vv, hv, __) + imag(hh, vv, hv, __)
     float2 rcs_coord = fma((float2)(alpha, beta), rcs_desc.s01, rcs_desc.s45);
     float4 real = read_imagef(rcs_real, sampler, rcs_coord);
@@ -611,6 +840,9 @@ __kernel void bg_atts(__global float4 *p,
                       const float16 wind_desc,
                       __constant float4 *drop_rcs,
                       const float4 drop_rcs_desc,
+                      __constant float2 *placement,
+                      const uint placement_grid,
+                      const float sector_width,
                       const float16 sim_desc)
 {
 
@@ -627,7 +859,16 @@ __kernel void bg_atts(__global float4 *p,
     if (is_outside) {
         uint4 seed = y[i];
         float4 r = rand(&seed);
-        pos.xyz = r.xyz * sim_desc.hi.s456 + sim_desc.hi.s012;
+        if (placement_grid) {
+            // A new cell comes with a new weight
+            r = placement_sample(r, placement, placement_grid, sim_desc);
+            pos.xyz = r.xyz;
+            x[i] = compute_ellipsoid_rcs(pos.w, drop_rcs, drop_rcs_desc) * r.w;
+        } else if (sector_width > 0.0f) {
+            pos = sector_sample(pos, sector_width, &seed, sim_desc);
+        } else {
+            pos.xyz = r.xyz * sim_desc.hi.s456 + sim_desc.hi.s012;
+        }
         //pos.xyz = (float3)(fma(r.xy, sim_desc.hi.s45, sim_desc.hi.s01), MIN_HEIGHT);   // Feed from the bottom
         vel = FLOAT4_ZERO;
 
@@ -637,6 +878,16 @@ __kernel void bg_atts(__global float4 *p,
 
         return;
     }
+    
+    // Recycled into the leading edge of the sector, the velocity below comes from the wind there
+    if (sector_width > 0.0f) {
+        const float d = sector_offset(pos, sim_desc);
+        if (fabs(d) > sector_width) {
+            uint4 seed = y[i];
+            pos = sector_fold(pos, d, sector_width, &seed, sim_desc);
+            y[i] = seed;
+        }
+    }
 
     // Derive the lookup index
     float4 wind_coord = wind_table_index(pos, wind_desc, sim_desc);
@@ -644,11 +895,8 @@ __kernel void bg_atts(__global float4 *p,
     // Look up the background velocity from the table
     vel = read_imagef(wind_uvwt, sampler, wind_coord);
     
-    float4 rcs = compute_ellipsoid_rcs(pos, drop_rcs, drop_rcs_desc);
-    
     p[i] = pos;
     v[i] = vel;
-    x[i] = rcs;
 }
 
 //RSSimulationDescriptionWaveNumber         =  4,
@@ -668,6 +916,9 @@ __kernel void fp_atts(__global float4 *p,
                       const float16 les_desc,
                       __constant float4 *drop_rcs,
                       const float4 drop_rcs_desc,
+                      __constant float2 *placement,
+                      const uint placement_grid,
+                      const float sector_width,
                       const float16 sim_desc)
 {
     const unsigned int i = get_global_id(0);
@@ -732,21 +983,24 @@ __kernel void fp_atts(__global float4 *p,
 //
 __kernel void el_atts(__global float4 *p,                  // position (x, y, z) and size (radius)
                       __global float4 *v,                  // velocity (u, v, w) and a vacant float
-                      __global float4 *x,                  // rcs (hi, hq, vi, vq) of the particle
+                      __global float4 *x,                  // H and V coefficients of the particle, see el_rcs
                       __global uint4 *y,                   // 128-bit random seed (4 x 32-bit)
                       __read_only image3d_t wind_uvwt,
                       __read_only image3d_t wind_cpxx,
                       const float16 wind_desc,
                       __constant float4 *drop_rcs,
                       const float4 drop_rcs_desc,
+                      __constant float2 *placement,
+                      const uint placement_grid,
+                      const float sector_width,
                       const float16 sim_desc)
 {
     const unsigned int i = get_global_id(0);
     const float4 dt = (float4)(sim_desc.sb, sim_desc.sb, sim_desc.sb, 0.0f);
+    const float4 dt_phys = (float4)(sim_desc.sf, sim_desc.sf, sim_desc.sf, 0.0f);
     
     float4 pos = p[i];  // position
     float4 vel = v[i];  // velocity
-    float4 rcs = x[i];
     uint4 seed = y[i];
     
     const float s5 = sim_desc.s5;
@@ -756,11 +1010,6 @@ __kernel void el_atts(__global float4 *p,                  // position (x, y, z)
     //pos.xyz += vel.xyz * dt.xyz;     // use this as the substitue for the line above.
     pos = fma(vel, dt, pos);
     
-    // Calculate Reynold's number with air density and viscousity
-    const float rho_air = 1.225f;                                // 1.225 kg m^-3
-    const float rho_over_mu_air = 6.7308e4f;                     // 1.225 / 1.82e-5 kg m^-1 s^-1 = 6.7308e4 (David)
-    const float area_over_mass_particle = 0.003006012f / pos.w;  // 4 * PI * R ^ 2 / ( ( 4 / 3 ) * PI * R ^ 3 * rho ) = 0.0030054 / r (rho = 998)
-
     int is_outside = any(islessequal(pos.xyz, sim_desc.hi.s012) | isgreaterequal(pos.xyz, sim_desc.hi.s012 + sim_desc.hi.s456));
     
     if (is_outside) {
@@ -768,9 +1017,24 @@ __kernel void el_atts(__global float4 *p,                  // position (x, y, z)
         float4 r = rand(&seed);
 
         //pos.xyz = (float3)(fma(r.xy, sim_desc.hi.s45, sim_desc.hi.s01), MIN_HEIGHT);   // Feed from the bottom
-        pos.xyz = fma(r.xyz, sim_desc.hi.s456, sim_desc.hi.s012);
+        if (placement_grid) {
+            // A new cell comes with a new weight
+            r = placement_sample(r, placement, placement_grid, sim_desc);
+            pos.xyz = r.xyz;
+            x[i] = compute_ellipsoid_rcs(pos.w, drop_rcs, drop_rcs_desc) * r.w;
+        } else if (sector_width > 0.0f) {
+            pos = sector_sample(pos, sector_width, &seed, sim_desc);
+        } else {
+            pos.xyz = fma(r.xyz, sim_desc.hi.s456, sim_desc.hi.s012);
+        }
         vel = FLOAT4_ZERO;
 
+    } else if (sector_width > 0.0f && fabs(sector_offset(pos, sim_desc)) > sector_width) {
+        
+        // Recycled into the leading edge of the sector with the background wind there
+        pos = sector_fold(pos, sector_offset(pos, sim_desc), sector_width, &seed, sim_desc);
+        vel = read_imagef(wind_uvwt, sampler, wind_table_index(pos, wind_desc, sim_desc));
+        
     } else {
 
         // Derive the lookup index
@@ -785,40 +1049,50 @@ __kernel void el_atts(__global float4 *p,                  // position (x, y, z)
         
         if (delta_v_abs > 1.0e-3f) {
 
-            float re = rho_over_mu_air * (2.0f * pos.w) * delta_v_abs;
-            float cd = 24.0f / re + 6.0f / (1.0f + sqrt(re)) + 0.4f;
-            float4 dudt = (0.5f * rho_air * cd * area_over_mass_particle * delta_v_abs) * delta_v + (float4)(0.0f, 0.0f, -9.8f, 0.0f);
+            float4 dudt = integrate_drop_dudt(vel, bg_vel, pos.w, sim_desc.sf, concept);
 
-            vel += dudt * dt;
+            vel += dudt * dt_phys;
 
             // Bound the velocity change
             if (concept & RSSimulationConceptBoundedParticleVelocity && length(vel) > max(1.0f, 3.0f * length(bg_vel))) {
                 //vel = normalize(vel) * length(bg_vel) + (float4)(0.0f, 0.0f, -9.8f, 0.0f) * dt;
-                vel = bg_vel + (float4)(0.0f, 0.0f, -9.8f, 0.0f) * dt;
+                vel = bg_vel + (float4)(0.0f, 0.0f, -9.8f, 0.0f) * dt_phys;
             }
 
         } else {
 
-            vel += (float4)(0.0f, 0.0f, -9.8f, 0.0f) * dt;
+            vel += (float4)(0.0f, 0.0f, -9.8f, 0.0f) * dt_phys;
 
         }
-        
-        rcs = compute_ellipsoid_rcs(pos, drop_rcs, drop_rcs_desc);
-        
-    //    if (get_global_id(0) < 3) {
-    //        float a = length(rcs.s01);
-    //        float b = length(rcs.s23);
-    //        float r = a / b;
-    //        printf("D %.1fmm   rcs=%.3v4e  a=%.3e  b=%.3e  h/v=%.2f dB\n", pos.w * 2000.0f, rcs, a, b, 20 * log10(r));
-    //    }
     }
 
     p[i] = pos;
     v[i] = vel;
-    x[i] = rcs;
     y[i] = seed;
 }
 
+//
+// ellipsoid coefficients, resolved once at population since the drop radius does not change,
+// scaled by the amplitude weight of the placement cell if placement_grid > 0
+//
+__kernel void el_rcs(__global __read_only float4 *p,
+                     __global float4 *x,
+                     __constant float4 *drop_rcs,
+                     const float4 drop_rcs_desc,
+                     __constant float2 *placement,
+                     const uint placement_grid,
+                     const float16 sim_desc)
+{
+    const unsigned int i = get_global_id(0);
+    const float4 pos = p[i];
+    
+    float4 rcs = compute_ellipsoid_rcs(pos.w, drop_rcs, drop_rcs_desc);
+    if (placement_grid) {
+        rcs *= placement_weight(pos, placement, placement_grid, sim_desc);
+    }
+    x[i] = rcs;
+}
+
 //
 // debris attributes
 //
@@ -827,6 +1101,8 @@ __kernel void db_atts(__global float4 *p,
                       __global float4 *v,
                       __global float4 *t,
                       __global float4 *x,
+                      __global float4 *q,
+                      const unsigned int rcq_origin,
                       __global uint4 *y,
                       __read_only image3d_t wind_uvw,
                       const float16 wind_desc,
@@ -835,6 +1111,7 @@ __kernel void db_atts(__global float4 *p,
                       const float16 adm_desc,
                       __read_only image2d_t rcs_real,
                       __read_only image2d_t rcs_imag,
+                      __read_only image3d_t rcs_gamma,
                       const float16 rcs_desc,
                       const float16 sim_desc)
 {
@@ -851,6 +1128,7 @@ __kernel void db_atts(__global float4 *p,
     const uint concept = *(uint *)&s5;
 
     const float4 dt = (float4)(sim_desc.sb, sim_desc.sb, sim_desc.sb, 0.0f);
+    const float4 dt_phys = (float4)(sim_desc.sf, sim_desc.sf, sim_desc.sf, 0.0f);
     
     //
     // Update orientation & position ---------------------------------
@@ -899,21 +1177,24 @@ __kernel void db_atts(__global float4 *p,
         t[i] = tum;
         x[i] = rcs;
         y[i] = seed;
+        if (rcs_desc.sb > 0.0f) {
+            q[i - rcq_origin] = FLOAT4_ZERO;
+        }
         
         return;
     }
 
     float4 vel_bg = compute_bg_vel(pos, wind_uvw, wind_desc, sim_desc);
 
-    float4 dwdt, dudt = compute_dudt_dwdt(&dwdt, vel, vel_bg, ori, adm_cd, adm_cm, adm_desc);
+    float4 dwdt, dudt = integrate_dudt_dwdt(&dwdt, vel, vel_bg, ori, adm_cd, adm_cm, adm_desc, sim_desc.sf, concept);
     
     // bound the velocity
-    if (concept & RSSimulationConceptBoundedParticleVelocity && length(vel.xy + dudt.xy * dt.xy) > 3.0f * length(vel_bg.xy)) {
+    if (concept & RSSimulationConceptBoundedParticleVelocity && length(vel.xy + dudt.xy * dt_phys.xy) > 3.0f * length(vel_bg.xy)) {
         //printf("vel = [%5.2v4f]  vel_bg = [%5.2v4f]\n", vel, vel_bg);
         vel.xy = vel_bg.xy;
-        vel.z += dudt.z * dt.z;
+        vel.z += dudt.z * dt_phys.z;
     } else {
-        vel += dudt * dt;
+        vel += dudt * dt_phys;
     }
 
     float4 dw = dwdt * dt;
@@ -926,26 +1207,181 @@ __kernel void db_atts(__global float4 *p,
     
     tum = normalize(tum);
 
-    rcs = compute_debris_rcs(pos, ori, rcs_real, rcs_imag, rcs_desc, sim_desc);
+    // Orientation and line of sight within the tolerance of the last evaluation keep the RCS
+    const float4 rot = compute_debris_rotation(pos, ori);
+    if (!debris_rcs_is_current(rot, q, i - rcq_origin, rcs_desc)) {
+        x[i] = compute_debris_rcs(rot, rcs_real, rcs_imag, rcs_gamma, rcs_desc, sim_desc);
+    }
     
     // Copy back to global memory space
     p[i] = pos;
     o[i] = ori;
     v[i] = vel;
     t[i] = tum;
-    x[i] = rcs;
 }
 
 __kernel void db_rcs(__global float4 *p,
                      __global float4 *o,
                      __global float4 *x,
+                     __global float4 *q,
+                     const unsigned int rcq_origin,
                      __read_only image2d_t rcs_real,
                      __read_only image2d_t rcs_imag,
+                     __read_only image3d_t rcs_gamma,
                      const float16 rcs_desc,
                      const float16 sim_desc)
 {
     const unsigned int i = get_global_id(0);
-    x[i] = compute_debris_rcs(p[i], o[i], rcs_real, rcs_imag, rcs_desc, sim_desc);
+    const float4 rot = compute_debris_rotation(p[i], o[i]);
+    if (!debris_rcs_is_current(rot, q, i - rcq_origin, rcs_desc)) {
+        x[i] = compute_debris_rcs(rot, rcs_real, rcs_imag, rcs_gamma, rcs_desc, sim_desc);
+    }
+}
+
+//
+// kinematic sub-step in between the full physics updates, velocity and tumble are held
+//
+__kernel void kin_atts(__global float4 *p,
+                       __global float4 *o,
+                       __global float4 *v,
+                       __global float4 *t,
+                       const float16 sim_desc,
+                       const int tumbling)
+{
+    const unsigned int i = get_global_id(0);
+    const float4 dt = (float4)(sim_desc.sb, sim_desc.sb, sim_desc.sb, 0.0f);
+    
+    p[i] = fma(v[i], dt, p[i]);
+    
+    if (tumbling) {
+        o[i] = normalize(quat_mult(o[i], t[i]));
+    }
+}
+
+
+//
+// initial scatterer attributes, each draw is a hash of the element index and a per-stream key from
+// the seed, a bijection of the index so no two elements share a draw; dsd_mode = 0 (none), 1 (cdf) or 2 (uniform);
+// placement_grid = 0 (uniform) or the cells per side of the importance-sampled placement
+//
+__kernel void scat_pop(__global float4 *p,
+                       __global float4 *o,
+                       __global float4 *v,
+                       __global float4 *t,
+                       __global float4 *a,
+                       __global float4 *x,
+                       __global uint4 *y,
+                       __global uint *dsd_pop,
+                       __local uint *dsd_hist,
+                       __constant float *dsd_cdf,
+                       __constant float *dsd_r,
+                       const uint dsd_count,
+                       const uint dsd_mode,
+                       __constant float2 *placement,
+                       const uint placement_grid,
+                       const float sector_width,
+                       const uint seed,
+                       const uint index_offset,
+                       const uint count,
+                       const float16 sim_desc)
+{
+    const unsigned int i = get_global_id(0);
+    const unsigned int l = get_local_id(0);
+    const unsigned int m = get_local_size(0);
+    unsigned int b;
+    
+    for (b = l; b < dsd_count; b += m) {
+        dsd_hist[b] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    
+    if (i - get_global_offset(0) < count) {
+        const uint s = hash_uint(seed);
+        const uint k = index_offset + i;
+        const uint4 h = (uint4)(hash_uint(k ^ hash_uint(s)),
+                                hash_uint(k ^ hash_uint(s + 1)),
+                                hash_uint(k ^ hash_uint(s + 2)),
+                                hash_uint(k ^ hash_uint(s + 3)));
+        const float4 r = convert_float4(h >> 8) * (1.0f / 16777216.0f);
+        
+        float radius = 0.0f;
+        float bin_index = 0.0f;
+        if (dsd_mode) {
+            const float u = (float)(hash_uint(k ^ hash_uint(s + 4)) >> 8) * (1.0f / 16777216.0f);
+            if (dsd_mode == 2) {
+                b = min((uint)(u * (float)dsd_count), dsd_count - 1);
+            } else {
+                b = dsd_count;
+                while (b > 0) {
+                    b--;
+                    if (u >= dsd_cdf[b]) {
+                        break;
+                    }
+                }
+            }
+            radius = dsd_r[b];
+            bin_index = ((float)b + 0.5f) / (float)dsd_count;
+            atomic_inc(&dsd_hist[b]);
+        }
+        
+        // Park-Miller seeds must be in [1, 2^31 - 2]
+        const uint4 z = (uint4)(hash_uint(k ^ hash_uint(s + 5)),
+                                hash_uint(k ^ hash_uint(s + 6)),
+                                hash_uint(k ^ hash_uint(s + 7)),
+                                hash_uint(k ^ hash_uint(s + 8))) & 0x7FFFFFFE;
+        uint4 seed_k = max(z, (uint4)(1, 1, 1, 1));
+        
+        if (placement_grid) {
+            const float u = (float)(hash_uint(k ^ hash_uint(s + 9)) >> 8) * (1.0f / 16777216.0f);
+            p[i] = (float4)(placement_sample((float4)(r.xyz, u), placement, placement_grid, sim_desc).xyz, radius);
+        } else if (sector_width > 0.0f) {
+            p[i] = (float4)(sector_sample(FLOAT4_ZERO, sector_width, &seed_k, sim_desc).xyz, radius);
+        } else {
+            p[i] = (float4)(sim_desc.hi.s012 + r.xyz * sim_desc.hi.s456, radius);
+        }
+        a[i] = (float4)(0.0f, r.w, bin_index, 1.0f);
+        v[i] = FLOAT4_ZERO;
+        o[i] = (float4)(0.5f, -0.5f, -0.5f, 0.5f);
+        t[i] = QUAT_IDENTITY;
+        x[i] = (float4)(1.0f, 0.0f, 1.0f, 0.0f);
+        y[i] = seed_k;
+    }
+    
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (b = l; b < dsd_count; b += m) {
+        if (dsd_hist[b]) {
+            atomic_add(&dsd_pop[b], dsd_hist[b]);
+        }
+    }
+}
+
+
+//
+// compact copy of position, velocity and orientation of selected scatterers, start + j * stride or index[j] if stride = 0
+// into out from element offset, which lets a ring of frames fill up one step at a time
+//
+__kernel void scat_gather(__global float4 *out,
+                          __global const float4 *p,
+                          __global const float4 *v,
+                          __global const float4 *o,
+                          __global const uint *index,
+                          const uint start,
+                          const uint stride,
+                          const uint count,
+                          const uint offset)
+{
+    const unsigned int j = get_global_id(0);
+    
+    if (j >= count) {
+        return;
+    }
+    
+    const unsigned int i = stride ? start + j * stride : index[j];
+    const unsigned int k = 3 * (offset + j);
+    
+    out[k    ] = p[i];
+    out[k + 1] = v[i];
+    out[k + 2] = o[i];
 }
 
 
@@ -1081,20 +1517,33 @@ __kernel void scat_sig_aux(__global float4 *s,
                            __global float4 *a,
                            __global __read_only float4 *p,
                            __global __read_only float4 *r,
+#if defined (RS_USE_WEIGHT_IMAGES)
+                           __read_only image1d_t angular_weight,
+#else
                            __constant float *angular_weight,
+#endif
                            const float4 angular_weight_desc,
+                           const unsigned int ellipsoid_count,
                            const float16 sim_desc)
 {
     const unsigned int i = get_global_id(0);
 
     float4 sig = s[i];
     float4 aux = a[i];
+    float4 rcs = r[i];
     
     //    RSSimulationDescriptionBeamUnitX     =  0,
     //    RSSimulationDescriptionBeamUnitY     =  1,
     //    RSSimulationDescriptionBeamUnitZ     =  2,
-    float angle = acos(dot(sim_desc.s012, normalize(p[i].xyz)));
+    const float3 u = normalize(p[i].xyz);
+    float angle = acos(dot(sim_desc.s012, u));
+    
+    // The first ellipsoid_count are drops with H and V coefficients, V = H + (V - H) cos^2(el) and cos^2(el) = 1 - u.z^2
+    if (i < ellipsoid_count) {
+        rcs.s23 = mix(rcs.s01, rcs.s23, 1.0f - u.z * u.z);
+    }
     
+#if !defined (RS_USE_WEIGHT_IMAGES)
     float2 table_s = (float2)(angular_weight_desc.s0, angular_weight_desc.s0);
     float2 table_o = (float2)(angular_weight_desc.s1, angular_weight_desc.s1) + (float2)(0.0f, 1.0f);
     float2 angle_2 = (float2)(angle, angle);
@@ -1106,6 +1555,7 @@ __kernel void scat_sig_aux(__global float4 *s,
     float2 fidx_dec = fract(fidx_raw, &fidx_int);
     
     iidx_int = convert_uint2(fidx_int);
+#endif
     
 //    if (i < 32) {
 //        float w = angular_weight[i];
@@ -1119,8 +1569,13 @@ __kernel void scat_sig_aux(__global float4 *s,
     // - s3 = angular weight (make_pulse_pass_1)
     //
     aux.s0 = length(p[i].xyz);
-    aux.s1 = aux.s1 + sim_desc.sf;
+    aux.s1 = aux.s1 + sim_desc.sb;
+#if defined (RS_USE_WEIGHT_IMAGES)
+    // Texel k is centered at k + 0.5, clamp to edge is the same as clamping the index to [0 ... xm]
+    aux.s3 = read_imagef(angular_weight, sampler, fma(angle, angular_weight_desc.s0, angular_weight_desc.s1 + 0.5f)).s0;
+#else
     aux.s3 = mix(angular_weight[iidx_int.s0], angular_weight[iidx_int.s1], fidx_dec.s0);
+#endif
     
     // Two-way power attenuation = 1.0 / R ^ 4 ==> amplitude attenuation = 1.0 / R ^ 2
     float atten = pown(aux.s0, -2);
@@ -1129,7 +1584,7 @@ __kernel void scat_sig_aux(__global float4 *s,
     // cosine & sine to represent exp(j phase)
     float cc, ss = sincos(phase, &cc);
 
-    sig = cl_complex_multiply(r[i], (float4)(cc, -ss, cc, -ss)) * atten;
+    sig = cl_complex_multiply(rcs, (float4)(cc, -ss, cc, -ss)) * atten;
     
 //    if (i == 0) {
 //        printf("atten = %.4e  %.4v4e\n", atten, sig);
@@ -1144,7 +1599,7 @@ __kernel void scat_sig_aux(__global float4 *s,
 // sig - signal
 // aux - auxiliary attributes
 // shared - local memory space __local space (64 kB max)
-// range_weight - range weighting function, __constant space (64 kB max)
+// range_weight - range weighting function, __constant space (64 kB max) or a 1-D image with RS_USE_WEIGHT_IMAGES
 // range_weight_desc - scale, offset, and max to convert range to table index
 // range_start - start range of the domain
 // range_delta - range spacing (not resolution)
@@ -1156,7 +1611,11 @@ __kernel void make_pulse_pass_1(__global float4 *out,
                                 __global __read_only float4 *sig,
                                 __global __read_only float4 *aux,
                                 __local float4 *shared,
+#if defined (RS_USE_WEIGHT_IMAGES)
+                                __read_only image1d_t range_weight,
+#else
                                 __constant float *range_weight,
+#endif
                                 const float4 range_weight_desc,
                                 const float range_start,
                                 const float range_delta,
@@ -1225,7 +1684,12 @@ __kernel void make_pulse_pass_1(__global float4 *out,
         for (k = 0; k < range_count; k++) {
             float4 dr_from_center = (float4)(r_a, r_a, r_b, r_b) - r;
             
-            // This part can probably be replaced by read_imagef()
+#if defined (RS_USE_WEIGHT_IMAGES)
+            // Range weight, the sampler does the clamping and the linear interpolation
+            fidx_raw = fma(dr_from_center, table_xs_4, table_x0_4 + 0.5f);
+            float2 w2 = (float2)(read_imagef(range_weight, sampler, fidx_raw.s0).s0,
+                                 read_imagef(range_weight, sampler, fidx_raw.s2).s0);
+#else
             fidx_raw = clamp(fma(dr_from_center, table_xs_4, table_x0_4), 0.0f, range_weight_desc.s2);     // Index [0 ... xm] in float
             fidx_dec = fract(fidx_raw, &fidx_int);                                                         // The integer and decimal fraction
             iidx_int = convert_uint4(fidx_int);
@@ -1234,6 +1698,7 @@ __kernel void make_pulse_pass_1(__global float4 *out,
             float2 w2 = mix((float2)(range_weight[iidx_int.s0], range_weight[iidx_int.s2]),
                             (float2)(range_weight[iidx_int.s1], range_weight[iidx_int.s3]),
                             fidx_dec.s02);
+#endif
             
             // Vectorized range * angular weights
             w_a = (float4)w2.s0;
@@ -1249,6 +1714,12 @@ __kernel void make_pulse_pass_1(__global float4 *out,
     
     unsigned int local_numel = range_count * local_size;
     
+#if defined (RS_USE_SUBGROUPS)
+    
+    consolidate_gates(shared, local_numel);
+    
+#else
+    
     // Consolidate the local memory
     if (local_size > 512 && local_id < 512)
     {
@@ -1320,6 +1791,8 @@ __kernel void make_pulse_pass_1(__global float4 *out,
     }
     barrier(CLK_LOCAL_MEM_FENCE);
     
+#endif
+    
     if (local_id == 0)
     {
         __global float4 *o = &out[group_id * range_count];
@@ -1331,6 +1804,124 @@ __kernel void make_pulse_pass_1(__global float4 *out,
 }
 
 
+//
+// Same as make_pulse_pass_1 but for a tile of gates, tile = get_group_id(1), so that the local
+// memory only needs tile_size x local_size accumulators. Output is still out[group_id * range_count + gate]
+// so the 2nd pass is the same.
+//
+// tile_size - number of gates per tile, the last tile may have fewer
+//
+__kernel void make_pulse_pass_1_tiled(__global float4 *out,
+                                      __global __read_only float4 *sig,
+                                      __global __read_only float4 *aux,
+                                      __local float4 *shared,
+#if defined (RS_USE_WEIGHT_IMAGES)
+                                      __read_only image1d_t range_weight,
+#else
+                                      __constant float *range_weight,
+#endif
+                                      const float4 range_weight_desc,
+                                      const float range_start,
+                                      const float range_delta,
+                                      const unsigned int range_count,
+                                      const unsigned int group_count,
+                                      const unsigned int n,
+                                      const unsigned int tile_size)
+{
+    const float4 zero = {0.0f, 0.0f, 0.0f, 0.0f};
+    const unsigned int group_id = get_group_id(0);
+    const unsigned int local_id = get_local_id(0);
+    const unsigned int local_size = get_local_size(0);
+    const unsigned int group_stride = 2 * local_size;
+    const unsigned int local_stride = group_stride * group_count;
+    const unsigned int gate_start = get_group_id(1) * tile_size;
+    const unsigned int gate_count = min(tile_size, range_count - gate_start);
+    
+    const float4 table_xs_4 = (float4)range_weight_desc.s0;
+    const float4 table_x0_4 = (float4)range_weight_desc.s1 + (float4)(0.0f, 1.0f, 0.0f, 1.0f);
+    const float4 r_start = (float4)(range_start + (float)gate_start * range_delta);
+    
+    float4 r;
+    float4 s_a;
+    float4 s_b;
+    float4 fidx_raw;
+    float4 fidx_int;
+    float4 fidx_dec;
+    uint4  iidx_int;
+    
+    unsigned int i = group_id * group_stride + local_id;
+    unsigned int j;
+    unsigned int k;
+    
+    for (k = 0; k < gate_count; k++) {
+        shared[local_id + k * local_size] = zero;
+    }
+    
+    while (i < n) {
+        j = i + local_size;
+        
+        const float r_a = aux[i].s0;
+        const float r_b = aux[j].s0;
+        
+        // Angular weight
+        s_a = sig[i] * aux[i].s3;
+        s_b = sig[j] * aux[j].s3;
+        
+        r = r_start;
+        for (k = 0; k < gate_count; k++) {
+            float4 dr_from_center = (float4)(r_a, r_a, r_b, r_b) - r;
+            
+#if defined (RS_USE_WEIGHT_IMAGES)
+            fidx_raw = fma(dr_from_center, table_xs_4, table_x0_4 + 0.5f);
+            float2 w2 = (float2)(read_imagef(range_weight, sampler, fidx_raw.s0).s0,
+                                 read_imagef(range_weight, sampler, fidx_raw.s2).s0);
+#else
+            fidx_raw = clamp(fma(dr_from_center, table_xs_4, table_x0_4), 0.0f, range_weight_desc.s2);
+            fidx_dec = fract(fidx_raw, &fidx_int);
+            iidx_int = convert_uint4(fidx_int);
+            
+            float2 w2 = mix((float2)(range_weight[iidx_int.s0], range_weight[iidx_int.s2]),
+                            (float2)(range_weight[iidx_int.s1], range_weight[iidx_int.s3]),
+                            fidx_dec.s02);
+#endif
+            
+            shared[local_id + k * local_size] += ((float4)w2.s0 * s_a + (float4)w2.s1 * s_b);
+            
+            r += range_delta;
+        }
+        i += local_stride;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    
+    const unsigned int local_numel = gate_count * local_size;
+    
+#if defined (RS_USE_SUBGROUPS)
+    
+    consolidate_gates(shared, local_numel);
+    
+#else
+    
+    // Consolidate the local memory, local_size is a power of 2
+    for (unsigned int s = local_size / 2; s > 0; s >>= 1) {
+        if (local_id < s) {
+            for (k = 0; k < local_numel; k += local_size) {
+                shared[local_id + k] += shared[local_id + k + s];
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    
+#endif
+    
+    if (local_id == 0) {
+        __global float4 *o = &out[group_id * range_count + gate_start];
+        for (k = 0; k < local_numel; k += local_size) {
+            *o++ = shared[k];
+        }
+    }
+}
+
+
 __kernel void make_pulse_pass_2_local(__global float4 *out,
                                       __global __read_only float4 *in,
                                       __local float4 *shared,
@@ -1401,6 +1992,36 @@ __kernel void make_pulse_pass_2_group(__global float4 *out,
     
     unsigned int i = local_id * range_count;
     
+#if defined (RS_USE_SUBGROUPS)
+    
+    // Subgroups add up in registers, the first work item adds up the subgroups. Odd and even gates
+    // alternate between two sets of slots, when they fit, so that one barrier per gate is enough
+    const unsigned int sub_id = get_sub_group_id();
+    const unsigned int sub_count = get_num_sub_groups();
+    const bool sub_lead = get_sub_group_local_id() == 0;
+    const unsigned int flip = 2 * sub_count <= local_size ? sub_count : 0;
+    
+    for (unsigned int k = 0; k < range_count; k++) {
+        __local float4 *slots = &shared[(k & 1) * flip];
+        float4 v = sub_group_reduce_add4(in[i + k] + in[i + k + group_stride]);
+        if (sub_lead) {
+            slots[sub_id] = v;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+        
+        if (local_id == 0) {
+            for (unsigned int g = 1; g < sub_count; g++) {
+                v += slots[g];
+            }
+            out[k] = v;
+        }
+        if (flip == 0) {
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+    }
+    
+#else
+    
     for (unsigned int k = 0; k < range_count; k++) {
         float4 a = in[i + k];
         float4 b = in[i + k + group_stride];
@@ -1468,6 +2089,125 @@ __kernel void make_pulse_pass_2_group(__global float4 *out,
             out[k] = shared[0];
         }
     }
+    
+#endif
+
+}
+
+//
+// pulse - pulse (Ih Qh Iv Qv) from make_pulse_pass_2, the emulated background is added in place
+// state - unit complex Gaussian pair of each gate, carried from pulse to pulse
+// seed - random seed of each gate
+// wind_uvwt - background wind
+// wind_desc - description of the background wind table
+// emulator_desc - drop moments, spread of the weights and the step since the last pulse (RSEmulatorDescription)
+// sim_desc - simulation description
+//
+__kernel void bg_emu(__global float4 *pulse,
+                     __global float4 *state,
+                     __global uint4 *seed,
+                     __read_only image3d_t wind_uvwt,
+                     const float16 wind_desc,
+                     const float16 emulator_desc,
+                     const float16 sim_desc)
+{
+    const unsigned int k = get_global_id(0);
+    const float r = fma((float)k, emulator_desc.s9, emulator_desc.s8);
+    const float3 u = sim_desc.s012;
+    
+    // Sigma points at sqrt(3) sigma along the beam and the two cross-beam directions carry the first two moments
+    // Any horizontal axis will do for a beam at the zenith
+    const float3 e_h = length(u.xy) > 1.0e-6f ? normalize((float3)(u.y, -u.x, 0.0f)) : (float3)(1.0f, 0.0f, 0.0f);
+    const float3 e_v = cross(e_h, u);
+    const float d = 1.7320508f * emulator_desc.s7;
+    float ca, sa = sincos(1.7320508f * emulator_desc.s6, &ca);
+    const float3 dir[6] = {u, u, ca * u + sa * e_h, ca * u - sa * e_h, ca * u + sa * e_v, ca * u - sa * e_v};
+    const float len[6] = {r + d, r - d, r, r, r, r};
+    
+    float vr;
+    float v_sum = 0.0f;
+    float v_sq = 0.0f;
+    float n = 0.0f;
+    for (int j = 0; j < 6; j++) {
+        const float4 pos = (float4)(len[j] * dir[j], 0.0f);
+        if (all(isgreater(pos.xyz, sim_desc.hi.s012)) && all(isless(pos.xyz, sim_desc.hi.s012 + sim_desc.hi.s456))) {
+            vr = dot(read_imagef(wind_uvwt, sampler, wind_table_index(pos, wind_desc, sim_desc)).xyz, dir[j]);
+            v_sum += vr;
+            v_sq += vr * vr;
+            n += 1.0f;
+        }
+    }
+    
+    // Radial velocity and its spread over the volume, falling drops add theirs along the beam
+    const float m = max(n, 1.0f);
+    const float v_mean = v_sum / m - emulator_desc.s4 * u.z;
+    const float v_var = max(v_sq / m - v_sum * v_sum / (m * m), 0.0f) + emulator_desc.s5 * u.z * u.z;
+    
+    // AR(1) in pulses: Doppler shift of the mean, Gaussian spectrum of the spread, and the beam motion
+    const float dt = emulator_desc.sa;
+    const float rho = emulator_desc.sb * exp(-0.5f * sim_desc.s4 * sim_desc.s4 * dt * dt * v_var);
+    float cc, ss = sincos(sim_desc.s4 * v_mean * dt, &cc);
+    
+    uint4 y = seed[k];
+    const float4 q = rand(&y);
+    const float2 a = sqrt(-log(q.s01));
+    float2 cq, sq = sincos(2.0f * M_PI_F * q.s23, &cq);
+    const float4 g = cl_complex_multiply(state[k], (float4)(cc, -ss, cc, -ss)) * rho
+                   + (float4)(a.s0 * cq.s0, a.s0 * sq.s0, a.s1 * cq.s1, a.s1 * sq.s1) * sqrt(1.0f - rho * rho);
+    
+    // Power of the gate from the part of the volume inside the domain, V blended to the elevation as in scat_sig_aux
+    const float b = 1.0f - u.z * u.z;
+    const float f = emulator_desc.sc * n / (6.0f * r * r);
+    const float p_h = emulator_desc.s0 * f;
+    const float p_v = ((1.0f - b) * (1.0f - b) * emulator_desc.s0 + b * b * emulator_desc.s1 + 2.0f * b * (1.0f - b) * emulator_desc.s2) * f;
+    const float2 c_hv = ((1.0f - b) * (float2)(emulator_desc.s0, 0.0f) + b * emulator_desc.s23) * f;
+    
+    // H from the first of the pair, V from both so that E[H V*] = c_hv
+    if (p_h > 0.0f) {
+        const float sh = sqrt(p_h);
+        const float sv = sqrt(max(p_v - dot(c_hv, c_hv) / p_h, 0.0f));
+        pulse[k] += (float4)(sh * g.s0,
+                             sh * g.s1,
+                             (c_hv.s0 * g.s0 + c_hv.s1 * g.s1) / sh + sv * g.s2,
+                             (c_hv.s0 * g.s1 - c_hv.s1 * g.s0) / sh + sv * g.s3);
+    }
+    
+    state[k] = g;
+    seed[k] = y;
+}
+
+//
+// acc - accumulated correlations, three float4 per gate
+//       acc[3k]     = (|H|^2, |V|^2, re(V H*), im(V H*))
+//       acc[3k + 1] = (re(H H'*), im(H H'*), re(V V'*), im(V V'*)) with ' = previous pulse
+//       acc[3k + 2] = previous pulse
+// pulse - pulse (Ih Qh Iv Qv) from make_pulse_pass_2
+// gain - amplitude gain, see RS_merge_pulse_tmp()
+// first - first pulse of a dwell, clears the accumulators
+//
+__kernel void moment_acc(__global float4 *acc,
+                         __global __read_only float4 *pulse,
+                         const float gain,
+                         const int first)
+{
+    const unsigned int k = get_global_id(0);
+    const float4 x = pulse[k] * gain;
+    
+    float4 a0 = FLOAT4_ZERO;
+    float4 a1 = FLOAT4_ZERO;
+    
+    if (!first) {
+        const float4 p = acc[3 * k + 2];
+        a0 = acc[3 * k];
+        a1 = acc[3 * k + 1] + (float4)(x.s0 * p.s0 + x.s1 * p.s1, x.s1 * p.s0 - x.s0 * p.s1,
+                                       x.s2 * p.s2 + x.s3 * p.s3, x.s3 * p.s2 - x.s2 * p.s3);
+    }
+    a0 += (float4)(x.s0 * x.s0 + x.s1 * x.s1, x.s2 * x.s2 + x.s3 * x.s3,
+                   x.s2 * x.s0 + x.s3 * x.s1, x.s3 * x.s0 - x.s2 * x.s1);
+    
+    acc[3 * k] = a0;
+    acc[3 * k + 1] = a1;
+    acc[3 * k + 2] = x;
 }
 
 // Generate some random data
@@ -75,6 +75,9 @@ typedef struct _rs_pulse_params {
     float         range_start;
     float         range_delta;
     
+    unsigned int  tile_size;          // gates per tile of the 1st pass, range_count when not tiled
+    unsigned int  tile_count;         // tiles of the 1st pass, the 2nd dimension of its NDRange
+    
     unsigned int  entry_counts[2];    // entry count of the 2-pass reduction
     unsigned int  group_counts[2];    // group count of the 2-pass reduction
     
@@ -146,6 +149,26 @@ typedef struct _rs_box {
     RSPolar size;
 } RSBox;
 
+// A scatterer from the selective downloads, uid is the same as in scat_uid
+typedef struct _rs_particle {
+    cl_float4 pos;
+    cl_float4 vel;
+    cl_float4 ori;
+    cl_uint4  uid;
+} RSParticle;
+
+// A trajectory file is this header, count uids of uint32_t, then frames of a float time and count x (pos, vel, ori) of cl_float4
+#define RS_TRAJECTORY_FILE_MAGIC    "SRTJ"
+#define RS_TRAJECTORY_FILE_VERSION  1
+typedef struct _rs_trajectory_file_header {
+    char      magic[4];
+    uint32_t  version;
+    uint32_t  count;          // Number of particles in every frame
+    uint32_t  reserved;
+} RSTrajectoryFileHeader;
+
+typedef struct _rs_trajectory RSTrajectory;
+
 
 // A typical convention for table description, which is a set of parameters along with a table
 enum RSTable1DDescrip {
@@ -167,7 +190,7 @@ enum RSTable3DDescription {
     RSTable3DDescriptionMaximumX    =  8,
     RSTable3DDescriptionMaximumY    =  9,
     RSTable3DDescriptionMaximumZ    = 10,
-    RSTable3DDescription11          = 11,
+    RSTable3DDescriptionRCSTolerance = 11,
     RSTable3DDescriptionRecipInLnX  = 12,
     RSTable3DDescriptionRecipInLnY  = 13,
     RSTable3DDescriptionRecipInLnZ  = 14,
@@ -209,7 +232,26 @@ enum RSSimulationDescription {
     RSSimulationDescriptionBoundSizeX             =  12, // hi.s4
     RSSimulationDescriptionBoundSizeY             =  13, // hi.s5
     RSSimulationDescriptionBoundSizeZ             =  14, // hi.s6
-    RSSimulationDescription15                     =  15  //
+    RSSimulationDescriptionPhysicsStep            =  15  // Time step of the velocity updates
+};
+
+enum RSEmulatorDescription {
+    RSEmulatorDescriptionPowerH                   =  0,  // Drop moments per m^3: E|H|^2, E|V|^2 and E[H V*]
+    RSEmulatorDescriptionPowerV                   =  1,
+    RSEmulatorDescriptionCrossReal                =  2,
+    RSEmulatorDescriptionCrossImag                =  3,
+    RSEmulatorDescriptionFallSpeed                =  4,  // Power-weighted terminal velocity of the drops
+    RSEmulatorDescriptionFallSpeedVariance        =  5,
+    RSEmulatorDescriptionSigmaAngle               =  6,  // Spread of the two-way power pattern in each cross-beam direction
+    RSEmulatorDescriptionSigmaRange               =  7,  // Spread of the two-way range weight
+    RSEmulatorDescriptionRangeStart               =  8,
+    RSEmulatorDescriptionRangeDelta               =  9,
+    RSEmulatorDescriptionTimeStep                 =  10, // Time since the last emulated pulse
+    RSEmulatorDescriptionScanCorrelation          =  11, // Correlation left by the beam motion since the last emulated pulse
+    RSEmulatorDescriptionVolume                   =  12, // Solid angle x range extent of the power weights, r^2 x this is the volume
+    RSEmulatorDescription13                       =  13,
+    RSEmulatorDescription14                       =  14,
+    RSEmulatorDescription15                       =  15
 };
 
 enum RSDropSizeDistribution {
@@ -242,7 +284,18 @@ enum RSSimulationConcept {
     RSSimulationConceptBoundedParticleVelocity     = 1 << 2,
     RSSimulationConceptUniformDSDScaledRCS         = 1 << 3,
     RSSimulationConceptFixedScattererPosition      = 1 << 4,
-    RSSimulationConceptVerticallyPointingRadar     = 1 << 5
+    RSSimulationConceptVerticallyPointingRadar     = 1 << 5,
+    RSSimulationConceptRungeKutta2                 = 1 << 6,
+    RSSimulationConceptRungeKutta4                 = 1 << 7,
+    RSSimulationConceptImportanceSampledPlacement  = 1 << 8,
+    RSSimulationConceptEmulatedBackground          = 1 << 9
+};
+
+typedef uint32_t RSIntegrator;
+enum RSIntegrator {
+    RSIntegratorEuler                              = RSSimulationConceptNull,
+    RSIntegratorRungeKutta2                        = RSSimulationConceptRungeKutta2,
+    RSIntegratorRungeKutta4                        = RSSimulationConceptRungeKutta4
 };
 
 #pragma pack(push, 1)
@@ -261,9 +314,11 @@ typedef struct _rs_worker {
     
     // Scatter bodies
     size_t                 num_scats;
+    size_t                 rcq_numel;
     
     size_t                 origins[RS_MAX_DEBRIS_TYPES];
     size_t                 counts[RS_MAX_DEBRIS_TYPES];
+    cl_uint                ellipsoid_count;    // leading drops whose scat_rcs are H and V coefficients, 0 before RS_populate()
     
     RSMakePulseParams      make_pulse_params;
     
@@ -274,14 +329,22 @@ typedef struct _rs_worker {
     cl_mem                 scat_tum;   // alpha, beta, gamma tumbling
     cl_mem                 scat_aux;   // type, dot products, range, etc.
     cl_mem                 scat_rcs;   // radar cross section: Ih Qh Iv Qv
+    cl_mem                 scat_rcq;   // rotation of the last debris RCS evaluation from counts[0] on, one element if the RCS tolerance is off
     cl_mem                 scat_sig;   // signal: Ih Qh Iv Qv
     cl_mem                 scat_rnd;   // random seed
     cl_mem                 scat_clr;   // color
     cl_mem                 work;
     cl_mem                 pulse;
+    cl_mem                 moment_acc; // lag-0 / lag-1 correlations of the current dwell
+    cl_mem                 gather;     // compact copies of selected scatterers
+    cl_mem                 gather_idx; // indices of the selected scatterers
+    size_t                 gather_capacity;
     
     cl_mem                 range_weight;
     cl_float4              range_weight_desc;
+    char                   weight_images;    // range_weight and angular_weight are 1-D images
+    size_t                 weight_image_max; // widest 1-D image of the device
+    char                   program_options[64];  // build options besides RS_USE_WEIGHT_IMAGES
     
     cl_mem                 angular_weight;
     cl_float4              angular_weight_desc;
@@ -289,12 +352,18 @@ typedef struct _rs_worker {
     cl_mem                 rcs_ellipsoid;                // RCS of background scatterers
     cl_float4              rcs_ellipsoid_desc;           // RCS-desc of background scatterers
     
+    cl_mem                 placement;                    // cdf and amplitude weight of the placement cells, one element if uniform
+    
+    cl_mem                 emulator_state;               // Unit complex Gaussian pair of each gate for the background emulator, NULL if off
+    cl_mem                 emulator_seed;                // Random seed of each gate for the background emulator
+    
     cl_mem                 adm_cd[RS_MAX_ADM_TABLES];    // ADM-cd of debris
     cl_mem                 adm_cm[RS_MAX_ADM_TABLES];    // ADM-cm of debris
     cl_float16             adm_desc[RS_MAX_ADM_TABLES];  // ADM-desc of debris
     
     cl_mem                 rcs_real[RS_MAX_RCS_TABLES];  // RCS of debris
     cl_mem                 rcs_imag[RS_MAX_RCS_TABLES];  // RCS of debris
+    cl_mem                 rcs_gamma[RS_MAX_RCS_TABLES]; // RCS of debris with the gamma projection, used when desc MaximumZ > 0
     cl_float16             rcs_desc[RS_MAX_RCS_TABLES];  // RCS-desc of debris
     
     cl_mem                 les_uvwt[2];                  // Double buffering of u, v, w, t
@@ -340,14 +409,21 @@ typedef struct _rs_worker {
     cl_kernel              kern_bg_atts;
     cl_kernel              kern_fp_atts;
     cl_kernel              kern_el_atts;
+    cl_kernel              kern_el_rcs;
     cl_kernel              kern_db_atts;
+    cl_kernel              kern_kin_atts;
+    cl_kernel              kern_scat_pop;
+    cl_kernel              kern_scat_gather;
     cl_kernel              kern_scat_clr;
     cl_kernel              kern_scat_sig_aux;
     cl_kernel              kern_make_pulse_pass_1;
+    cl_kernel              kern_make_pulse_pass_1_tiled;
     cl_kernel              kern_make_pulse_pass_2;
     cl_kernel              kern_make_pulse_pass_2_group;
     cl_kernel              kern_make_pulse_pass_2_local;
     cl_kernel              kern_make_pulse_pass_2_range;
+    cl_kernel              kern_moment_acc;
+    cl_kernel              kern_bg_emu;
     
     cl_command_queue       que;
     cl_event               event_upload;
@@ -369,33 +445,55 @@ struct _rs_handle {
     char                   method;
     RSParams               params;
     unsigned int           random_seed;
+    int                    partition_index;   // This process's portion of a population that is split across processes
+    int                    partition_count;
 
     // Various simualtor state variables
     char                   status;
     RSfloat                sim_tic;
     RSfloat                sim_toc;
+    int                    physics_step[RS_MAX_DEBRIS_TYPES];    // Number of pulses per full physics update of each type
+    int                    physics_count[RS_MAX_DEBRIS_TYPES];   // Pulses since the last full physics update of each type
     cl_float16             sim_desc;
     RSSimulationConcept    sim_concept;
     
     // Table related variables
     uint32_t               vel_idx;
     uint32_t               vel_count;
+    RSfloat                vel_max;           // Maximum wind speed of the current table
+    RSfloat                vel_cell;          // Smallest cell size of the current table
     uint32_t               adm_idx;
     uint32_t               adm_count;
     uint32_t               rcs_idx;
     uint32_t               rcs_count;
+    uint32_t               rcs_gamma_count;   // Gamma angles of the baked RCS tables, 0 = projection in the kernel
+    RSfloat                rcs_tolerance;     // Rotation (rad) before the debris RCS is evaluated again, 0 = every time
+    RSTable                range_weight;      // Host copies of the weight tables for the placement density
+    RSTable                angular_weight;
+    cl_float2              *placement;        // cdf and amplitude weight of the placement cells, NULL = uniform
+    cl_uint                placement_grid;    // Cells per side of the placement, 0 = uniform
+    RSfloat                sector_width;      // Half width (rad) of the sliding sector around the beam azimuth, 0 = whole domain
+    char                   bg_emulator;       // Background comes from the per-gate emulator, the drops are a transparent token
+    cl_float16             emulator_desc;     // See RSEmulatorDescription
+    cl_float4              emulator_beam;     // Beam of the last emulated pulse
+    RSfloat                emulator_tic;      // Time of the last emulated pulse, < 0 before the first
     
     // Table parameter shadow copy: only the constants, not the pointers
     LESTable               vel_desc;
     ADMTable               adm_desc[RS_MAX_DEBRIS_TYPES];
     RCSTable               rcs_desc[RS_MAX_DEBRIS_TYPES];
+    char                   adm_shared[RS_MAX_DEBRIS_TYPES];   // Slot holds the images of an earlier slot of the same table
+    char                   rcs_shared[RS_MAX_DEBRIS_TYPES];
+    const float            *adm_key[RS_MAX_DEBRIS_TYPES];     // Host data of the file table in each slot, one pointer per content
+    const float            *rcs_key[RS_MAX_DEBRIS_TYPES];
     
     // Scatter bodies
     size_t                 num_scats;
     size_t                 num_types;
     size_t                 counts[RS_MAX_DEBRIS_TYPES];
     
-    // CPU side memory (for upload/download)
+    // CPU side memory (for upload/download), allocated on first use
+    cl_mem                 scat_mirror[RS_HOST_MIRROR_COUNT];   // Pinned buffers behind the arrays below, NULL if plain memory
     cl_uint4               *scat_uid;       // universal id
     cl_float4              *scat_pos;       // position
     cl_float4              *scat_vel;       // velocity
@@ -408,6 +506,15 @@ struct _rs_handle {
     cl_float4              *pulse;
     
     cl_float4              *pulse_tmp[RS_MAX_GPU_DEVICE];
+    cl_float4              *moment_acc;     // lag-0 / lag-1 correlations, 3 x range_count
+    
+    // Recorder of the tagged particles, NULL when it is off
+    RSTrajectory           *trajectory;
+    
+    // Moment processor
+    int                    moment_dwell;    // Number of pulses per radial
+    int                    moment_count;    // Number of pulses accumulated in the current dwell
+    char                   moment_on_host;  // Accumulated from merged pulses on the host
     
     size_t                 mem_size;
     
@@ -425,6 +532,7 @@ struct _rs_handle {
     // GPU side memory
     RSWorker               workers[RS_MAX_GPU_DEVICE];
     size_t                 offset[RS_MAX_GPU_DEVICE];
+    float                  worker_share[RS_MAX_GPU_DEVICE];   // Relative throughput of each worker for population split
     
     // Anchors
     ssize_t                num_anchors;
@@ -467,6 +575,7 @@ cl_uint RS_gpu_count(void);
 RSHandle *RS_init_with_path(const char *bundle_path, RSMethod method, cl_context_properties sharegroup, const char verb);
 //RSHandle *RS_init_with_path(const char *bundle_path, RSMethod method, const char verb);
 RSHandle *RS_init_for_cpu_verbose(const char verb);
+RSHandle *RS_init_for_hybrid_verbose(const char verb);
 RSHandle *RS_init_verbose(const char verb);
 RSHandle *RS_init(void);
 void RS_free(RSHandle *H);
@@ -477,12 +586,18 @@ RSMakePulseParams RS_make_pulse_params(const cl_uint count, const cl_uint group_
 #pragma mark Radar and Simulation Parameters
 
 void RS_set_concept(RSHandle *H, RSSimulationConcept c);
+void RS_set_integrator(RSHandle *H, const RSIntegrator integrator);
 char *RS_simulation_concept_string(RSHandle *);
 char *RS_simulation_concept_bulleted_string(RSHandle *H);
 
 void RS_set_prt(RSHandle *H, const RSfloat prt);
+void RS_set_physics_step(RSHandle *H, const int count);
+void RS_set_physics_step_of_type(RSHandle *H, const int type, const int count);
+void RS_set_debris_rcs_gamma_resolution(RSHandle *H, const int count);
+void RS_set_debris_rcs_tolerance(RSHandle *H, const RSfloat angle_deg);
 void RS_set_lambda(RSHandle *H, const RSfloat lambda);
 void RS_set_density(RSHandle *H, const RSfloat density);
+void RS_set_sector_width(RSHandle *H, const RSfloat width_deg);
 void RS_set_antenna_params(RSHandle *H, RSfloat beamwidth_deg, RSfloat gain_dbi);
 void RS_set_tx_params(RSHandle *H, RSfloat pulsewidth, RSfloat tx_power_watt);
 void RS_set_scan_box(RSHandle *H,
@@ -492,6 +607,8 @@ void RS_set_scan_box(RSHandle *H,
 void RS_set_beam_pos(RSHandle *H, RSfloat az_deg, RSfloat el_deg);
 void RS_set_verbosity(RSHandle *H, const char verb);
 void RS_set_debris_count(RSHandle *H, const int debris_id, const size_t count);
+void RS_set_worker_share(RSHandle *H, const int worker_id, const float share);
+void RS_set_population_partition(RSHandle *H, const int index, const int count);
 size_t RS_get_debris_count(RSHandle *H, const int debris_id);
 size_t RS_get_worker_debris_count(RSHandle *H, const int debris_id, const int worker_id);
 size_t RS_get_all_worker_debris_counts(RSHandle *H, const int debris_id, size_t counts[]);
@@ -550,15 +667,36 @@ void RS_download_position_only(RSHandle *H);
 void RS_download_orientation_only(RSHandle *H);
 void RS_download_pulse_only(RSHandle *H);
 
+// Only a few particles through a compact buffer on the device, type 0 is the background, 1, 2, ... are the debris
+size_t RS_get_type_sample_count(RSHandle *H, const int type, const size_t stride);
+size_t RS_download_type(RSHandle *H, const int type, const size_t stride, RSParticle *particles);
+size_t RS_download_uids(RSHandle *H, const uint32_t *uids, const size_t count, RSParticle *particles);
+
+// Tagged particles are copied into a ring of depth steps on the device after every time step, full rings are written to filename in the background, depth = 0 for RS_TRAJECTORY_DEPTH
+int RS_start_trajectory_recorder(RSHandle *H, const char *filename, const uint32_t *uids, const size_t count, const int depth);
+void RS_stop_trajectory_recorder(RSHandle *H);
+
 //void RS_rcs_from_dsd(RSHandle *H);
 void RS_compute_rcs_ellipsoids(RSHandle *H);
 
 #pragma mark - Simulation Time Evolution
 
 void RS_advance_time(RSHandle *H);
+RSfloat RS_get_adaptive_time_step(RSHandle *H, const RSfloat dt_max);
+RSfloat RS_advance_time_adaptive(RSHandle *H, const RSfloat dt_max);
 void RS_advance_beam(RSHandle *H);
 void RS_make_pulse(RSHandle *H);
 
+#pragma mark - Moment Processing
+
+// Pulse pair moments over a dwell, accumulated on the device when there is only one worker.
+// With a population split across processes, only the summed pulses can be used through
+// RS_accumulate_moments_from_pulse().
+void RS_set_moment_dwell(RSHandle *H, const int count);
+int RS_accumulate_moments(RSHandle *H);
+int RS_accumulate_moments_from_pulse(RSHandle *H, const cl_float4 *pulse);
+void RS_download_moments(RSHandle *H, RSMoment *moments);
+
 #pragma mark - General Table Allocation
 
 RSTable RS_table_init(size_t numel);
@@ -17,11 +17,17 @@
 #define RS_MAX_KERNEL_LINES      2048
 #define RS_MAX_KERNEL_SRC      131072
 #define RS_ALIGN_SIZE             128     // Align size. Be sure to have a least 16 for SSE, 32 for AVX, 64 for AVX-512
-#define RS_MAX_GATES              512
+#define RS_HOST_MIRROR_COUNT        9     // uid, pos, vel, ori, tum, aux, rcs, sig, rnd
+#define RS_MAX_GATES             8192
+#define RS_TRAJECTORY_DEPTH        64     // Default number of steps in the device ring of the trajectory recorder
 #define RS_CL_GROUP_ITEMS          64
 #define RS_MAX_DEBRIS_TYPES         8
 #define RS_MAX_ADM_TABLES           RS_MAX_DEBRIS_TYPES
 #define RS_MAX_RCS_TABLES           RS_MAX_DEBRIS_TYPES
+#define RS_PLACEMENT_GRID          16     // Cells per side of the importance-sampled placement density
+#define RS_PLACEMENT_FLOOR          0.1   // Share of the importance-sampled placement that stays uniform
+#define RS_ADAPTIVE_SAFETY          0.4   // Fraction of the integrator stability limit used by the adaptive time step
+#define RS_MOMENT_MISSING          -999.0f // Moments of gates without power
 
 #ifndef MAX
 #define MAX(X, Y)      ((X) > (Y) ? (X) : (Y))
@@ -52,7 +58,8 @@ enum RS_CL_PASS_2 {
 typedef char RSMethod;
 enum RSMethod {
     RS_METHOD_CPU,
-    RS_METHOD_GPU
+    RS_METHOD_GPU,
+    RS_METHOD_HYBRID
 };
 
 #endif /* rs_const_h */
@@ -12,8 +12,11 @@ enum RSDebrisRCSKernelArgument {
     RSDebrisRCSKernelArgumentPosition,
     RSDebrisRCSKernelArgumentOrientation,
     RSDebrisRCSKernelArgumentRadarCrossSection,
+    RSDebrisRCSKernelArgumentRadarCrossSectionCache,
+    RSDebrisRCSKernelArgumentRadarCrossSectionCacheOrigin,
     RSDebrisRCSKernelArgumentRadarCrossSectionReal,
     RSDebrisRCSKernelArgumentRadarCrossSectionImag,
+    RSDebrisRCSKernelArgumentRadarCrossSectionGamma,
     RSDebrisRCSKernelArgumentRadarCrossSectionDescription,
     RSDebrisRCSKernelArgumentSimulationDescription
 };
@@ -28,15 +31,30 @@ enum RSBackgroundAttributeKernelArgument {
     RSBackgroundAttributeKernelArgumentBackgroundDescription,
     RSBackgroundAttributeKernelArgumentEllipsoidRCS,
     RSBackgroundAttributeKernelArgumentEllipsoidRCSDescription,
+    RSBackgroundAttributeKernelArgumentPlacement,
+    RSBackgroundAttributeKernelArgumentPlacementGrid,
+    RSBackgroundAttributeKernelArgumentSectorWidth,
     RSBackgroundAttributeKernelArgumentSimulationDescription
 };
 
+enum RSEllipsoidRCSKernelArgument {
+    RSEllipsoidRCSKernelArgumentPosition,
+    RSEllipsoidRCSKernelArgumentRadarCrossSection,
+    RSEllipsoidRCSKernelArgumentEllipsoidRCS,
+    RSEllipsoidRCSKernelArgumentEllipsoidRCSDescription,
+    RSEllipsoidRCSKernelArgumentPlacement,
+    RSEllipsoidRCSKernelArgumentPlacementGrid,
+    RSEllipsoidRCSKernelArgumentSimulationDescription
+};
+
 enum RSDebrisAttributeKernelArgument {
     RSDebrisAttributeKernelArgumentPosition,
     RSDebrisAttributeKernelArgumentOrientation,
     RSDebrisAttributeKernelArgumentVelocity,
     RSDebrisAttributeKernelArgumentTumble,
     RSDebrisAttributeKernelArgumentRadarCrossSection,
+    RSDebrisAttributeKernelArgumentRadarCrossSectionCache,
+    RSDebrisAttributeKernelArgumentRadarCrossSectionCacheOrigin,
     RSDebrisAttributeKernelArgumentRandomSeed,
     RSDebrisAttributeKernelArgumentBackgroundVelocity,
     RSDebrisAttributeKernelArgumentBackgroundVelocityDescription,
@@ -45,10 +63,55 @@ enum RSDebrisAttributeKernelArgument {
     RSDebrisAttributeKernelArgumentAirDragModelDescription,
     RSDebrisAttributeKernelArgumentRadarCrossSectionReal,
     RSDebrisAttributeKernelArgumentRadarCrossSectionImag,
+    RSDebrisAttributeKernelArgumentRadarCrossSectionGamma,
     RSDebrisAttributeKernelArgumentRadarCrossSectionDescription,
     RSDebrisAttributeKernelArgumentSimulationDescription
 };
 
+enum RSKinematicAttributeKernelArgument {
+    RSKinematicAttributeKernelArgumentPosition,
+    RSKinematicAttributeKernelArgumentOrientation,
+    RSKinematicAttributeKernelArgumentVelocity,
+    RSKinematicAttributeKernelArgumentTumble,
+    RSKinematicAttributeKernelArgumentSimulationDescription,
+    RSKinematicAttributeKernelArgumentTumbling
+};
+
+enum RSScattererPopulationKernelArgument {
+    RSScattererPopulationKernelArgumentPosition,
+    RSScattererPopulationKernelArgumentOrientation,
+    RSScattererPopulationKernelArgumentVelocity,
+    RSScattererPopulationKernelArgumentTumble,
+    RSScattererPopulationKernelArgumentAuxiliary,
+    RSScattererPopulationKernelArgumentRadarCrossSection,
+    RSScattererPopulationKernelArgumentRandomSeed,
+    RSScattererPopulationKernelArgumentDropSizePopulation,
+    RSScattererPopulationKernelArgumentDropSizeHistogram,
+    RSScattererPopulationKernelArgumentDropSizeCDF,
+    RSScattererPopulationKernelArgumentDropSizeRadius,
+    RSScattererPopulationKernelArgumentDropSizeCount,
+    RSScattererPopulationKernelArgumentDropSizeMode,
+    RSScattererPopulationKernelArgumentPlacement,
+    RSScattererPopulationKernelArgumentPlacementGrid,
+    RSScattererPopulationKernelArgumentSectorWidth,
+    RSScattererPopulationKernelArgumentSeed,
+    RSScattererPopulationKernelArgumentIndexOffset,
+    RSScattererPopulationKernelArgumentCount,
+    RSScattererPopulationKernelArgumentSimulationDescription
+};
+
+enum RSScattererGatherKernelArgument {
+    RSScattererGatherKernelArgumentOutput,
+    RSScattererGatherKernelArgumentPosition,
+    RSScattererGatherKernelArgumentVelocity,
+    RSScattererGatherKernelArgumentOrientation,
+    RSScattererGatherKernelArgumentIndex,
+    RSScattererGatherKernelArgumentStart,
+    RSScattererGatherKernelArgumentStride,
+    RSScattererGatherKernelArgumentCount,
+    RSScattererGatherKernelArgumentOffset
+};
+
 enum RSScattererColorKernelArgument {
     RSScattererColorKernelArgumentColor,
     RSScattererColorKernelArgumentPosition,
@@ -64,6 +127,16 @@ enum RSScattererSignalDropSizeDistributionKernalArgument {
     RSScattererSignalDropSizeDistributionKernalArgumentSimulationDescription
 };
 
+enum RSBackgroundEmulatorKernelArgument {
+    RSBackgroundEmulatorKernelArgumentPulse,
+    RSBackgroundEmulatorKernelArgumentState,
+    RSBackgroundEmulatorKernelArgumentRandomSeed,
+    RSBackgroundEmulatorKernelArgumentBackgroundVelocity,
+    RSBackgroundEmulatorKernelArgumentBackgroundDescription,
+    RSBackgroundEmulatorKernelArgumentEmulatorDescription,
+    RSBackgroundEmulatorKernelArgumentSimulationDescription
+};
+
 enum RSScattererAngularWeightKernalArgument {
     RSScattererAngularWeightKernalArgumentSignal,
     RSScattererAngularWeightKernalArgumentAuxiliary,
@@ -71,6 +144,7 @@ enum RSScattererAngularWeightKernalArgument {
     RSScattererAngularWeightKernalArgumentRadarCrossSection,
     RSScattererAngularWeightKernalArgumentWeightTable,
     RSScattererAngularWeightKernalArgumentWeightTableDescription,
+    RSScattererAngularWeightKernalArgumentEllipsoidCount,
     RSScattererAngularWeightKernalArgumentSimulationDescription
 };
 
@@ -78,6 +152,7 @@ enum RSScattererAngularWeightKernalArgument {
 #pragma mark General Methods
 
 void get_device_info(cl_device_type device_type, cl_uint *num_devices, cl_device_id *devices, cl_uint *num_cus, cl_uint *vendors, cl_int detail_level);
+float get_device_throughput(cl_device_id device);
 void pfn_prog_notify(cl_program program, void *user_data);
 void pfn_notify(const char *errinfo, const void *private_info, size_t cb, void *user_data);
 cl_uint read_kernel_source_from_files(char *src_ptr[], ...);
@@ -97,6 +172,8 @@ void RS_worker_free(RSWorker *C);
 void RS_worker_malloc(RSHandle *H, const int worker_id);
 
 void RS_merge_pulse_tmp(RSHandle *H);
+int RS_alloc_host_mirrors(RSHandle *H);
+void RS_free_host_mirrors(RSHandle *H);
 void RS_update_origins_offsets(RSHandle *H);
 void RS_update_auxiliary_attributes(RSHandle *H);
 
@@ -104,9 +181,16 @@ void RS_update_auxiliary_attributes(RSHandle *H);
 void RS_set_vel_data(RSHandle *H, const RSTable3D table);
 void RS_set_adm_data(RSHandle *H, const RSTable2D table_cd, const RSTable2D table_cm);
 void RS_set_rcs_data(RSHandle *H, const RSTable2D table_real, const RSTable2D table_imag);
+void RS_set_rcs_gamma_data(RSHandle *H, const int t, const RSTable3D table);
+size_t RS_rcs_gamma_mem_size(const cl_float16 desc);
+float RS_rcs_tolerance_desc(RSHandle *H);
 
 // Functions to copy a table into master handler
 void RS_set_adm_data_to_ADM_table(RSHandle *H, const ADMTable *table);
+#if !defined (_USE_GCL_)
+void RS_share_adm_data(RSHandle *H, const int s);
+void RS_share_rcs_data(RSHandle *H, const int s);
+#endif
 void RS_set_adm_data_to_unity(RSHandle *H);
 void RS_clear_adm_data(RSHandle *H);
 void RS_set_rcs_data_to_RCS_table(RSHandle *H, const RCSTable *table);
@@ -116,7 +200,31 @@ void RS_clear_rcs_data(RSHandle *H);
 void RS_set_obj_data_to_config(RSHandle *H, OBJConfig type);
 
 void RS_set_rcs_ellipsoid_table(RSHandle *H, const cl_float4 *weights, const float table_index_start, const float table_index_delta, unsigned int table_size);
+#if !defined (_USE_GCL_)
+cl_mem RS_create_weight_table(RSWorker *C, const float *weights, const unsigned int table_size, cl_int *ret);
+int RS_worker_create_kernels(RSWorker *C);
+void RS_worker_release_kernels(RSWorker *C);
+int RS_worker_fit_weight_table(RSHandle *H, const int worker_id, const unsigned int table_size);
+#endif
 
 void RS_revise_population(RSHandle *H);
+float RS_pulse_amplitude_gain(RSHandle *H);
+cl_float16 RS_get_type_sim_desc(RSHandle *H, const int type);
+void RS_populate_on_device(RSHandle *H);
+void RS_resolve_ellipsoid_rcs(RSHandle *H);
+void RS_derive_placement(RSHandle *H);
+void RS_placement_sample(RSHandle *H, cl_float4 *pos);
+void RS_sector_sample(RSHandle *H, cl_float4 *pos);
+RSfloat RS_sector_volume(RSHandle *H);
+void RS_derive_emulator(RSHandle *H);
+void RS_emulator_step(RSHandle *H);
+void RS_summarize_dsd_population(RSHandle *H);
+size_t RS_gather(RSHandle *H, const int worker_id, const uint32_t start, const uint32_t stride, const uint32_t *index, const size_t count, cl_float4 *dst);
+uint32_t RS_get_uid_base(RSHandle *H, const int type, const int worker_id);
+int RS_locate_uid(RSHandle *H, const uint32_t uid, cl_uint4 *where);
+void RS_record_trajectory(RSHandle *H);
+void RS_drain_trajectory(RSHandle *H);
+void RS_wait_trajectory_writer(RSTrajectory *T);
+void *RS_trajectory_writer(void *in);
 
 #endif
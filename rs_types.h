@@ -51,6 +51,15 @@ typedef struct _rs_volume {
 	RSPoint size;
 } RSVolume;
 
+typedef struct _rs_moment {
+	RSfloat  z;                    // Range corrected power (dB), no absolute calibration
+	RSfloat  v;                    // Radial velocity (m/s), positive away from the radar
+	RSfloat  w;                    // Spectrum width (m/s)
+	RSfloat  zdr;                  // Differential reflectivity (dB)
+	RSfloat  rhohv;                // Co-polar correlation coefficient
+	RSfloat  phidp;                // Differential phase (deg)
+} RSMoment;
+
 typedef struct _rs_params {
 	RSfloat  c;                    // Speed of light (m/s)
 	RSfloat  prt;                  // Pulse repetition time (second)
@@ -17,6 +17,7 @@
 
 #include "rs.h"
 #include "iq.h"
+#include "sp.h"
 #include <stdbool.h>
 #include <getopt.h>
 #include <dirent.h>
@@ -30,7 +31,8 @@
 
 enum ACCEL_TYPE {
     ACCEL_TYPE_GPU,
-    ACCEL_TYPE_CPU
+    ACCEL_TYPE_CPU,
+    ACCEL_TYPE_HYBRID
 };
 
 typedef struct user_params {
@@ -63,10 +65,32 @@ typedef struct user_params {
     bool  tight_box;
     bool  show_progress;
     bool  resume_seed;
+    bool  split_population;
+    bool  compress_iq_file;
+    bool  output_moment_file;
+    int   moment_dwell;
+    bool  output_spectrum_file;
+    int   fft_count;
+    int   fft_segments;
+    int   physics_step;
+    int   debris_physics_step;
+    int   integrator;
+    bool  adaptive_warm_up;
+    int   rcs_gamma_count;
+    float rcs_tolerance;
+    float sector_width;
 
     char output_dir[1024];
 } UserParams;
 
+// An entry of the index file that lists the output files of all ranks
+typedef struct iq_file_entry {
+    uint32_t  seed;
+    uint32_t  num_pulses;
+    int64_t   size;
+    char      processor_name[48];
+} IQFileEntry;
+
 typedef union simstate {
     char raw[63 * 1024];
     RSHandle master;
@@ -97,7 +121,11 @@ void show_help() {
            "         multiple values that can be combined together.\n"
            "            B - Bounded particle velocity.\n"
            "            D - Dragged background.\n"
+           "            E - Emulated background, the rain of every gate is synthesized from the\n"
+           "                wind, the DSD and the beam so that the GPU time goes to the debris.\n"
            "            F - Fixed scatterer position.\n"
+           "            I - Importance-sampled placement of the drops, concentrated where\n"
+           "                the scan pattern looks, each with a compensating weight.\n"
            "            T - Transparent background.\n"
            "            U - Uniform rain drop size density with scaled RCS.\n"
            "            V - Vertically pointed radar (profiler)\n"
@@ -109,12 +137,18 @@ void show_help() {
            "                sets simulation to use the concept of bounded particle velocity\n"
            "                but left the others as default.\n"
            "\n"
+           "  --compress\n"
+           "         Compresses the output IQ file in chunks of %d pulses using byte shuffle\n"
+           "         and a lossless LZ77 codec. The compression runs in a background thread\n"
+           "         while the pulses are written. Use the IQ reader in the library, e.g.,\n"
+           "         IQ_read_pulse(), to decode.\n"
+           "\n"
            "  -d (--debris) " UNDERLINE("type") "," UNDERLINE("count") "\n"
            "         Adds debris of " UNDERLINE("type") " with population of " UNDERLINE("count") ".\n"
            "         When is option is specified multiple times, multiple debris types will\n"
            "         be used in the simulator.\n"
-           "         Debris type is as follows:\n"
-           );
+           "         Debris type is as follows:\n",
+           IQ_DEFAULT_CHUNK_PULSES);
     for (int i = 1; i < OBJConfigCount; i++) {
         k += sprintf(buff + k, "            o  %d - %s\n", i, OBJConfigString(i));
     }
@@ -129,6 +163,15 @@ void show_help() {
            "         Sets the number of frames to " UNDERLINE("count") ". This option is identical -p.\n"
            "         See -p for more information.\n"
            "\n"
+           "  --hybrid\n"
+           "         Uses the host CPU as an additional worker alongside the GPUs. The\n"
+           "         scatterers are split in proportion to the throughput of each device.\n"
+           "\n"
+           "  --integrator " UNDERLINE("method") "\n"
+           "         Sets the integrator of the debris and drop velocities to " UNDERLINE("method") ", which\n"
+           "         can be euler (default), rk2 or rk4. The higher order integrators allow\n"
+           "         larger time steps, e.g., with --adaptive-warmup.\n"
+           "\n"
            "  -l (--lambda) " UNDERLINE("wavelength") "\n"
            "         Sets the radar wavelength to " UNDERLINE("wavelength") " meters. Framework default value\n"
            "         is 0.10 m if this is not specified.\n"
@@ -138,6 +181,27 @@ void show_help() {
            "         the folder under ${SIMRADAR_TABLE_HOME}/tables/les/${LESTable}. If not\n"
            "         specified, the default LES field is 'suctvort'.\n"
            "\n"
+           "  -m (--moments) " UNDERLINE("N") "\n"
+           "         Produces a moment file of Z, V, W, ZDR, rhoHV and PhiDP from pulse pair\n"
+           "         processing of every " UNDERLINE("N") " pulses, which are accumulated on the device as\n"
+           "         the pulses are made. Use 0 to derive " UNDERLINE("N") " from the beamwidth and the scan\n"
+           "         pattern. Gates without power are -999. The output file is like\n"
+           "         sim-20160229-143941-E03.0.mom\n"
+           "\n"
+           "  --split\n"
+           "         Only for simradar-mpi. All ranks share one simulation domain, each with\n"
+           "         a portion of the scatterers, and the pulses are summed across ranks.\n"
+           "         Only rank 0 generates the output file. Without this option, every rank\n"
+           "         runs an independent simulation with seed + rank.\n"
+           "\n"
+           "  --physics-step " UNDERLINE("M") "[," UNDERLINE("D") "]\n"
+           "         Runs the full physics (wind, drag and air drag model) every " UNDERLINE("M") " pulses.\n"
+           "         The pulses in between only move the scatterers with the velocity and\n"
+           "         tumble of the last update, which is much cheaper. A new wind table\n"
+           "         always triggers a full update. Default is 1, i.e., every pulse.\n"
+           "         With " UNDERLINE("D") ", " UNDERLINE("M") " only applies to the background drops and the debris\n"
+           "         runs every " UNDERLINE("D") " pulses, e.g., 8,1 for fast tumbling debris in rain.\n"
+           "\n"
            "  -N (--no-run)\n"
            "         No simulation. Previews the scanning angles of the setup. No data will\n"
            "         be generated.\n"
@@ -145,6 +209,9 @@ void show_help() {
            "  -o     Sets the program to produce an output file. The filename is derived\n"
            "         based on the current date and time and an output file with name like\n"
            "         sim-20160229-143941-E03.0.iq will be placed in the ~/Downloads folder.\n"
+           "         In simradar-mpi, every rank writes its own file with a rank suffix, e.g.,\n"
+           "         sim-20160229-143941-E03.0-r0001.iq, and the master node writes an index\n"
+           "         file sim-20160229-143941-E03.0.index that lists all of them.\n"
            "\n"
            "  -O (--out-dir) " UNDERLINE("destination") "\n"
            "         Sets the output directory to " UNDERLINE("destination") ". There is no\n"
@@ -157,6 +224,25 @@ void show_help() {
            "         sweep mode = P, start = -12, end = +12, delta = 0.01, and combine with\n"
            "         option -p 2400 for a simulation session of 2400 pulses.\n"
            "\n"
+           "  --spectra " UNDERLINE("M") "[," UNDERLINE("S") "]\n"
+           "         Produces a spectrum file of H, V and cross Doppler spectra from " UNDERLINE("M") "-point\n"
+           "         Hann windowed FFTs, averaged over " UNDERLINE("S") " segments (default 1) for every\n"
+           "         radial of " UNDERLINE("M") " x " UNDERLINE("S") " pulses. The FFTs run on the host threads while the\n"
+           "         next pulses are made. The output file is like sim-20160229-143941-E03.0.spec\n"
+           "\n"
+           "  --rcs-gamma " UNDERLINE("N") "\n"
+           "         Bakes the gamma projection of each debris RCS table into a 3-D table of\n"
+           "         " UNDERLINE("N") " gamma angles from -180 to 180 deg so that the debris RCS is a single\n"
+           "         filtered lookup. Alpha and beta are interpolated as in the 2-D RCS tables.\n"
+           "         Costs " UNDERLINE("N") " times the memory of the RCS table on each device.\n"
+           "         Default is 0, i.e., the projection is computed per particle.\n"
+           "\n"
+           "  --rcs-tolerance " UNDERLINE("angle") "\n"
+           "         Evaluates the RCS of a debris particle again only after its orientation\n"
+           "         relative to the line of sight has rotated by more than " UNDERLINE("angle") " degrees\n"
+           "         since the last evaluation. Useful for slowly tumbling debris and slow\n"
+           "         scans. Default is 0, i.e., the RCS is evaluated at every update.\n"
+           "\n"
            "  --resume-seed\n"
            "         Runs the simulator by resuming the latest seed generated, plus one, by\n"
            "         inspecting the output files with extension .iq in the specified output\n"
@@ -167,6 +253,12 @@ void show_help() {
            "         simulation. An output file like sim-20160229-143941-E03.0.simstate will\n"
            "         be generated in the ~/Downloads folder.\n"
            "\n"
+           "  --sector " UNDERLINE("width") "\n"
+           "         Populates only a sector of " UNDERLINE("width") " degrees that follows the beam azimuth.\n"
+           "         Scatterers that fall behind the sector are recycled at its leading edge so\n"
+           "         that a long PPI sweep needs a fraction of the scatterers for the same\n"
+           "         density. Default is 0, i.e., the whole domain is populated.\n"
+           "\n"
            "  --sweep " UNDERLINE("M:...") "\n"
            "         Sets the beam to scan mode.\n"
            "         The argument " UNDERLINE("M:...") " are parameters for mode, followed\n"
@@ -202,6 +294,11 @@ void show_help() {
            "\n"
            "  -W (--warmup) " UNDERLINE("count") "\n"
            "         Sets the warm up stage to use " UNDERLINE("count") " pulses.\n"
+           "\n"
+           "  --adaptive-warmup\n"
+           "         Covers the same simulated time of the warm up stage, i.e., " UNDERLINE("count") " / 60\n"
+           "         seconds, with adaptive time steps limited by the drag relaxation time,\n"
+           "         the wind table cell size and the wind table period.\n"
            "\n\n"
            "EXAMPLES\n"
            "     The following simulates a vortex and creates a PPI scan data using default\n"
@@ -324,31 +421,69 @@ static void show_user_param(const char *name, const void* value, const char *uni
     }
 }
 
-static void write_iq_file(const UserParams user, const IQFileHeader *file_header, const IQPulseHeader *pulse_headers, const cl_float4 *pulse_cache, const int stride, const int offset) {
-    char charbuff[2048];
-
-    memset(charbuff, 0, sizeof(charbuff));
-    // snprintf(charbuff, sizeof(charbuff), "%s/sim-%s-%s%04.1f.iq",
-    //          user.output_dir,
-    //          nowlongoffset(offset),
-    //          POS_is_ppi(&user.scan_pattern) ? "E": (POS_is_rhi(&user.scan_pattern) ? "A" : "S"),
-    //          POS_is_ppi(&user.scan_pattern) ? user.scan_pattern.sweeps[0].elStart : (POS_is_rhi(&user.scan_pattern) ? user.scan_pattern.sweeps[0].azStart : (float)user.num_pulses));
-    snprintf(charbuff, sizeof(charbuff), "%s.iq", filename_prefix(&user));
-    printf("%s : Output file : " UNDERLINE("%s") "\n", now(), charbuff);
-    FILE *fid = fopen(charbuff, "wb");
-    if (fid == NULL) {
+static long write_iq_file(const UserParams user, const char *filename, const IQFileHeader *file_header, const IQPulseHeader *pulse_headers, const cl_float4 *pulse_cache, const int stride) {
+    printf("%s : Output file : " UNDERLINE("%s") "\n", now(), filename);
+    IQHandle I = IQ_create(filename, file_header, 0);
+    if (I == NULL) {
         fprintf(stderr, "%s : Error creating file for IQ data.\n", now());
+        return 0;
     }
-    fwrite(file_header, sizeof(IQFileHeader), 1, fid);
 
-    // Flush out the cache
+    // Flush out the cache, the pulse index is appended when the file is closed
     for (int k = 0; k < user.num_pulses; k++) {
-        fwrite(&pulse_headers[k], sizeof(IQPulseHeader), 1, fid);
-        fwrite(&pulse_cache[k * stride], sizeof(cl_float4), stride, fid);
+        IQ_write_pulse(I, &pulse_headers[k], (float *)&pulse_cache[k * stride]);
     }
-    printf("%s : Data file with %s B (seed = %s).\n", now(), commaint(ftell(fid)), commaint(file_header->simulation_seed));
+    IQ_close(I);
+    struct stat file_stat;
+    long size = stat(filename, &file_stat) == 0 ? (long)file_stat.st_size : 0;
+    printf("%s : Data file with %s B (seed = %s).\n", now(), commaint(size), commaint(file_header->simulation_seed));
     printf("%s : Samples = %.4e%+.4ei  %.4e%+.4ei ...\n", now(), pulse_cache[0].s0, pulse_cache[0].s1, pulse_cache[1].s0, pulse_cache[1].s1);
+    return size;
+}
+
+// Same header as the IQ file, followed by a pulse header and radial_size bytes of moments or spectra for every radial
+static long write_radial_file(const char *filename, const char *magic, const IQFileHeader *file_header, const IQPulseHeader *radial_headers, const void *data, const size_t radial_size, const int radial_count) {
+    printf("%s : Output file : " UNDERLINE("%s") "\n", now(), filename);
+    FILE *fid = fopen(filename, "wb");
+    if (fid == NULL) {
+        fprintf(stderr, "%s : Error creating file for radial data.\n", now());
+        return 0;
+    }
+    IQFileHeader header = *file_header;
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.pulse_count = radial_count;
+    header.compression = IQCompressionNone;
+    fwrite(&header, sizeof(IQFileHeader), 1, fid);
+    for (int k = 0; k < radial_count; k++) {
+        fwrite(&radial_headers[k], sizeof(IQPulseHeader), 1, fid);
+        fwrite((char *)data + k * radial_size, radial_size, 1, fid);
+    }
+    long size = ftell(fid);
     fclose(fid);
+    printf("%s : Radial file with %s radials (%s B).\n", now(), commaint(radial_count), commaint(size));
+    return size;
+}
+
+// Keep the pulse header at the middle of the dwell and the moments at the end of it
+static void collect_moments(RSHandle *S, const int count, const IQPulseHeader *pulse_header, IQPulseHeader *radial_headers, RSMoment *moments, int *radial_count) {
+    if (count == (S->moment_dwell + 1) / 2) {
+        radial_headers[*radial_count] = *pulse_header;
+    }
+    if (count == S->moment_dwell) {
+        RS_download_moments(S, &moments[*radial_count * S->params.range_count]);
+        (*radial_count)++;
+    }
+}
+
+static void collect_spectra(SPHandle P, const int count, const IQPulseHeader *pulse_header, IQPulseHeader *radial_headers, SPBin *spectra, int *radial_count, const int range_count) {
+    const int dwell = (int)SP_get_dwell(P);
+    if (count == (dwell + 1) / 2) {
+        radial_headers[*radial_count] = *pulse_header;
+    }
+    if (count == dwell) {
+        SP_get_spectra(P, &spectra[*radial_count * range_count * SP_get_fft_count(P)]);
+        (*radial_count)++;
+    }
 }
 
 int cstring_cmp(const void *a, const void *b)
@@ -464,6 +599,20 @@ int main(int argc, char *argv[]) {
     user.show_progress     = true;
     user.tight_box         = false;
     user.resume_seed       = false;
+    user.split_population  = false;
+    user.compress_iq_file  = false;
+    user.output_moment_file = false;
+    user.moment_dwell      = 0;
+    user.output_spectrum_file = false;
+    user.fft_count         = 64;
+    user.fft_segments      = 1;
+    user.physics_step      = 1;
+    user.debris_physics_step = 0;
+    user.integrator        = RSIntegratorEuler;
+    user.adaptive_warm_up  = false;
+    user.rcs_gamma_count   = 0;
+    user.rcs_tolerance     = 0.0f;
+    user.sector_width      = 0.0f;
 
     user.output_dir[0]     = '\0';
 
@@ -485,18 +634,29 @@ int main(int argc, char *argv[]) {
         {"no-progress"   , no_argument      , 0, 'F'},
         {"mpdsd"         , required_argument, 0, 'G'},
         {"resume-seed"   , no_argument      , 0, 'H'},
+        {"integrator"    , required_argument, 0, 'I'},
+        {"physics-step"  , required_argument, 0, 'K'},
         {"les"           , required_argument, 0, 'L'},
+        {"split"         , no_argument      , 0, 'M'},
         {"no-run"        , no_argument      , 0, 'N'},
         {"out-dir"       , required_argument, 0, 'O'},
+        {"adaptive-warmup", no_argument     , 0, 'R'},
+        {"rcs-gamma"     , required_argument, 0, 'U'},
+        {"rcs-tolerance" , required_argument, 0, 'J'},
+        {"sector"        , required_argument, 0, 'X'},
+        {"spectra"       , required_argument, 0, 'P'},
         {"sweep"         , required_argument, 0, 'S'},
         {"tightbox"      , no_argument      , 0, 'T'},
         {"warmup"        , required_argument, 0, 'W'},
+        {"hybrid"        , no_argument      , 0, 'Y'},
+        {"compress"      , no_argument      , 0, 'Z'},
         {"concept"       , required_argument, 0, 'c'}, // ASCII 97 - 122 : a - z
         {"debris"        , required_argument, 0, 'd'},
         {"help"          , no_argument      , 0, 'h'},
         {"gpu"           , no_argument      , 0, 'g'},
         {"frames"        , required_argument, 0, 'f'},
         {"lambda"        , required_argument, 0, 'l'},
+        {"moments"       , required_argument, 0, 'm'},
         {"output"        , no_argument      , 0, 'o'},
         {"pulses"        , required_argument, 0, 'p'},
         {"seed"          , required_argument, 0, 's'},
@@ -533,6 +693,9 @@ int main(int argc, char *argv[]) {
                 if (strcasestr(optarg, "D")) {
                     user.concept |= RSSimulationConceptDraggedBackground;
                 }
+                if (strcasestr(optarg, "E")) {
+                    user.concept |= RSSimulationConceptEmulatedBackground;
+                }
                 if (strcasestr(optarg, "U")) {
                     user.concept |= RSSimulationConceptUniformDSDScaledRCS;
                 }
@@ -542,6 +705,9 @@ int main(int argc, char *argv[]) {
                 if (strcasestr(optarg, "F")) {
                     user.concept |= RSSimulationConceptFixedScattererPosition;
                 }
+                if (strcasestr(optarg, "I")) {
+                    user.concept |= RSSimulationConceptImportanceSampledPlacement;
+                }
                 if (strcasestr(optarg, "V")) {
                     user.concept |= RSSimulationConceptVerticallyPointingRadar;
                 }
@@ -604,24 +770,72 @@ int main(int argc, char *argv[]) {
             case 'H':
                 user.resume_seed = true;
                 break;
+            case 'I':
+                if (!strcasecmp(optarg, "rk4")) {
+                    user.integrator = RSIntegratorRungeKutta4;
+                } else if (!strcasecmp(optarg, "rk2")) {
+                    user.integrator = RSIntegratorRungeKutta2;
+                } else if (!strcasecmp(optarg, "euler")) {
+                    user.integrator = RSIntegratorEuler;
+                } else {
+                    fprintf(stderr, "Integrator should be euler, rk2 or rk4.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'R':
+                user.adaptive_warm_up = true;
+                break;
+            case 'U':
+                user.rcs_gamma_count = atoi(optarg);
+                break;
+            case 'J':
+                user.rcs_tolerance = atof(optarg);
+                break;
+            case 'X':
+                user.sector_width = atof(optarg);
+                break;
+            case 'K':
+                k = sscanf(optarg, "%d,%d", &user.physics_step, &user.debris_physics_step);
+                if (k < 2) {
+                    user.debris_physics_step = 0;
+                }
+                break;
             case 'l':
                 user.lambda = atof(optarg);
                 break;
             case 'L':
                 strncpy(user.les_config, optarg, sizeof(user.les_config));
                 break;
+            case 'm':
+                user.output_moment_file = true;
+                user.moment_dwell = atoi(optarg);
+                break;
+            case 'M':
+                user.split_population = true;
+                break;
             case 'N':
                 user.preview_only = true;
                 break;
             case 'o':
                 user.output_iq_file = true;
                 break;
+            case 'Z':
+                user.compress_iq_file = true;
+                break;
             case 'O':
                 strncpy(user.output_dir, optarg, sizeof(user.output_dir));
                 break;
             case 'p':
                 user.num_pulses = atoi(optarg);
                 break;
+            case 'P':
+                user.output_spectrum_file = true;
+                k = sscanf(optarg, "%d,%d", &user.fft_count, &user.fft_segments);
+                if (k < 1 || user.fft_count < 2 || (user.fft_count & (user.fft_count - 1)) || user.fft_segments < 1) {
+                    fprintf(stderr, "Spectra should be specified as --spectra M or --spectra M,S with M a power of two.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
             case 'q':
                 user.quiet_mode = true;
                 break;
@@ -649,6 +863,9 @@ int main(int argc, char *argv[]) {
             case 'y':
                 user.skip_questions = true;
                 break;
+            case 'Y':
+                accel_type = ACCEL_TYPE_HYBRID;
+                break;
             default:
                 exit(EXIT_FAILURE);
                 break;
@@ -682,12 +899,18 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (user.seed != PARAMS_INT_NOT_SUPPLIED) {
+    // Partitions of a split population derive their own random sequences from a common seed
+    if (user.seed != PARAMS_INT_NOT_SUPPLIED && !user.split_population) {
         user.seed += world_rank;
     }
 
 #else
 
+    if (user.split_population) {
+        fprintf(stderr, "Option --split is only available in simradar-mpi.\n");
+        user.split_population = false;
+    }
+
     if (user.resume_seed) {
         user.seed = get_last_seed(user.output_dir) + 1;
     }
@@ -783,6 +1006,8 @@ int main(int argc, char *argv[]) {
     RSHandle *S;
     if (accel_type == ACCEL_TYPE_CPU) {
         S = RS_init_for_cpu_verbose(verb);
+    } else if (accel_type == ACCEL_TYPE_HYBRID) {
+        S = RS_init_for_hybrid_verbose(verb);
     } else {
         S = RS_init_verbose(verb);
     }
@@ -801,8 +1026,20 @@ int main(int argc, char *argv[]) {
 #endif
 
     RS_set_concept(S, user.concept);
+    RS_set_integrator(S, user.integrator);
+    RS_set_debris_rcs_gamma_resolution(S, user.rcs_gamma_count);
+    RS_set_debris_rcs_tolerance(S, user.rcs_tolerance);
     RS_set_scan_pattern(S, &user.scan_pattern);
 
+#if defined (_OPEN_MPI)
+
+    // Every rank simulates a portion of the population, must be set before adding debris
+    if (user.split_population) {
+        RS_set_population_partition(S, world_rank, world_size);
+    }
+
+#endif
+
     // ---------------------------------------------------------------------------------------------------------------
 
     // Pre-process some parameters to ensure proper logic
@@ -816,6 +1053,15 @@ int main(int argc, char *argv[]) {
         }
     }
 
+#if defined (_OPEN_MPI)
+
+    // Ranks of a split population must agree on whether pulses are collected
+    if (user.split_population) {
+        MPI_Bcast(&user.output_iq_file, sizeof(user.output_iq_file), MPI_BYTE, 0, MPI_COMM_WORLD);
+    }
+
+#endif
+
     if (user.warm_up_pulses == PARAMS_INT_NOT_SUPPLIED) {
         if (user.num_pulses > 1000)  {
             user.warm_up_pulses = 2000;
@@ -836,6 +1082,10 @@ int main(int argc, char *argv[]) {
         RS_set_density(S, user.density);
     }
 
+    if (user.sector_width > 0.0f) {
+        RS_set_sector_width(S, user.sector_width);
+    }
+
     if (user.pw != PARAMS_FLOAT_NOT_SUPPLIED) {
         RS_set_tx_params(S, user.pw, 50.0e3f);
     }
@@ -875,6 +1125,24 @@ int main(int argc, char *argv[]) {
 
     RSBox box = RS_suggest_scan_domain(S);
 
+    if (!POS_is_dbs(&user.scan_pattern)) {
+        // Revise the counts so that we use GPU preferred numbers, before they are partitioned across ranks
+        for (k = 0; k < user.debris_group_count; k++) {
+            if (user.debris_count[k]) {
+                user.debris_count[k] = (user.debris_count[k] + S->preferred_multiple - 1) / S->preferred_multiple * S->preferred_multiple;
+            }
+        }
+    }
+
+#if defined (_OPEN_MPI)
+
+    // Ranks of a split population must partition the same global counts
+    if (user.split_population) {
+        MPI_Bcast(user.debris_count, RS_MAX_DEBRIS_TYPES, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+#endif
+
     // Set debris population
     for (k = 0; k < user.debris_group_count; k++) {
         if (user.debris_count[k]) {
@@ -882,11 +1150,6 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (!POS_is_dbs(&user.scan_pattern)) {
-        // Revise the counts so that we use GPU preferred numbers
-        RS_revise_debris_counts_to_gpu_preference(S);
-    }
-
     if (user.tight_box) {
         if (POS_is_ppi(&user.scan_pattern)) {
             // No need to go all the way up if we are looking low
@@ -922,6 +1185,18 @@ int main(int argc, char *argv[]) {
     // upload all the parameters to the GPU.
     RS_populate(S);
 
+    if (user.output_moment_file) {
+        RS_set_moment_dwell(S, user.moment_dwell);
+    }
+
+    SPHandle P = NULL;
+    if (user.output_spectrum_file) {
+        P = SP_init(S->params.range_count, user.fft_count, user.fft_segments, 0);
+        if (P == NULL) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // Show some basic info
 
 #if defined (_OPEN_MPI)
@@ -945,17 +1220,38 @@ int main(int argc, char *argv[]) {
         strcpy(charbuff, commaint(user.warm_up_pulses));
         RS_set_prt(S, 1.0f / 60.0f);
         gettimeofday(&t1, NULL);
-        for (k = 0; k < user.warm_up_pulses; k++) {
-            // Skip computing progress if we are not showing progress
-            if (user.show_progress) {
-                gettimeofday(&t2, NULL);
-                dt = DTIME(t1, t2);
-                if (dt >= 0.25f) {
-                    t1 = t2;
-                    printf("Warming up ... %s out of %s ... \033[32m%.2f%%\033[0m  \r", commaint(k), charbuff, (float)k / user.warm_up_pulses * 100.0f);
+        if (user.adaptive_warm_up) {
+            const float warm_up_time = (float)user.warm_up_pulses / 60.0f;
+            float t = 0.0f;
+            k = 0;
+            while (t < warm_up_time) {
+                if (user.show_progress) {
+                    gettimeofday(&t2, NULL);
+                    dt = DTIME(t1, t2);
+                    if (dt >= 0.25f) {
+                        t1 = t2;
+                        printf("Warming up ... %.2f s out of %.2f s (dt = %.1f ms) ... \033[32m%.2f%%\033[0m  \r", t, warm_up_time, 1.0e3f * S->params.prt, t / warm_up_time * 100.0f);
+                    }
                 }
+                t += RS_advance_time_adaptive(S, warm_up_time - t);
+                k++;
+            }
+            if (verb) {
+                printf("%s : Warm up of %.2f s in %s steps.\n", now(), warm_up_time, commaint(k));
+            }
+        } else {
+            for (k = 0; k < user.warm_up_pulses; k++) {
+                // Skip computing progress if we are not showing progress
+                if (user.show_progress) {
+                    gettimeofday(&t2, NULL);
+                    dt = DTIME(t1, t2);
+                    if (dt >= 0.25f) {
+                        t1 = t2;
+                        printf("Warming up ... %s out of %s ... \033[32m%.2f%%\033[0m  \r", commaint(k), charbuff, (float)k / user.warm_up_pulses * 100.0f);
+                    }
+                }
+                RS_advance_time(S);
             }
-            RS_advance_time(S);
         }
         if (user.show_progress) {
             printf("%80s\r", " ");
@@ -965,6 +1261,14 @@ int main(int argc, char *argv[]) {
     // Set PRT to the actual one
     RS_set_prt(S, user.prt);
 
+    // Full physics every few pulses, warm up always uses the full physics
+    RS_set_physics_step(S, user.physics_step);
+    if (user.debris_physics_step > 0) {
+        for (k = 1; k < RS_MAX_DEBRIS_TYPES; k++) {
+            RS_set_physics_step_of_type(S, k, user.debris_physics_step);
+        }
+    }
+
     // ---------------------------------------------------------------------------------------------------------------
 
     gettimeofday(&t1, NULL);
@@ -975,6 +1279,40 @@ int main(int argc, char *argv[]) {
     memset(pulse_headers, 0, user.num_pulses * sizeof(IQPulseHeader));
     memset(pulse_cache, 0, user.num_pulses * S->params.range_count * sizeof(cl_float4));
 
+    // Moment radials, only complete dwells are kept
+    int radial_count = 0;
+    IQPulseHeader *radial_headers = NULL;
+    RSMoment *moments = NULL;
+    if (user.output_moment_file) {
+        k = MAX(1, user.num_pulses / S->moment_dwell);
+        radial_headers = (IQPulseHeader *)malloc(k * sizeof(IQPulseHeader));
+        moments = (RSMoment *)malloc(k * S->params.range_count * sizeof(RSMoment));
+        memset(radial_headers, 0, k * sizeof(IQPulseHeader));
+        memset(moments, 0, k * S->params.range_count * sizeof(RSMoment));
+    }
+    int spectrum_count = 0;
+    IQPulseHeader *spectrum_headers = NULL;
+    SPBin *spectra = NULL;
+    if (user.output_spectrum_file) {
+        k = MAX(1, user.num_pulses / (user.fft_count * user.fft_segments));
+        spectrum_headers = (IQPulseHeader *)malloc(k * sizeof(IQPulseHeader));
+        spectra = (SPBin *)malloc(k * S->params.range_count * user.fft_count * sizeof(SPBin));
+        if (spectrum_headers == NULL || spectra == NULL) {
+            fprintf(stderr, "%s : Unable to allocate the spectra.\n", now());
+            exit(EXIT_FAILURE);
+        }
+        memset(spectrum_headers, 0, k * sizeof(IQPulseHeader));
+    }
+
+    // Pulses needed on the host, a split population is also reduced before the moments and spectra
+    const bool download_pulse = user.output_iq_file || user.output_spectrum_file || (user.output_moment_file && user.split_population);
+
+#if defined (_OPEN_MPI)
+
+    MPI_Request reduce_request = MPI_REQUEST_NULL;
+
+#endif
+
     // Now we bake
     int k0 = 0;
     for (k = 0; k < user.num_pulses; k++) {
@@ -999,6 +1337,13 @@ int main(int argc, char *argv[]) {
         RS_set_beam_pos(S, user.scan_pattern.az, user.scan_pattern.el);
         RS_make_pulse(S);
 
+#if defined (_OPEN_MPI)
+
+        // S->pulse is the send buffer of the previous reduction, which must complete before it is overwritten
+        MPI_Wait(&reduce_request, MPI_STATUS_IGNORE);
+
+#endif
+
         // Only download the necessary data
         if (verb > 2) {
             RS_download(S);
@@ -1025,16 +1370,38 @@ int main(int argc, char *argv[]) {
                 }
                 printf("\n");
             }
-        } else if (user.output_iq_file) {
+        } else if (download_pulse) {
             RS_download_pulse_only(S);
         }
 
         // Gather information for the  pulse header
-        if (user.output_iq_file) {
+        if (user.output_iq_file || user.output_moment_file || user.output_spectrum_file) {
             pulse_headers[k].time = S->sim_tic;
             pulse_headers[k].az_deg = user.scan_pattern.az;
             pulse_headers[k].el_deg = user.scan_pattern.el;
-            memcpy(&pulse_cache[k * S->params.range_count], S->pulse, S->params.range_count * sizeof(cl_float4));
+            if (user.split_population) {
+
+#if defined (_OPEN_MPI)
+
+                // Sum the partial pulses of all ranks into the cache of rank 0 while the next time step is computed
+                MPI_Ireduce(S->pulse, &pulse_cache[k * S->params.range_count], 4 * S->params.range_count, MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD, &reduce_request);
+
+#endif
+
+            } else if (user.output_iq_file) {
+                memcpy(&pulse_cache[k * S->params.range_count], S->pulse, S->params.range_count * sizeof(cl_float4));
+            }
+        }
+
+        // Moments of a split population are computed from the reduced pulses after the loop
+        if (user.output_moment_file && !user.split_population) {
+            // Pulses already downloaded are accumulated on the host
+            int count = verb > 2 || download_pulse ? RS_accumulate_moments_from_pulse(S, S->pulse) : RS_accumulate_moments(S);
+            collect_moments(S, count, &pulse_headers[k], radial_headers, moments, &radial_count);
+        }
+        if (user.output_spectrum_file && !user.split_population) {
+            int count = SP_add_pulse(P, (float *)S->pulse);
+            collect_spectra(P, count, &pulse_headers[k], spectrum_headers, spectra, &spectrum_count, S->params.range_count);
         }
 
         // Advance time
@@ -1044,6 +1411,25 @@ int main(int argc, char *argv[]) {
         POS_get_next_angles(&user.scan_pattern);
     }
 
+#if defined (_OPEN_MPI)
+
+    MPI_Wait(&reduce_request, MPI_STATUS_IGNORE);
+
+    if (user.output_moment_file && user.split_population && world_rank == 0) {
+        for (k = 0; k < user.num_pulses; k++) {
+            int count = RS_accumulate_moments_from_pulse(S, &pulse_cache[k * S->params.range_count]);
+            collect_moments(S, count, &pulse_headers[k], radial_headers, moments, &radial_count);
+        }
+    }
+    if (user.output_spectrum_file && user.split_population && world_rank == 0) {
+        for (k = 0; k < user.num_pulses; k++) {
+            int count = SP_add_pulse(P, (float *)&pulse_cache[k * S->params.range_count]);
+            collect_spectra(P, count, &pulse_headers[k], spectrum_headers, spectra, &spectrum_count, S->params.range_count);
+        }
+    }
+
+#endif
+
     // Overall fps
     gettimeofday(&t2, NULL);
     dt = DTIME(t0, t2);
@@ -1080,7 +1466,7 @@ int main(int argc, char *argv[]) {
     // ---------------------------------------------------------------------------------------------------------------
 
     // Initialize a file if the user wants output files
-    if (user.output_iq_file || user.output_state_file) {
+    if (user.output_iq_file || user.output_state_file || user.output_moment_file || user.output_spectrum_file) {
         file_header.params = S->params;
         for (k = 0; k < S->num_types; k++) {
             file_header.counts[k] = (uint32_t)S->counts[k];
@@ -1090,6 +1476,28 @@ int main(int argc, char *argv[]) {
         file_header.scan_end        = user.scan_pattern.sweeps[0].azEnd;
         file_header.scan_delta      = user.scan_pattern.sweeps[0].azDelta;
         file_header.simulation_seed = S->random_seed;
+        file_header.range_count     = S->params.range_count;
+        file_header.compression     = user.compress_iq_file ? IQCompressionShuffleLZ : IQCompressionNone;
+        file_header.moment_dwell    = user.output_moment_file ? S->moment_dwell : 0;
+        file_header.fft_count       = user.output_spectrum_file ? user.fft_count : 0;
+        file_header.fft_segments    = user.output_spectrum_file ? user.fft_segments : 0;
+        // Same order as RS_add_debris(), counts[0] is the meteorological scatterers
+        int j = 0;
+        for (k = 0; k < user.debris_group_count; k++) {
+            if (user.debris_count[k] && j + 1 < RS_MAX_DEBRIS_TYPES) {
+                file_header.debris_types[++j] = (uint32_t)user.debris_type[k];
+            }
+        }
+
+#if defined (_OPEN_MPI)
+
+        // Population of the whole domain
+        if (user.split_population) {
+            MPI_Reduce(world_rank == 0 ? MPI_IN_PLACE : file_header.counts, file_header.counts, RS_MAX_DEBRIS_TYPES, MPI_UINT32_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        }
+
+#endif
+
     }
 
     if (strlen(user.output_dir) == 0) {
@@ -1109,49 +1517,130 @@ int main(int argc, char *argv[]) {
         }
     }
     
+    char prefix[768];
+
+#if defined (_OPEN_MPI)
+
+    // Common prefix from the master node so that all files of this run are named consistently
+    if (world_rank == 0) {
+        strncpy(prefix, filename_prefix(&user), sizeof(prefix));
+    }
+    MPI_Bcast(prefix, sizeof(prefix), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+#else
+
+    strncpy(prefix, filename_prefix(&user), sizeof(prefix));
+
+#endif
+
     if (user.output_iq_file) {
 
 #if defined (_OPEN_MPI)
 
-        // Let master node do all the file writing to avoid identical filenames
-        if (world_rank == 0) {
-            int count;
-            write_iq_file(user, &file_header, pulse_headers, pulse_cache, S->params.range_count, 0);
-            // Collect data from worker nodes
-            for (k = 1; k < world_size; k++) {
-                MPI_Recv(&file_header, sizeof(IQFileHeader), MPI_BYTE, k, 0, MPI_COMM_WORLD, &status);
-                if (verb > 1) {
-                    printf("%s : Received file header from node %d  (seed = %s).\n", now(), status.MPI_SOURCE, commaint(file_header.simulation_seed));
-                }
-                MPI_Recv(pulse_headers, user.num_pulses * sizeof(IQPulseHeader), MPI_BYTE, k, 1, MPI_COMM_WORLD, &status);
-                if (verb > 1) {
-                    // printf("%s : Received pulse headers of %s B from node %d.\n", now(), commaint(status._count), status.MPI_SOURCE);
-                    MPI_Get_count(&status, MPI_INT, &count);
-                    printf("%s : Received pulse headers of %s B from node %d.\n", now(), commaint(count), status.MPI_SOURCE);
-                }
-                MPI_Recv(pulse_cache, user.num_pulses * S->params.range_count * sizeof(cl_float4), MPI_BYTE, k, 2, MPI_COMM_WORLD, &status);
-                if (verb > 1) {
-                    // printf("%s : Received pulse data of %s B from node %d.\n", now(), commaint(status._count), status.MPI_SOURCE);
-                    MPI_Get_count(&status, MPI_INT, &count);
-                    printf("%s : Received pulse data of %s B from node %d.\n", now(), commaint(count), status.MPI_SOURCE);
-                }
-                write_iq_file(user, &file_header, pulse_headers, pulse_cache, S->params.range_count, k);
+        if (user.split_population) {
+            // Pulses have been reduced to the master node, which is the only one with a complete data set
+            if (world_rank == 0) {
+                snprintf(charbuff, sizeof(charbuff), "%s.iq", prefix);
+                write_iq_file(user, charbuff, &file_header, pulse_headers, pulse_cache, S->params.range_count);
             }
         } else {
-            // Send data to master node
-            MPI_Send(&file_header, sizeof(IQFileHeader), MPI_BYTE, 0, 0, MPI_COMM_WORLD);
-            MPI_Send(pulse_headers, user.num_pulses * sizeof(IQPulseHeader), MPI_BYTE, 0, 1, MPI_COMM_WORLD);
-            MPI_Send(pulse_cache, user.num_pulses * S->params.range_count * sizeof(cl_float4), MPI_BYTE, 0, 2, MPI_COMM_WORLD);
+            // Every rank writes its own file in parallel, nothing goes through the master node
+            IQFileEntry entry;
+            memset(&entry, 0, sizeof(IQFileEntry));
+            snprintf(charbuff, sizeof(charbuff), "%s-r%04d.iq", prefix, world_rank);
+            entry.size = write_iq_file(user, charbuff, &file_header, pulse_headers, pulse_cache, S->params.range_count);
+            entry.seed = file_header.simulation_seed;
+            entry.num_pulses = user.num_pulses;
+            strncpy(entry.processor_name, processor_name, sizeof(entry.processor_name) - 1);
+
+            // Only the small entries are gathered for the index file
+            IQFileEntry *entries = NULL;
+            if (world_rank == 0) {
+                entries = (IQFileEntry *)malloc(world_size * sizeof(IQFileEntry));
+            }
+            MPI_Gather(&entry, sizeof(IQFileEntry), MPI_BYTE, entries, sizeof(IQFileEntry), MPI_BYTE, 0, MPI_COMM_WORLD);
+            if (world_rank == 0) {
+                snprintf(charbuff, sizeof(charbuff), "%s.index", prefix);
+                printf("%s : Index file : " UNDERLINE("%s") "\n", now(), charbuff);
+                fid = fopen(charbuff, "w");
+                if (fid == NULL) {
+                    fprintf(stderr, "%s : Error creating index file.\n", now());
+                } else {
+                    fprintf(fid, "# rank  seed  pulses  size  node  file\n");
+                    for (k = 0; k < world_size; k++) {
+                        fprintf(fid, "%d %u %u %lld %s %s-r%04d.iq\n", k, entries[k].seed, entries[k].num_pulses, (long long)entries[k].size,
+                                entries[k].processor_name, strrchr(prefix, '/') ? strrchr(prefix, '/') + 1 : prefix, k);
+                    }
+                    fclose(fid);
+                }
+                free(entries);
+            }
         }
 
 #else
 
-        write_iq_file(user, &file_header, pulse_headers, pulse_cache, S->params.range_count, 0);
+        snprintf(charbuff, sizeof(charbuff), "%s.iq", prefix);
+        write_iq_file(user, charbuff, &file_header, pulse_headers, pulse_cache, S->params.range_count);
         
 #endif
 
     }
 
+    if (user.output_moment_file) {
+
+#if defined (_OPEN_MPI)
+
+        if (user.split_population) {
+            if (world_rank == 0) {
+                snprintf(charbuff, sizeof(charbuff), "%s.mom", prefix);
+                write_radial_file(charbuff, IQ_MOMENT_FILE_MAGIC, &file_header, radial_headers, moments, S->params.range_count * sizeof(RSMoment), radial_count);
+            }
+        } else {
+            snprintf(charbuff, sizeof(charbuff), "%s-r%04d.mom", prefix, world_rank);
+            write_radial_file(charbuff, IQ_MOMENT_FILE_MAGIC, &file_header, radial_headers, moments, S->params.range_count * sizeof(RSMoment), radial_count);
+        }
+
+#else
+
+        snprintf(charbuff, sizeof(charbuff), "%s.mom", prefix);
+        write_radial_file(charbuff, IQ_MOMENT_FILE_MAGIC, &file_header, radial_headers, moments, S->params.range_count * sizeof(RSMoment), radial_count);
+
+#endif
+
+    }
+
+    if (user.output_spectrum_file) {
+
+#if defined (_OPEN_MPI)
+
+        if (user.split_population) {
+            if (world_rank == 0) {
+                snprintf(charbuff, sizeof(charbuff), "%s.spec", prefix);
+                write_radial_file(charbuff, IQ_SPECTRUM_FILE_MAGIC, &file_header, spectrum_headers, spectra, S->params.range_count * user.fft_count * sizeof(SPBin), spectrum_count);
+            }
+        } else {
+            snprintf(charbuff, sizeof(charbuff), "%s-r%04d.spec", prefix, world_rank);
+            write_radial_file(charbuff, IQ_SPECTRUM_FILE_MAGIC, &file_header, spectrum_headers, spectra, S->params.range_count * user.fft_count * sizeof(SPBin), spectrum_count);
+        }
+
+#else
+
+        snprintf(charbuff, sizeof(charbuff), "%s.spec", prefix);
+        write_radial_file(charbuff, IQ_SPECTRUM_FILE_MAGIC, &file_header, spectrum_headers, spectra, S->params.range_count * user.fft_count * sizeof(SPBin), spectrum_count);
+
+#endif
+
+    }
+
+#if defined (_OPEN_MPI)
+
+    // Only rank 0 writes the simulation state
+    if (world_rank > 0) {
+        user.output_state_file = false;
+    }
+
+#endif
+
     if (user.output_state_file) {
         memset(charbuff, 0, sizeof(charbuff));
         // snprintf(charbuff, sizeof(charbuff), "%s/sim-%s-%s%04.1f.simstate",
@@ -1188,6 +1677,15 @@ int main(int argc, char *argv[]) {
 
     free(pulse_headers);
     free(pulse_cache);
+    if (radial_headers) {
+        free(radial_headers);
+        free(moments);
+    }
+    if (spectrum_headers) {
+        SP_free(P);
+        free(spectrum_headers);
+        free(spectra);
+    }
 
     printf("%s : Session ended\n", now());
 
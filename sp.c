@@ -0,0 +1,273 @@
+//
+//  sp.c
+//  Radar Simulation Framework
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#include "sp.h"
+
+// Private structure
+
+typedef struct _sp_mem SPMem;
+
+typedef struct _sp_task {
+    SPMem         *h;
+    uint32_t      gate_start;
+    uint32_t      gate_end;
+    float         *work;              // 4 x fft_count floats for the H and V series
+} SPTask;
+
+struct _sp_mem {
+    uint32_t      range_count;
+    uint32_t      fft_count;
+    uint32_t      segment_count;
+    uint32_t      thread_count;
+    uint32_t      *bit_reverse;
+    float         *twiddle;           // cos and sin of -2 pi k / fft_count, k = 0 ... fft_count / 2 - 1
+    float         *window;            // Hann window scaled to unity mean power
+    float         *ring;              // Segment being filled, fft_count pulses of range_count x 4 floats
+    float         *work_ring;         // Segment being transformed by the threads
+    SPBin         *acc;               // Sum of the segment spectra of the current radial
+    uint32_t      fill;               // Number of pulses in ring
+    uint32_t      segment;            // Segment of the radial in work_ring
+    uint32_t      count;              // Number of pulses in the current radial
+    bool          busy;
+    bool          ready;              // acc holds a complete radial once the threads are done
+    pthread_t     tid[SP_MAX_THREADS];
+    SPTask        task[SP_MAX_THREADS];
+};
+
+// Private functions
+void SP_fft(const SPMem *h, float *x);
+void *SP_transform(void *in);
+void SP_wait(SPMem *h);
+
+#pragma mark -
+#pragma mark FFT
+
+// In-place radix-2 FFT of interleaved complex samples
+void SP_fft(const SPMem *h, float *x) {
+    const uint32_t n = h->fft_count;
+    uint32_t i, j, k, len, step;
+    float tr, ti, wr, wi;
+    for (i = 0; i < n; i++) {
+        j = h->bit_reverse[i];
+        if (j > i) {
+            tr = x[2 * i];     x[2 * i]     = x[2 * j];     x[2 * j]     = tr;
+            ti = x[2 * i + 1]; x[2 * i + 1] = x[2 * j + 1]; x[2 * j + 1] = ti;
+        }
+    }
+    for (len = 2; len <= n; len <<= 1) {
+        step = n / len;
+        for (i = 0; i < n; i += len) {
+            for (k = 0; k < len / 2; k++) {
+                wr = h->twiddle[2 * k * step];
+                wi = h->twiddle[2 * k * step + 1];
+                float *a = &x[2 * (i + k)];
+                float *b = &x[2 * (i + k + len / 2)];
+                tr = b[0] * wr - b[1] * wi;
+                ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+// Windowed H and V spectra of a range of gates, accumulated into acc
+void *SP_transform(void *in) {
+    SPTask *t = (SPTask *)in;
+    const SPMem *h = t->h;
+    const uint32_t n = h->fft_count;
+    const uint32_t stride = 4 * h->range_count;
+    const float s = 1.0f / ((float)n * (float)n);
+    float *xh = t->work;
+    float *xv = t->work + 2 * n;
+    uint32_t g, k, b, f;
+    for (g = t->gate_start; g < t->gate_end; g++) {
+        const float *src = &h->work_ring[4 * g];
+        for (k = 0; k < n; k++) {
+            xh[2 * k]     = h->window[k] * src[k * stride];
+            xh[2 * k + 1] = h->window[k] * src[k * stride + 1];
+            xv[2 * k]     = h->window[k] * src[k * stride + 2];
+            xv[2 * k + 1] = h->window[k] * src[k * stride + 3];
+        }
+        SP_fft(h, xh);
+        SP_fft(h, xv);
+        SPBin *acc = &h->acc[g * n];
+        for (b = 0; b < n; b++) {
+            // Signal is exp(-j k r) so a receding target has a negative frequency, bin b is v = -va + 2 va b / n
+            f = (n / 2 - b) & (n - 1);
+            const float hr = xh[2 * f], hi = xh[2 * f + 1];
+            const float vr = xv[2 * f], vi = xv[2 * f + 1];
+            if (h->segment == 0) {
+                memset(&acc[b], 0, sizeof(SPBin));
+            }
+            acc[b].hh   += s * (hr * hr + hi * hi);
+            acc[b].vv   += s * (vr * vr + vi * vi);
+            acc[b].hv_i += s * (vr * hr + vi * hi);
+            acc[b].hv_q += s * (vi * hr - vr * hi);
+        }
+    }
+    return NULL;
+}
+
+void SP_wait(SPMem *h) {
+    if (!h->busy) {
+        return;
+    }
+    for (uint32_t i = 0; i < h->thread_count; i++) {
+        pthread_join(h->tid[i], NULL);
+    }
+    h->busy = false;
+}
+
+#pragma mark -
+
+SPHandle SP_init(const uint32_t range_count, const uint32_t fft_count, const uint32_t segment_count, const uint32_t thread_count) {
+    uint32_t i, j, b;
+
+    if (fft_count < 2 || (fft_count & (fft_count - 1)) || segment_count == 0 || range_count == 0) {
+        fprintf(stderr, "Invalid spectrum setup: %u gates, %u-point FFT, %u segments.\n", range_count, fft_count, segment_count);
+        return NULL;
+    }
+
+    SPMem *h = (SPMem *)malloc(sizeof(SPMem));
+    if (h == NULL) {
+        fprintf(stderr, "Unable to allocate resources for spectrum processing.\n");
+        return NULL;
+    }
+    memset(h, 0, sizeof(SPMem));
+
+    h->range_count = range_count;
+    h->fft_count = fft_count;
+    h->segment_count = segment_count;
+    h->thread_count = thread_count;
+    if (h->thread_count == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        h->thread_count = n > 0 ? (uint32_t)n : 1;
+    }
+    h->thread_count = MIN(MIN(h->thread_count, SP_MAX_THREADS), range_count);
+
+    h->bit_reverse = (uint32_t *)malloc(fft_count * sizeof(uint32_t));
+    h->twiddle = (float *)malloc(fft_count * sizeof(float));
+    h->window = (float *)malloc(fft_count * sizeof(float));
+    h->ring = (float *)malloc(fft_count * range_count * 4 * sizeof(float));
+    h->work_ring = (float *)malloc(fft_count * range_count * 4 * sizeof(float));
+    h->acc = (SPBin *)malloc(range_count * fft_count * sizeof(SPBin));
+    for (i = 0; i < h->thread_count; i++) {
+        h->task[i].h = h;
+        h->task[i].gate_start = i * range_count / h->thread_count;
+        h->task[i].gate_end = (i + 1) * range_count / h->thread_count;
+        h->task[i].work = (float *)malloc(4 * fft_count * sizeof(float));
+        if (h->task[i].work == NULL) {
+            h->thread_count = i;
+            break;
+        }
+    }
+    if (h->bit_reverse == NULL || h->twiddle == NULL || h->window == NULL ||
+        h->ring == NULL || h->work_ring == NULL || h->acc == NULL || h->thread_count == 0) {
+        fprintf(stderr, "Unable to allocate spectrum buffers.\n");
+        SP_free(h);
+        return NULL;
+    }
+
+    for (b = 0; (1u << b) < fft_count; b++) {}
+    for (i = 0; i < fft_count; i++) {
+        for (j = 0, h->bit_reverse[i] = 0; j < b; j++) {
+            h->bit_reverse[i] |= ((i >> j) & 1) << (b - 1 - j);
+        }
+    }
+    for (i = 0; i < fft_count / 2; i++) {
+        h->twiddle[2 * i]     = cosf(-2.0f * M_PI * (float)i / (float)fft_count);
+        h->twiddle[2 * i + 1] = sinf(-2.0f * M_PI * (float)i / (float)fft_count);
+    }
+    // Periodic Hann window, sum of squares = fft_count so the bins add up to the mean power
+    for (i = 0; i < fft_count; i++) {
+        h->window[i] = sqrtf(8.0f / 3.0f) * (0.5f - 0.5f * cosf(2.0f * M_PI * (float)i / (float)fft_count));
+    }
+
+    return (SPHandle)h;
+}
+
+int SP_add_pulse(SPHandle i, const float *samples) {
+    SPMem *h = (SPMem *)i;
+    if (h->count == h->fft_count * h->segment_count) {
+        h->count = 0;
+    }
+    memcpy(&h->ring[h->fill * h->range_count * 4], samples, h->range_count * 4 * sizeof(float));
+    h->count++;
+    if (++h->fill < h->fft_count) {
+        return h->count;
+    }
+    // Hand the full segment to the threads, waiting for the previous one first
+    SP_wait(h);
+    float *tmp = h->work_ring;
+    h->work_ring = h->ring;
+    h->ring = tmp;
+    h->fill = 0;
+    h->segment = (h->count - 1) / h->fft_count;
+    h->ready = h->segment == h->segment_count - 1;
+    for (uint32_t k = 0; k < h->thread_count; k++) {
+        if (pthread_create(&h->tid[k], NULL, SP_transform, &h->task[k])) {
+            // Finish the rest in this thread
+            for (uint32_t j = 0; j < k; j++) {
+                pthread_join(h->tid[j], NULL);
+            }
+            for (uint32_t j = k; j < h->thread_count; j++) {
+                SP_transform(&h->task[j]);
+            }
+            return h->count;
+        }
+    }
+    h->busy = true;
+    return h->count;
+}
+
+int SP_get_spectra(SPHandle i, SPBin *spectra) {
+    SPMem *h = (SPMem *)i;
+    SP_wait(h);
+    if (!h->ready) {
+        fprintf(stderr, "No complete radial for the spectra.\n");
+        return -1;
+    }
+    const float s = 1.0f / (float)h->segment_count;
+    for (uint32_t k = 0; k < h->range_count * h->fft_count; k++) {
+        spectra[k].hh   = s * h->acc[k].hh;
+        spectra[k].vv   = s * h->acc[k].vv;
+        spectra[k].hv_i = s * h->acc[k].hv_i;
+        spectra[k].hv_q = s * h->acc[k].hv_q;
+    }
+    return 0;
+}
+
+uint32_t SP_get_fft_count(const SPHandle i) {
+    return ((SPMem *)i)->fft_count;
+}
+
+uint32_t SP_get_dwell(const SPHandle i) {
+    SPMem *h = (SPMem *)i;
+    return h->fft_count * h->segment_count;
+}
+
+void SP_free(SPHandle i) {
+    SPMem *h = (SPMem *)i;
+    if (h == NULL) {
+        return;
+    }
+    SP_wait(h);
+    for (uint32_t k = 0; k < SP_MAX_THREADS; k++) {
+        free(h->task[k].work);
+    }
+    free(h->bit_reverse);
+    free(h->twiddle);
+    free(h->window);
+    free(h->ring);
+    free(h->work_ring);
+    free(h->acc);
+    free(h);
+}
@@ -0,0 +1,51 @@
+//
+//  sp.h
+//  Radar Simulation Framework
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#ifndef sp_h
+#define sp_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "rs_const.h"
+
+#define SP_MAX_THREADS   16
+
+typedef void * SPHandle;
+
+// One Doppler bin of a gate, bins are in velocity order from -va to va (positive away from the radar)
+typedef struct sp_bin {
+    float  hh;        // Power of H
+    float  vv;        // Power of V
+    float  hv_i;      // Real part of V H*
+    float  hv_q;      // Imaginary part of V H*
+} SPBin;
+
+// fft_count must be a power of two, a radial is segment_count x fft_count pulses
+// thread_count = 0 uses all the online processors
+SPHandle SP_init(const uint32_t range_count, const uint32_t fft_count, const uint32_t segment_count, const uint32_t thread_count);
+
+// Samples are range_count gates of (hi, hq, vi, vq) as in an IQ file
+// Returns the number of pulses in the current radial, a radial is complete when this equals SP_get_dwell()
+int SP_add_pulse(SPHandle, const float *samples);
+
+// Averaged spectra of the last complete radial, range_count x fft_count bins
+int SP_get_spectra(SPHandle, SPBin *spectra);
+
+uint32_t SP_get_fft_count(const SPHandle);
+uint32_t SP_get_dwell(const SPHandle);
+
+void SP_free(SPHandle);
+
+#endif /* sp_h */
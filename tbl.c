@@ -0,0 +1,354 @@
+//
+//  tbl.c
+//  Radar Simulation Framework
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#include "tbl.h"
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define TBL_MAX_FILES   4096
+
+// Private structure
+typedef struct _tbl_mem {
+    char            path[1024];
+    int             fd;
+    size_t          size;
+    const uint8_t   *base;
+    TBLFileHeader   *header;
+    const TBLEntry  *index;
+} TBLMem;
+
+typedef struct _tbl_list {
+    char            *names[TBL_MAX_FILES];
+    uint32_t        count;
+} TBLList;
+
+// Private functions
+int TBL_entry_cmp(const void *key, const void *entry);
+int TBL_name_cmp(const void *a, const void *b);
+int TBL_list_folder(TBLList *list, const char *folder, const char *prefix);
+int TBL_write_bundle(const TBLList *list, const char *folder, const char *filename);
+void TBL_shared_init(void);
+
+static TBLHandle tbl_shared = NULL;
+static pthread_once_t tbl_shared_once = PTHREAD_ONCE_INIT;
+
+#pragma mark -
+#pragma mark Reader
+
+int TBL_entry_cmp(const void *key, const void *entry) {
+    return strcmp((const char *)key, ((const TBLEntry *)entry)->name);
+}
+
+
+TBLHandle TBL_open(const char *filename) {
+    struct stat file_stat;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening table bundle %s.\n", filename);
+        return NULL;
+    }
+    if (fstat(fd, &file_stat) < 0 || file_stat.st_size < sizeof(TBLFileHeader)) {
+        fprintf(stderr, "Table bundle %s is too small.\n", filename);
+        close(fd);
+        return NULL;
+    }
+
+    void *base = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Unable to map table bundle %s.\n", filename);
+        close(fd);
+        return NULL;
+    }
+
+    TBLFileHeader *header = (TBLFileHeader *)base;
+    if (memcmp(header->magic, TBL_FILE_MAGIC, sizeof(header->magic)) || header->version > TBL_FILE_VERSION ||
+        header->size != file_stat.st_size || header->index_offset + header->count * sizeof(TBLEntry) > header->size) {
+        fprintf(stderr, "Table bundle %s is not valid.\n", filename);
+        munmap(base, file_stat.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    TBLMem *h = (TBLMem *)malloc(sizeof(TBLMem));
+    if (h == NULL) {
+        fprintf(stderr, "Unable to allocate resources for table bundle.\n");
+        munmap(base, file_stat.st_size);
+        close(fd);
+        return NULL;
+    }
+    memset(h, 0, sizeof(TBLMem));
+
+    snprintf(h->path, sizeof(h->path), "%s", filename);
+    h->fd = fd;
+    h->size = file_stat.st_size;
+    h->base = (const uint8_t *)base;
+    h->header = header;
+    h->index = (const TBLEntry *)(h->base + header->index_offset);
+
+    #ifdef DEBUG
+    rsprint("Table bundle %s   %u files   %s B\n", filename, header->count, commaint(h->size));
+    #endif
+
+    return (TBLHandle)h;
+}
+
+
+void TBL_close(TBLHandle i) {
+    TBLMem *h = (TBLMem *)i;
+    if (h == NULL) {
+        return;
+    }
+    munmap((void *)h->base, h->size);
+    close(h->fd);
+    free(h);
+}
+
+
+const void *TBL_find(const TBLHandle i, const char *name, size_t *size) {
+    TBLMem *h = (TBLMem *)i;
+    const TBLEntry *entry = (const TBLEntry *)bsearch(name, h->index, h->header->count, sizeof(TBLEntry), TBL_entry_cmp);
+    if (entry == NULL || entry->offset + entry->size > h->size) {
+        return NULL;
+    }
+    if (size) {
+        *size = entry->size;
+    }
+    return h->base + entry->offset;
+}
+
+
+uint32_t TBL_get_count(const TBLHandle i) {
+    return ((TBLMem *)i)->header->count;
+}
+
+
+const TBLEntry *TBL_get_entry(const TBLHandle i, const uint32_t k) {
+    TBLMem *h = (TBLMem *)i;
+    if (k >= h->header->count) {
+        return NULL;
+    }
+    return &h->index[k];
+}
+
+#pragma mark -
+#pragma mark Shared Bundle
+
+void TBL_shared_init(void) {
+    if (tbl_shared != NULL) {
+        return;
+    }
+    char *filename = getenv(TBL_BUNDLE_ENV);
+    if (filename != NULL && strlen(filename)) {
+        tbl_shared = TBL_open(filename);
+    }
+}
+
+
+int TBL_use_bundle(const char *filename) {
+    TBLHandle h = TBL_open(filename);
+    if (h == NULL) {
+        return -1;
+    }
+    // Tables handed out earlier may point into the previous bundle so it stays mapped
+    tbl_shared = h;
+    return 0;
+}
+
+
+TBLHandle TBL_shared(void) {
+    pthread_once(&tbl_shared_once, TBL_shared_init);
+    return tbl_shared;
+}
+
+
+FILE *TBL_fopen(const char *path) {
+    const size_t n = strlen(TBL_BUNDLE_ROOT);
+    if (strncmp(path, TBL_BUNDLE_ROOT, n) || path[n] != '/') {
+        return fopen(path, "r");
+    }
+    size_t size = 0;
+    const void *data = TBL_shared() ? TBL_find(TBL_shared(), path + n + 1, &size) : NULL;
+    if (data == NULL) {
+        return NULL;
+    }
+    return fmemopen((void *)data, size, "r");
+}
+
+
+long TBL_file_size(const char *path) {
+    const size_t n = strlen(TBL_BUNDLE_ROOT);
+    if (strncmp(path, TBL_BUNDLE_ROOT, n) || path[n] != '/') {
+        struct stat file_stat;
+        if (stat(path, &file_stat) < 0 || !S_ISREG(file_stat.st_mode)) {
+            return -1;
+        }
+        return (long)file_stat.st_size;
+    }
+    size_t size = 0;
+    if (TBL_shared() == NULL || TBL_find(TBL_shared(), path + n + 1, &size) == NULL) {
+        return -1;
+    }
+    return (long)size;
+}
+
+#pragma mark -
+#pragma mark Writer
+
+int TBL_name_cmp(const void *a, const void *b) {
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+
+int TBL_list_folder(TBLList *list, const char *folder, const char *prefix) {
+    char path[1024];
+    char name[1024];
+    struct dirent *dir;
+    struct stat file_stat;
+
+    if (snprintf(path, sizeof(path), "%s%s%s", folder, strlen(prefix) ? "/" : "", prefix) >= sizeof(path)) {
+        fprintf(stderr, "Folder %s/%s is too long.\n", folder, prefix);
+        return -1;
+    }
+    DIR *d = opendir(path);
+    if (d == NULL) {
+        fprintf(stderr, "Unable to open folder %s.\n", path);
+        return -1;
+    }
+    while ((dir = readdir(d)) != NULL) {
+        if (dir->d_name[0] == '.' || dir->d_name[0] == '_') {
+            continue;
+        }
+        // A truncated path would point at another file, skip the entry
+        if (snprintf(name, sizeof(name), "%s%s%s", prefix, strlen(prefix) ? "/" : "", dir->d_name) >= sizeof(name) ||
+            snprintf(path, sizeof(path), "%s/%s", folder, name) >= sizeof(path)) {
+            fprintf(stderr, "Path of %s in %s is too long, skipped.\n", dir->d_name, folder);
+            continue;
+        }
+        if (stat(path, &file_stat) < 0) {
+            continue;
+        }
+        if (S_ISDIR(file_stat.st_mode)) {
+            if (TBL_list_folder(list, folder, name)) {
+                closedir(d);
+                return -1;
+            }
+        } else if (S_ISREG(file_stat.st_mode)) {
+            if (strlen(name) >= sizeof(((TBLEntry *)0)->name)) {
+                fprintf(stderr, "Name %s is too long for the bundle.\n", name);
+                closedir(d);
+                return -1;
+            }
+            if (list->count >= TBL_MAX_FILES) {
+                fprintf(stderr, "Too many files for the bundle.\n");
+                closedir(d);
+                return -1;
+            }
+            list->names[list->count++] = strdup(name);
+        }
+    }
+    closedir(d);
+    return 0;
+}
+
+
+int TBL_write_bundle(const TBLList *list, const char *folder, const char *filename) {
+    uint32_t k;
+    char path[1024];
+    char buf[65536];
+    size_t r;
+
+    TBLEntry *index = (TBLEntry *)malloc(list->count * sizeof(TBLEntry) + 1);
+    if (index == NULL) {
+        fprintf(stderr, "Unable to allocate the bundle index.\n");
+        return -1;
+    }
+    memset(index, 0, list->count * sizeof(TBLEntry));
+
+    FILE *fid = fopen(filename, "w");
+    if (fid == NULL) {
+        fprintf(stderr, "Error creating file %s.\n", filename);
+        free(index);
+        return -1;
+    }
+
+    TBLFileHeader header;
+    memset(&header, 0, sizeof(TBLFileHeader));
+    fwrite(&header, sizeof(TBLFileHeader), 1, fid);
+
+    uint64_t offset = sizeof(TBLFileHeader);
+    for (k = 0; k < list->count; k++) {
+        FILE *src = NULL;
+        if (snprintf(path, sizeof(path), "%s/%s", folder, list->names[k]) < sizeof(path)) {
+            src = fopen(path, "r");
+        }
+        if (src == NULL) {
+            fprintf(stderr, "Error opening file %s.\n", path);
+            fclose(fid);
+            free(index);
+            return -1;
+        }
+        snprintf(index[k].name, sizeof(index[k].name), "%s", list->names[k]);
+        index[k].offset = offset;
+        while ((r = fread(buf, 1, sizeof(buf), src)) > 0) {
+            fwrite(buf, 1, r, fid);
+            index[k].size += r;
+        }
+        fclose(src);
+        offset += index[k].size;
+        // Pad so that the next file starts at an aligned offset
+        memset(buf, 0, TBL_ALIGNMENT);
+        r = (TBL_ALIGNMENT - offset % TBL_ALIGNMENT) % TBL_ALIGNMENT;
+        fwrite(buf, 1, r, fid);
+        offset += r;
+    }
+
+    header.index_offset = offset;
+    fwrite(index, sizeof(TBLEntry), list->count, fid);
+    offset += list->count * sizeof(TBLEntry);
+    free(index);
+
+    // Header goes in last so that an incomplete bundle is never valid
+    memcpy(header.magic, TBL_FILE_MAGIC, sizeof(header.magic));
+    header.version = TBL_FILE_VERSION;
+    header.count = list->count;
+    header.size = offset;
+    rewind(fid);
+    fwrite(&header, sizeof(TBLFileHeader), 1, fid);
+
+    if (fclose(fid)) {
+        fprintf(stderr, "Error writing file %s.\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+
+int TBL_pack(const char *folder, const char *filename) {
+    TBLList *list = (TBLList *)malloc(sizeof(TBLList));
+    if (list == NULL) {
+        fprintf(stderr, "Unable to allocate resources for table bundle.\n");
+        return -1;
+    }
+    list->count = 0;
+
+    int ret = TBL_list_folder(list, folder, "");
+    if (ret == 0) {
+        qsort(list->names, list->count, sizeof(char *), TBL_name_cmp);
+        ret = TBL_write_bundle(list, folder, filename);
+    }
+
+    for (uint32_t k = 0; k < list->count; k++) {
+        free(list->names[k]);
+    }
+    free(list);
+    return ret;
+}
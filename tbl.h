@@ -0,0 +1,69 @@
+//
+//  tbl.h
+//  Radar Simulation Framework
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#ifndef _radarsim_tbl_h
+#define _radarsim_tbl_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "log.h"
+
+#define TBL_FILE_MAGIC        "SRTB"
+#define TBL_FILE_VERSION      1
+#define TBL_ALIGNMENT         64
+#define TBL_BUNDLE_ROOT       "[bundle]"             // Data path of the tables that come from the shared bundle
+#define TBL_BUNDLE_ENV        "SIMRADAR_TABLES"      // Environment variable of the shared bundle
+
+typedef void * TBLHandle;
+
+// Header of a bundle, followed by the files, each aligned to TBL_ALIGNMENT, then the index
+typedef union tbl_file_header {
+    char raw[64];
+    struct {
+        char      magic[4];           // TBL_FILE_MAGIC
+        uint32_t  version;            // Container version
+        uint32_t  count;              // Number of files
+        uint32_t  reserved;
+        uint64_t  index_offset;       // Byte offset of the index, an array of count TBLEntry sorted by name
+        uint64_t  size;               // Size of the bundle in bytes
+    };
+} TBLFileHeader;
+
+// Index entry, name is relative to the tables folder, e.g. adm/square_plate.adm
+typedef struct tbl_entry {
+    char      name[112];
+    uint64_t  offset;                 // Byte offset of the file content from the beginning of the bundle
+    uint64_t  size;                   // Size of the file in bytes
+} TBLEntry;
+
+// Reader, the whole bundle is one read-only mapping
+TBLHandle TBL_open(const char *filename);
+void TBL_close(TBLHandle);
+const void *TBL_find(const TBLHandle, const char *name, size_t *size);
+uint32_t TBL_get_count(const TBLHandle);
+const TBLEntry *TBL_get_entry(const TBLHandle, const uint32_t k);
+
+// Process-wide bundle from TBL_use_bundle(), or TBL_BUNDLE_ENV if it has not been called
+int TBL_use_bundle(const char *filename);
+TBLHandle TBL_shared(void);
+
+// Paths under TBL_BUNDLE_ROOT are served from the shared bundle, others from the file system
+FILE *TBL_fopen(const char *path);
+long TBL_file_size(const char *path);
+
+// Writer, the same table set as zip_simradar_tables.sh: no hidden files, nothing that starts with '_'
+int TBL_pack(const char *folder, const char *filename);
+
+#endif
@@ -0,0 +1,48 @@
+//
+//  tblpack.c
+//  Pack the tables folder into a single bundle
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+//
+
+#include "tbl.h"
+
+int main(int argc, char **argv) {
+
+    int k;
+    
+    if (argc == 3 && !strcmp(argv[1], "-l")) {
+        TBLHandle T = TBL_open(argv[2]);
+        if (T == NULL) {
+            return EXIT_FAILURE;
+        }
+        for (k = 0; k < TBL_get_count(T); k++) {
+            const TBLEntry *entry = TBL_get_entry(T, k);
+            printf("%14s B   %s\n", commaint(entry->size), entry->name);
+        }
+        TBL_close(T);
+        return EXIT_SUCCESS;
+    }
+    
+    if (argc != 3) {
+        printf("Usage: %s FOLDER BUNDLE    pack the tables in FOLDER, e.g. tables, into BUNDLE\n", argv[0]);
+        printf("       %s -l BUNDLE        list the content of BUNDLE\n\n", argv[0]);
+        printf("Point the environment variable %s to the bundle to use it.\n", TBL_BUNDLE_ENV);
+        return EXIT_FAILURE;
+    }
+    
+    if (TBL_pack(argv[1], argv[2])) {
+        return EXIT_FAILURE;
+    }
+    
+    TBLHandle T = TBL_open(argv[2]);
+    if (T == NULL) {
+        return EXIT_FAILURE;
+    }
+    printf("%s : %u files\n", argv[2], TBL_get_count(T));
+    TBL_close(T);
+    
+    return EXIT_SUCCESS;
+}
@@ -24,6 +24,20 @@ int main(int argc, const char **argv) {
     table = ADM_get_table(A, ADMConfigModelPlate);
     ADM_show_table_summary(table);
     
+    // A second request of the same table shares the data but not the physical description
+    ADMTable *other = ADM_get_table(A, ADMConfigModelPlate);
+    ADM_dimension_set(other, 0.001f, 0.08f, 0.06f, 350.0f);
+    if (other->data.cdx != table->data.cdx || other->hash != table->hash || other->phys.mass == table->phys.mass) {
+        fprintf(stderr, "ADM table was not shared.\n");
+        return EXIT_FAILURE;
+    }
+    ADM_release_table(A, other);
+    if (table->data.cdx == NULL) {
+        fprintf(stderr, "ADM table released while in use.\n");
+        return EXIT_FAILURE;
+    }
+    printf("Shared ADM table %s  hash = 0x%08x\n", table->path, table->hash);
+    
     ADM_free(A);
     
     return EXIT_SUCCESS;
@@ -0,0 +1,93 @@
+//
+//  test_iq.c
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "iq.h"
+
+#define TEST_GATES    100
+#define TEST_PULSES   250
+
+// Write a small file, read it back through the index and compare
+int test_round_trip(const char *filename, const uint32_t chunk_pulses, const IQCompression compression) {
+    int k, g;
+    IQFileHeader file_header;
+    IQPulseHeader pulse_header;
+    float samples[TEST_GATES * 4];
+
+    memset(&file_header, 0, sizeof(IQFileHeader));
+    file_header.params.range_count = TEST_GATES;
+    file_header.simulation_seed = 1234;
+    file_header.compression = compression;
+
+    IQHandle I = IQ_create(filename, &file_header, chunk_pulses);
+    if (I == NULL) {
+        return EXIT_FAILURE;
+    }
+    for (k = 0; k < TEST_PULSES; k++) {
+        memset(&pulse_header, 0, sizeof(IQPulseHeader));
+        pulse_header.time = (float)k * 1.0e-3f;
+        pulse_header.el_deg = 3.0f;
+        pulse_header.az_deg = fmodf((float)k * 1.5f, 360.0f);
+        for (g = 0; g < TEST_GATES * 4; g++) {
+            samples[g] = (float)(k * 10000 + g);
+        }
+        IQ_write_pulse(I, &pulse_header, samples);
+    }
+    IQ_close(I);
+
+    I = IQ_open(filename);
+    if (I == NULL) {
+        return EXIT_FAILURE;
+    }
+    struct stat file_stat;
+    stat(filename, &file_stat);
+    printf("chunk_pulses = %u   compression = %u   version = %u   range_count = %u   pulse_count = %u   chunk_count = %u   size = %s B\n",
+           chunk_pulses, compression, IQ_get_version(I), IQ_get_range_count(I), IQ_get_pulse_count(I), IQ_get_chunk_count(I), commaint(file_stat.st_size));
+    if (IQ_get_range_count(I) != TEST_GATES || IQ_get_pulse_count(I) != TEST_PULSES) {
+        fprintf(stderr, "Unexpected counts.\n");
+        IQ_close(I);
+        return EXIT_FAILURE;
+    }
+    // Random access, backwards
+    for (k = TEST_PULSES - 1; k >= 0; k -= 7) {
+        IQ_read_pulse(I, k, &pulse_header, samples);
+        if (pulse_header.time != (float)k * 1.0e-3f || samples[0] != (float)(k * 10000) || samples[TEST_GATES * 4 - 1] != (float)(k * 10000 + TEST_GATES * 4 - 1)) {
+            fprintf(stderr, "Pulse %d mismatch.\n", k);
+            IQ_close(I);
+            return EXIT_FAILURE;
+        }
+    }
+    k = IQ_find_pulse_by_time(I, 0.1f);
+    g = IQ_find_pulse_by_azimuth(I, 90.0f);
+    printf("Pulse @ t = 0.1 s -> %d   Pulse @ az = 90 deg -> %d\n", k, g);
+    if (k != 100 || g != 60) {
+        fprintf(stderr, "Search failed.\n");
+        IQ_close(I);
+        return EXIT_FAILURE;
+    }
+    IQ_close(I);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, const char **argv) {
+
+    printf("Testing IQ file container ...\n");
+
+    char filename[] = "/tmp/test_iq.iq";
+
+    if (test_round_trip(filename, 0, IQCompressionNone) != EXIT_SUCCESS ||
+        test_round_trip(filename, 16, IQCompressionNone) != EXIT_SUCCESS ||
+        test_round_trip(filename, 16, IQCompressionShuffleLZ) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    remove(filename);
+
+    return EXIT_SUCCESS;
+}
@@ -47,6 +47,41 @@ float deg2rad(const float deg) {
     return deg * 0.01745329251994f;
 }
 
+// Pass 1 and pass 2 arguments, shared by the plain and the subgroup builds
+cl_int set_make_pulse_args(cl_kernel pass_1, cl_kernel pass_2, const cl_uint pass_1_dim, RSMakePulseParams *R,
+                           cl_mem *work, cl_mem *sig, cl_mem *aux, cl_mem *range_weight, cl_float4 *range_weight_desc, cl_mem *pulse) {
+    cl_int err = CL_SUCCESS;
+    err |= clSetKernelArg(pass_1, 0, sizeof(cl_mem), work);
+    err |= clSetKernelArg(pass_1, 1, sizeof(cl_mem), sig);
+    err |= clSetKernelArg(pass_1, 2, sizeof(cl_mem), aux);
+    err |= clSetKernelArg(pass_1, 3, R->local_mem_size[0], NULL);
+    err |= clSetKernelArg(pass_1, 4, sizeof(cl_mem), range_weight);
+    err |= clSetKernelArg(pass_1, 5, sizeof(cl_float4), range_weight_desc);
+    err |= clSetKernelArg(pass_1, 6, sizeof(float), &R->range_start);
+    err |= clSetKernelArg(pass_1, 7, sizeof(float), &R->range_delta);
+    err |= clSetKernelArg(pass_1, 8, sizeof(unsigned int), &R->range_count);
+    err |= clSetKernelArg(pass_1, 9, sizeof(unsigned int), &R->group_counts[0]);
+    err |= clSetKernelArg(pass_1, 10, sizeof(unsigned int), &R->entry_counts[0]);
+    if (pass_1_dim == 2) {
+        err |= clSetKernelArg(pass_1, 11, sizeof(unsigned int), &R->tile_size);
+    }
+    err |= clSetKernelArg(pass_2, 0, sizeof(cl_mem), pulse);
+    err |= clSetKernelArg(pass_2, 1, sizeof(cl_mem), work);
+    err |= clSetKernelArg(pass_2, 2, R->local_mem_size[1], NULL);
+    err |= clSetKernelArg(pass_2, 3, sizeof(unsigned int), &R->range_count);
+    err |= clSetKernelArg(pass_2, 4, sizeof(unsigned int), &R->entry_counts[1]);
+    return err;
+}
+
+const char *pass_2_kernel_name(const RSMakePulseParams *R) {
+    if (R->cl_pass_2_method == RS_CL_PASS_2_IN_RANGE) {
+        return "make_pulse_pass_2_range";
+    } else if (R->cl_pass_2_method == RS_CL_PASS_2_IN_LOCAL) {
+        return "make_pulse_pass_2_local";
+    }
+    return "make_pulse_pass_2_group";
+}
+
 int main(int argc, char **argv)
 {
 	char c;
@@ -117,8 +152,9 @@ int main(int argc, char **argv)
     cl_event events[3];
     
     unsigned int num_elem = NUM_ELEM;
+    bool tiled = false;
 
-	while ((c = getopt(argc, argv, "ac12dewgvn:p:h?")) != -1) {
+	while ((c = getopt(argc, argv, "ac12dewgtvn:p:h?")) != -1) {
 		switch (c) {
 			case 'a':
 				test = TEST_ALL;
@@ -144,6 +180,9 @@ int main(int argc, char **argv)
 			case 'c':
 				test |= TEST_CPU;
 				break;
+			case 't':
+				tiled = true;
+				break;
 			case 'v':
 				verb++;
 				break;
@@ -165,6 +204,7 @@ int main(int argc, char **argv)
                        "    -d     GPU test: scat_db_atts\n"
                        "    -w     GPU test: scat_sig_aux\n"
 					   "    -g     All GPU Tests\n"
+					   "    -t     Tiled make_pulse_pass_1 with local memory for 4 gates\n"
 					   "    -v     increases verbosity\n"
 					   "    -n N   speed test using N iterations\n"
 					   "\n",
@@ -359,6 +399,9 @@ int main(int argc, char **argv)
     // Global / local parameterization for CL kernels
     cl_ulong local_mem_size;
     clGetDeviceInfo(devices[0], CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &local_mem_size, NULL);
+    if (tiled) {
+        local_mem_size = 4 * GROUP_ITEMS * sizeof(cl_float4);
+    }
 
     RSMakePulseParams R = RS_make_pulse_params(num_elem, GROUP_ITEMS, GROUP_COUNTS, local_mem_size, 1.0f, 0.25f, RANGE_GATES);
     
@@ -438,36 +481,24 @@ int main(int argc, char **argv)
     }
     
     // Pass 1 setup
-    printf("Pass 1   global=%5d   local=%3d   groups=%3d   entries=%7d  local_mem=%5zu (%2d x %d cl_float4)\n",
+    printf("Pass 1   global=%5d   local=%3d   groups=%3d   entries=%7d  local_mem=%5zu (%2d x %d cl_float4)  tiles=%d\n",
            (int)R.global[0],
            (int)R.local[0],
            R.group_counts[0],
            R.entry_counts[0],
            R.local_mem_size[0],
-           R.range_count,
-           (int)R.local[0]);
+           R.tile_size,
+           (int)R.local[0],
+           R.tile_count);
     
-    kernel_make_pulse_pass_1 = clCreateKernel(program, "make_pulse_pass_1", &ret);
+    const cl_uint pass_1_dim = R.tile_count > 1 ? 2 : 1;
+    const size_t pass_1_global[] = {R.global[0], R.tile_count};
+    const size_t pass_1_local[] = {R.local[0], 1};
+    kernel_make_pulse_pass_1 = clCreateKernel(program, pass_1_dim == 2 ? "make_pulse_pass_1_tiled" : "make_pulse_pass_1", &ret);
     if (ret != CL_SUCCESS) {
         fprintf(stderr, "Error: Failed to compile kernel.\n");
         exit(EXIT_FAILURE);
     }
-    err = CL_SUCCESS;
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 0, sizeof(cl_mem), &work);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 1, sizeof(cl_mem), &sig);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 2, sizeof(cl_mem), &aux);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 3, R.local_mem_size[0], NULL);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 4, sizeof(cl_mem), &range_weight);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 5, sizeof(cl_float4), &range_weight_desc);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 6, sizeof(float), &R.range_start);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 7, sizeof(float), &R.range_delta);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 8, sizeof(unsigned int), &R.range_count);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 9, sizeof(unsigned int), &R.group_counts[0]);
-    err |= clSetKernelArg(kernel_make_pulse_pass_1, 10, sizeof(unsigned int), &R.entry_counts[0]);
-    if (err != CL_SUCCESS) {
-        fprintf(stderr, "Error: Failed to set kernel arguments.\n");
-        exit(EXIT_FAILURE);
-    }
     
     // Should check against hardware limits
     //	ret = clGetKernelWorkGroupInfo(kernel_make_pulse_pass_1, devices[0], CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &work_group_size, NULL);
@@ -483,23 +514,13 @@ int main(int argc, char **argv)
            R.cl_pass_2_method == RS_CL_PASS_2_IN_RANGE ? "Range" :
            (R.cl_pass_2_method == RS_CL_PASS_2_IN_LOCAL ? "Local" : "Universal"));
     
-    if (R.cl_pass_2_method == RS_CL_PASS_2_IN_RANGE) {
-        kernel_make_pulse_pass_2 = clCreateKernel(program, "make_pulse_pass_2_range", &ret);
-    } else if (R.cl_pass_2_method == RS_CL_PASS_2_IN_LOCAL) {
-        kernel_make_pulse_pass_2 = clCreateKernel(program, "make_pulse_pass_2_local", &ret);
-    } else {
-        kernel_make_pulse_pass_2 = clCreateKernel(program, "make_pulse_pass_2_group", &ret);
-    }
+    kernel_make_pulse_pass_2 = clCreateKernel(program, pass_2_kernel_name(&R), &ret);
     if (ret != CL_SUCCESS) {
         fprintf(stderr, "Error: Failed to compile kernel.\n");
         exit(EXIT_FAILURE);
     }
-    err = CL_SUCCESS;
-    err |= clSetKernelArg(kernel_make_pulse_pass_2, 0, sizeof(cl_mem), &pulse);
-    err |= clSetKernelArg(kernel_make_pulse_pass_2, 1, sizeof(cl_mem), &work);
-    err |= clSetKernelArg(kernel_make_pulse_pass_2, 2, R.local_mem_size[1], NULL);
-    err |= clSetKernelArg(kernel_make_pulse_pass_2, 3, sizeof(unsigned int), &R.range_count);
-    err |= clSetKernelArg(kernel_make_pulse_pass_2, 4, sizeof(unsigned int), &R.entry_counts[1]);
+    err = set_make_pulse_args(kernel_make_pulse_pass_1, kernel_make_pulse_pass_2, pass_1_dim, &R,
+                              &work, &sig, &aux, &range_weight, &range_weight_desc, &pulse);
     if (err != CL_SUCCESS) {
         fprintf(stderr, "Error: Failed to set kernel arguments.\n");
         exit(EXIT_FAILURE);
@@ -579,7 +600,7 @@ int main(int argc, char **argv)
 	err = CL_SUCCESS;
     err |= clEnqueueNDRangeKernel(queue, kernel_pop, 1, NULL, &global_size, NULL, 0, NULL, NULL);
     err |= clEnqueueNDRangeKernel(queue, kernel_scat_sig_aux, 1, NULL, &global_size, NULL, 0, NULL, &events[0]);
-	err |= clEnqueueNDRangeKernel(queue, kernel_make_pulse_pass_1, 1, NULL, &R.global[0], &R.local[0], 1, &events[0], &events[1]);
+	err |= clEnqueueNDRangeKernel(queue, kernel_make_pulse_pass_1, pass_1_dim, NULL, pass_1_global, pass_1_local, 1, &events[0], &events[1]);
 	err |= clEnqueueNDRangeKernel(queue, kernel_make_pulse_pass_2, 1, NULL, &R.global[1], &R.local[1], 1, &events[1], &events[2]);
     err |= clEnqueueReadBuffer(queue, pulse, CL_TRUE, 0, R.range_count * sizeof(cl_float4), host_rcs, 1, &events[2], NULL);
 	if (err != CL_SUCCESS) {
@@ -626,6 +647,60 @@ int main(int argc, char **argv)
     }
 	printf("\n");
 	printf("Delta avg : %s%e%s\n", avg_delta / sqrtf(avg_square) < 1.0e-3 ? GREEN_COLOR : RED_COLOR, avg_delta, NO_COLOR);
+    
+    // Same sig and aux through the subgroup builds of the reductions, compared against the plain GPU pulse
+    int mismatch = 0;
+    const char *subgroup_extensions[] = {"cl_khr_subgroups", "cl_intel_subgroups"};
+    const char *subgroup_options[] = {"-DRS_USE_SUBGROUPS=1 -cl-std=CL2.0", "-DRS_USE_SUBGROUPS=2"};
+    size_t extensions_size = 0;
+    clGetDeviceInfo(devices[0], CL_DEVICE_EXTENSIONS, 0, NULL, &extensions_size);
+    char *extensions = (char *)malloc(extensions_size + 1);
+    extensions[0] = '\0';
+    clGetDeviceInfo(devices[0], CL_DEVICE_EXTENSIONS, extensions_size, extensions, NULL);
+    extensions[extensions_size] = '\0';
+    cl_float4 *sub_pulse = (cl_float4 *)malloc(R.range_count * sizeof(cl_float4));
+    for (int m = 0; m < 2; m++) {
+        if (!strstr(extensions, subgroup_extensions[m])) {
+            printf("Subgroups : %s not supported, skipped.\n", subgroup_extensions[m]);
+            continue;
+        }
+        cl_program sub_program = clCreateProgramWithSource(context, len, (const char **)src_ptr, NULL, &ret);
+        if (clBuildProgram(sub_program, 1, devices, subgroup_options[m], NULL, NULL) != CL_SUCCESS) {
+            char char_buf[RS_MAX_STR];
+            clGetProgramBuildInfo(sub_program, devices[0], CL_PROGRAM_BUILD_LOG, RS_MAX_STR, char_buf, NULL);
+            fprintf(stderr, "CL Compilation with %s failed:\n%s", subgroup_options[m], char_buf);
+            clReleaseProgram(sub_program);
+            mismatch++;
+            continue;
+        }
+        cl_kernel sub_pass_1 = clCreateKernel(sub_program, pass_1_dim == 2 ? "make_pulse_pass_1_tiled" : "make_pulse_pass_1", &ret);
+        cl_kernel sub_pass_2 = clCreateKernel(sub_program, pass_2_kernel_name(&R), &ret);
+        err = set_make_pulse_args(sub_pass_1, sub_pass_2, pass_1_dim, &R,
+                                  &work, &sig, &aux, &range_weight, &range_weight_desc, &pulse);
+        err |= clEnqueueNDRangeKernel(queue, sub_pass_1, pass_1_dim, NULL, pass_1_global, pass_1_local, 0, NULL, NULL);
+        err |= clEnqueueNDRangeKernel(queue, sub_pass_2, 1, NULL, &R.global[1], &R.local[1], 0, NULL, NULL);
+        err |= clEnqueueReadBuffer(queue, pulse, CL_TRUE, 0, R.range_count * sizeof(cl_float4), sub_pulse, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            fprintf(stderr, "Error: Failed to run the reductions built with %s.\n", subgroup_options[m]);
+            exit(EXIT_FAILURE);
+        }
+        // Only the order of the additions differs
+        float worst = 0.0f;
+        for (j=0; j<R.range_count; j++) {
+            for (int c4=0; c4<4; c4++) {
+                worst = MAX(worst, fabsf(sub_pulse[j].s[c4] - host_rcs[j].s[c4]) / MAX(1.0f, fabsf(host_rcs[j].s[c4])));
+            }
+        }
+        printf("Subgroups : %s%-35s  max delta %.1e%s\n", worst < 1.0e-4f ? GREEN_COLOR : RED_COLOR, subgroup_options[m], worst, NO_COLOR);
+        if (worst >= 1.0e-4f) {
+            mismatch++;
+        }
+        clReleaseKernel(sub_pass_1);
+        clReleaseKernel(sub_pass_2);
+        clReleaseProgram(sub_program);
+    }
+    free(sub_pulse);
+    free(extensions);
 	
     // Some speed test
     if (test & TEST_ALL) {
@@ -666,7 +741,7 @@ int main(int argc, char **argv)
 		if (test & TEST_GPU_PASS_1) {
 			gettimeofday(&t1, NULL);
 			for (k=0; k<speed_test_iterations; k++) {
-				clEnqueueNDRangeKernel(queue, kernel_make_pulse_pass_1, 1, NULL, &R.global[0], &R.local[0], 0, NULL, NULL);
+				clEnqueueNDRangeKernel(queue, kernel_make_pulse_pass_1, pass_1_dim, NULL, pass_1_global, pass_1_local, 0, NULL, NULL);
 			}
 			clFinish(queue);
 			gettimeofday(&t2, NULL);
@@ -757,5 +832,5 @@ int main(int argc, char **argv)
 	clReleaseProgram(program);
 	clReleaseContext(context);
 	
-	return 0;
+	return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -33,6 +33,19 @@ int main(int argc, const char **argv) {
     table = RCS_get_table(R, RCSConfigBrick);
     RCS_show_table_summary(table);
 
+    // A second request of the same table shares the data
+    RCSTable *other = RCS_get_table(R, RCSConfigBrick);
+    if (other->data.hh_real != table->data.hh_real || other->hash != table->hash) {
+        fprintf(stderr, "RCS table was not shared.\n");
+        return EXIT_FAILURE;
+    }
+    RCS_release_table(R, other);
+    if (table->data.hh_real == NULL) {
+        fprintf(stderr, "RCS table released while in use.\n");
+        return EXIT_FAILURE;
+    }
+    printf("\nShared RCS table %s  hash = 0x%08x\n", table->path, table->hash);
+
     RCS_free(R);
     
     return EXIT_SUCCESS;
@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include "rs.h"
+#include "rs_priv.h"
 
 enum {
 	TEST_N0NE                   = 0,
@@ -22,9 +23,12 @@ enum {
     TEST_BG_ATTS                = 1 << 10,
     TEST_EL_ATTS                = 1 << 11,
     TEST_DB_ATTS                = 1 << 12,
+    TEST_GATHER                 = 1 << 13,
+    TEST_PLACEMENT              = 1 << 14,
+    TEST_TRAJECTORY             = 1 << 15,
     TEST_KERNEL_MASK            = (TEST_BG_ATTS | TEST_EL_ATTS | TEST_DB_ATTS | TEST_SIG_AUX | TEST_MAKE_PULSE_GPU_PASS_1 | TEST_MAKE_PULSE_GPU_PASS_2),
-	TEST_GPU_SIMPLE             = (TEST_ADVANCE_TIME_GPU | TEST_MAKE_PULSE_GPU | TEST_DOWNLOAD | TEST_IO),
-	TEST_GPU_ALL                = (TEST_ADVANCE_TIME_GPU | TEST_MAKE_PULSE_GPU_PASS_1 | TEST_MAKE_PULSE_GPU_PASS_2 | TEST_DOWNLOAD | TEST_IO),
+	TEST_GPU_SIMPLE             = (TEST_ADVANCE_TIME_GPU | TEST_MAKE_PULSE_GPU | TEST_DOWNLOAD | TEST_IO | TEST_GATHER | TEST_PLACEMENT | TEST_TRAJECTORY),
+	TEST_GPU_ALL                = (TEST_ADVANCE_TIME_GPU | TEST_MAKE_PULSE_GPU_PASS_1 | TEST_MAKE_PULSE_GPU_PASS_2 | TEST_DOWNLOAD | TEST_IO | TEST_GATHER | TEST_PLACEMENT | TEST_TRAJECTORY),
 	TEST_CPU_ALL                = (TEST_ADVANCE_TIME_CPU | TEST_MAKE_PULSE_CPU),
 	TEST_ALL                    = (TEST_GPU_ALL | TEST_CPU_ALL)
 };
@@ -42,7 +46,7 @@ int main(int argc, char **argv)
 	
 	struct timeval t1, t2;
 	
-	while ((c = getopt(argc, argv, "vac012igdn:s:tkh?")) != -1) {
+	while ((c = getopt(argc, argv, "vac012igdrpjn:s:tkh?")) != -1) {
 		switch (c) {
             case 'v':
                 verb++;
@@ -71,6 +75,15 @@ int main(int argc, char **argv)
 			case 'c':
 				test |= TEST_MAKE_PULSE_CPU;
 				break;
+            case 'r':
+                test |= TEST_GATHER;
+                break;
+            case 'p':
+                test |= TEST_PLACEMENT;
+                break;
+            case 'j':
+                test |= TEST_TRAJECTORY;
+                break;
             case 't':
                 test |= TEST_DUMMY;
                 break;
@@ -92,6 +105,9 @@ int main(int argc, char **argv)
 					   "    -1     GPU Pass 1 test\n"
 					   "    -2     GPU Pass 2 test\n"
 					   "    -g     All GPU Tests\n"
+					   "    -r     Selective download test\n"
+					   "    -p     Importance-sampled placement test\n"
+					   "    -j     Trajectory recorder test\n"
 					   "    -v     increases verbosity\n"
 					   "    -n N   speed test using N iterations\n"
 					   "    -s S   speed test using scatter density S\n"
@@ -111,6 +127,7 @@ int main(int argc, char **argv)
 	int i;
 	double dt;
 	size_t byte_size;
+    int err = 0;
 	
     RSHandle *H = RS_init_verbose(verb);
 	if (H == NULL) {
@@ -202,7 +219,7 @@ int main(int argc, char **argv)
 	//
 	if (test & TEST_DOWNLOAD) {
         // Only range_count * H + V - IQ data
-        byte_size = 5 * H->num_scats * sizeof(cl_float4);
+        byte_size = 8 * H->num_scats * sizeof(cl_float4);
 		gettimeofday(&t1, NULL);
 		for (i=0; i<N; i++)
 			RS_download(H);
@@ -211,6 +228,187 @@ int main(int argc, char **argv)
 		printf(FMT2, "RS_download()", 1.0e3f * dt, 1.0e-9f * byte_size / dt);
 	}
 	
+    //
+    //  RS_download_type() and RS_download_uids() against a full download
+    //
+    if (test & TEST_GATHER) {
+        size_t j, k, n, count, mismatch = 0;
+        const size_t stride = 7;
+        RS_download(H);
+        count = RS_get_type_sample_count(H, 0, stride);
+        RSParticle *particles = (RSParticle *)malloc(count * sizeof(RSParticle));
+        RSParticle *picks = (RSParticle *)malloc(count * sizeof(RSParticle));
+        uint32_t *uids = (uint32_t *)malloc(count * sizeof(uint32_t));
+        n = RS_download_type(H, 0, stride, particles);
+        if (n != count) {
+            fprintf(stderr, "%s : RS_download_type() returned %zu of %zu particles.\n", now(), n, count);
+            mismatch++;
+        }
+        for (j = 0; j < n; j++) {
+            const int w = particles[j].uid.s3;
+            k = H->offset[w] + H->workers[w].origins[0] + particles[j].uid.s1;
+            if (particles[j].uid.s1 % stride || particles[j].uid.s1 >= H->workers[w].counts[0] ||
+                memcmp(&particles[j].pos, &H->scat_pos[k], sizeof(cl_float4)) ||
+                memcmp(&particles[j].vel, &H->scat_vel[k], sizeof(cl_float4)) ||
+                memcmp(&particles[j].ori, &H->scat_ori[k], sizeof(cl_float4))) {
+                mismatch++;
+            }
+        }
+        // Every third of the strided set in reverse order, then by uid
+        count = 0;
+        for (j = n; j > 0; j -= MIN(j, 3)) {
+            uids[count++] = particles[j - 1].uid.s0;
+        }
+        n = RS_download_uids(H, uids, count, picks);
+        for (j = 0; j < n; j++) {
+            const int w = picks[j].uid.s3;
+            k = H->offset[w] + H->workers[w].origins[picks[j].uid.s2] + picks[j].uid.s1;
+            if (picks[j].uid.s0 != uids[j] ||
+                memcmp(&picks[j].pos, &H->scat_pos[k], sizeof(cl_float4)) ||
+                memcmp(&picks[j].vel, &H->scat_vel[k], sizeof(cl_float4)) ||
+                memcmp(&picks[j].ori, &H->scat_ori[k], sizeof(cl_float4))) {
+                mismatch++;
+            }
+        }
+        printf("%30s  %s mismatch(es)\n", "RS_download_type/uids()", commaint(mismatch));
+        if (mismatch) {
+            err++;
+        }
+        free(particles);
+        free(picks);
+        free(uids);
+    }
+    
+    //
+    //  RS_placement_sample(): each drop carries w^2 = 1 / (N p) of its cell, so the sum of w^2 in every cell should
+    //  come out as the share of a uniform placement, M / N, within the counting noise 1 / sqrt(M p)
+    //
+    if (test & TEST_PLACEMENT) {
+        size_t j, m, mismatch = 0;
+        const RSSimulationConcept concept = H->sim_concept;
+        H->sim_concept |= RSSimulationConceptImportanceSampledPlacement;
+        RS_derive_placement(H);
+        if (H->placement == NULL) {
+            fprintf(stderr, "%s : No placement density to test.\n", now());
+            err++;
+        } else {
+            const int grid = H->placement_grid;
+            const size_t count = grid * grid * grid;
+            const size_t samples = 1000 * count;
+            double *sum = (double *)malloc(count * sizeof(double));
+            memset(sum, 0, count * sizeof(double));
+            RSVolume domain = RS_get_domain(H);
+            double mean = 0.0;
+            cl_float4 pos;
+            for (m = 0; m < samples; m++) {
+                RS_placement_sample(H, &pos);
+                int ix = MIN(grid - 1, (int)((pos.x - domain.origin.x) / domain.size.x * grid));
+                int iy = MIN(grid - 1, (int)((pos.y - domain.origin.y) / domain.size.y * grid));
+                int iz = MIN(grid - 1, (int)((pos.z - domain.origin.z) / domain.size.z * grid));
+                j = (iz * grid + iy) * grid + ix;
+                const double w2 = (double)H->placement[j].s1 * H->placement[j].s1;
+                sum[j] += w2;
+                mean += w2;
+            }
+            mean /= (double)samples;
+            for (j = 0; j < count; j++) {
+                const double p = H->placement[j].s0 - (j ? H->placement[j - 1].s0 : 0.0f);
+                const double ratio = sum[j] / ((double)samples / (double)count);
+                if (fabs(ratio - 1.0) > 5.0 / sqrt((double)samples * MAX(p, 1.0e-9))) {
+                    mismatch++;
+                }
+            }
+            printf("%30s  mean w^2 = %.4f   %s cell(s) off\n", "RS_placement_sample()", mean, commaint(mismatch));
+            if (fabs(mean - 1.0) > 0.01 || mismatch) {
+                err++;
+            }
+            free(sum);
+        }
+        free(H->placement);
+        H->placement = NULL;
+        H->placement_grid = 0;
+        H->sim_concept = concept;
+    }
+    
+    //
+    //  RS_start_trajectory_recorder(): a few drops and debris over a few steps, with a ring shallower than the
+    //  number of steps so that both a full drain and the remainder at stop are written, then read back
+    //
+    if (test & TEST_TRAJECTORY) {
+        size_t j, m, mismatch = 0;
+        const char *filename = "test_rs.trj";
+        const int depth = 2;
+        const int steps = 5;
+        uint32_t uids[8];
+        size_t count = 0;
+        for (j = 0; j < 4; j++) {
+            uids[count++] = RS_get_uid_base(H, 0, 0) + (uint32_t)(j * H->workers[0].counts[0] / 4);
+            if (H->num_types > 1) {
+                uids[count++] = RS_get_uid_base(H, 1, 0) + (uint32_t)(j * H->workers[0].counts[1] / 4);
+            }
+        }
+        if (RS_start_trajectory_recorder(H, filename, uids, count, depth)) {
+            fprintf(stderr, "%s : RS_start_trajectory_recorder() failed.\n", now());
+            err++;
+        } else {
+            for (i = 0; i < steps; i++) {
+                RS_advance_time(H);
+            }
+            RS_stop_trajectory_recorder(H);
+            RSTrajectoryFileHeader header;
+            uint32_t file_uids[8];
+            cl_float4 *frames = (cl_float4 *)malloc((steps + 1) * 3 * count * sizeof(cl_float4));
+            float stamps[steps + 1];
+            int frame_count = 0;
+            FILE *fid = fopen(filename, "rb");
+            if (fid == NULL ||
+                fread(&header, sizeof(RSTrajectoryFileHeader), 1, fid) != 1 ||
+                memcmp(header.magic, RS_TRAJECTORY_FILE_MAGIC, sizeof(header.magic)) ||
+                header.version != RS_TRAJECTORY_FILE_VERSION ||
+                header.count != count ||
+                fread(file_uids, sizeof(uint32_t), count, fid) != count) {
+                fprintf(stderr, "%s : Unable to read back the trajectory header.\n", now());
+                mismatch++;
+            } else {
+                // Frames list the particles worker by worker, so only check that the same set came back
+                for (j = 0; j < count; j++) {
+                    for (m = 0; m < count && uids[m] != file_uids[j]; m++) {}
+                    if (m == count) {
+                        mismatch++;
+                    }
+                }
+                while (frame_count <= steps &&
+                       fread(&stamps[frame_count], sizeof(float), 1, fid) == 1 &&
+                       fread(&frames[3 * count * frame_count], sizeof(cl_float4), 3 * count, fid) == 3 * count) {
+                    frame_count++;
+                }
+                if (frame_count != steps) {
+                    fprintf(stderr, "%s : Read %d trajectory frame(s) instead of %d.\n", now(), frame_count, steps);
+                    mismatch++;
+                }
+                for (i = 1; i < frame_count; i++) {
+                    if (stamps[i] <= stamps[i - 1]) {
+                        mismatch++;
+                    }
+                    for (j = 0; j < count; j++) {
+                        if (!memcmp(&frames[3 * (count * i + j)], &frames[3 * (count * (i - 1) + j)], sizeof(cl_float4))) {
+                            mismatch++;
+                        }
+                    }
+                }
+            }
+            if (fid) {
+                fclose(fid);
+            }
+            remove(filename);
+            free(frames);
+            printf("%30s  %d frame(s)   %s mismatch(es)\n", "RS_record_trajectory()", frame_count, commaint(mismatch));
+            if (mismatch) {
+                err++;
+            }
+        }
+    }
+    
     //
     //  Some kernels
     //
@@ -336,5 +534,5 @@ int main(int argc, char **argv)
 
     RS_free(H);
 
-	return EXIT_SUCCESS;
+	return err ? EXIT_FAILURE : EXIT_SUCCESS;
 }
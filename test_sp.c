@@ -0,0 +1,69 @@
+//
+//  test_sp.c
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sp.h"
+
+#define TEST_GATES      50
+#define TEST_FFT        64
+#define TEST_SEGMENTS   3
+
+// A tone per gate should land in its own bin with the total power preserved
+int main(int argc, const char **argv) {
+
+    printf("Testing Doppler spectrum processing ...\n");
+
+    int k, g, b;
+    float samples[TEST_GATES * 4];
+    SPBin *spectra = (SPBin *)malloc(TEST_GATES * TEST_FFT * sizeof(SPBin));
+
+    SPHandle P = SP_init(TEST_GATES, TEST_FFT, TEST_SEGMENTS, 0);
+    if (P == NULL || spectra == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    for (k = 0; k < 2 * TEST_FFT * TEST_SEGMENTS; k++) {
+        for (g = 0; g < TEST_GATES; g++) {
+            // Bin g is v = -va + 2 va g / n, phase per pulse of exp(-j k r) is -pi v / va
+            const float phi = -M_PI * (-1.0f + 2.0f * (float)(g % TEST_FFT) / TEST_FFT) * (float)k;
+            samples[4 * g]     = cosf(phi);
+            samples[4 * g + 1] = sinf(phi);
+            samples[4 * g + 2] = 0.5f * cosf(phi + 0.3f);
+            samples[4 * g + 3] = 0.5f * sinf(phi + 0.3f);
+        }
+        if (SP_add_pulse(P, samples) == SP_get_dwell(P)) {
+            SP_get_spectra(P, spectra);
+        }
+    }
+
+    for (g = 0; g < TEST_GATES; g++) {
+        int peak = 0;
+        float sh = 0.0f, sv = 0.0f;
+        for (b = 0; b < TEST_FFT; b++) {
+            const SPBin *s = &spectra[g * TEST_FFT + b];
+            sh += s->hh;
+            sv += s->vv;
+            if (s->hh > spectra[g * TEST_FFT + peak].hh) {
+                peak = b;
+            }
+        }
+        const SPBin *s = &spectra[g * TEST_FFT + peak];
+        if (g % 10 == 0) {
+            printf("gate %2d   peak bin %2d   sh = %.4f   sv = %.4f   phase = %.3f\n", g, peak, sh, sv, atan2f(s->hv_q, s->hv_i));
+        }
+        if (peak != g % TEST_FFT || fabsf(sh - 1.0f) > 1.0e-3f || fabsf(sv - 0.25f) > 1.0e-3f || fabsf(atan2f(s->hv_q, s->hv_i) - 0.3f) > 1.0e-3f) {
+            fprintf(stderr, "Gate %d mismatch.\n", g);
+            return EXIT_FAILURE;
+        }
+    }
+
+    SP_free(P);
+    free(spectra);
+
+    return EXIT_SUCCESS;
+}
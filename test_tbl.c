@@ -0,0 +1,76 @@
+//
+//  test_tbl.c
+//
+//  Created by Boon Leng Cheong.
+//  Copyright (c) 2016 Boon Leng Cheong. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "tbl.h"
+
+// Pack a small folder, then read it back through the shared bundle
+int main(int argc, const char **argv) {
+    
+    printf("Testing table bundle ...\n");
+    
+    char folder[] = "/tmp/test_tbl";
+    char bundle[] = "/tmp/test_tbl.srtb";
+    char path[1024];
+    float values[100];
+    int k;
+    
+    for (k = 0; k < 100; k++) {
+        values[k] = (float)k;
+    }
+    
+    snprintf(path, sizeof(path), "mkdir -p %s/adm %s/les/flat %s/_skip", folder, folder, folder);
+    if (system(path)) {
+        return EXIT_FAILURE;
+    }
+    const char *names[] = {"adm/plate.adm", "les/flat/fort.10_2", "_skip/table.adm", ".hidden"};
+    for (k = 0; k < 4; k++) {
+        snprintf(path, sizeof(path), "%s/%s", folder, names[k]);
+        FILE *fid = fopen(path, "w");
+        if (fid == NULL) {
+            return EXIT_FAILURE;
+        }
+        fwrite(values, sizeof(float), 10 * (k + 1), fid);
+        fclose(fid);
+    }
+    
+    if (TBL_pack(folder, bundle) || TBL_use_bundle(bundle)) {
+        return EXIT_FAILURE;
+    }
+    
+    TBLHandle T = TBL_shared();
+    printf("%u files\n", TBL_get_count(T));
+    if (TBL_get_count(T) != 2) {
+        fprintf(stderr, "Unexpected file count.\n");
+        return EXIT_FAILURE;
+    }
+    
+    long size = TBL_file_size(TBL_BUNDLE_ROOT "/les/flat/fort.10_2");
+    FILE *fid = TBL_fopen(TBL_BUNDLE_ROOT "/les/flat/fort.10_2");
+    if (size != 20 * sizeof(float) || fid == NULL) {
+        fprintf(stderr, "Unable to find a file in the bundle.\n");
+        return EXIT_FAILURE;
+    }
+    fseek(fid, 5 * sizeof(float), SEEK_SET);
+    fread(values, sizeof(float), 2, fid);
+    fclose(fid);
+    printf("values[5 ... 6] = %.1f %.1f\n", values[5], values[6]);
+    if (values[0] != 5.0f || values[1] != 6.0f) {
+        fprintf(stderr, "Unexpected content.\n");
+        return EXIT_FAILURE;
+    }
+    if (TBL_file_size(TBL_BUNDLE_ROOT "/_skip/table.adm") >= 0) {
+        fprintf(stderr, "Excluded file in the bundle.\n");
+        return EXIT_FAILURE;
+    }
+    
+    snprintf(path, sizeof(path), "rm -rf %s %s", folder, bundle);
+    system(path);
+    
+    return EXIT_SUCCESS;
+}
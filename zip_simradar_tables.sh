@@ -3,5 +3,8 @@
 echo "Compression files ..."
 zip -r tables.zip tables -x *.DS_Store -x .\* -x */_\*
 
+echo "Packing bundle ..."
+./tblpack tables tables.srtb
+
 echo "Uploading zip archive ..."
-scp -p tables.zip rwv01.arrc.nor.ou.edu:~/public_html/simradar/
+scp -p tables.zip tables.srtb rwv01.arrc.nor.ou.edu:~/public_html/simradar/